@@ -0,0 +1,23 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define BLOCK_DEVICE_BLOCK_SIZE 512
+
+
+// Storage addressed in fixed-size blocks from 0. Reads may cover part of a block, writes always
+// cover a whole one, which is the unit an SD card programs. Implementations report failures
+// through the return values and never retry on their own.
+class BlockDevice {
+public:
+    virtual ~BlockDevice() {}
+
+
+    virtual bool begin() = 0;
+    virtual uint32_t getBlockCount() = 0;
+
+    virtual bool read(uint32_t block, size_t offset, void* data, size_t length) = 0;
+    virtual bool write(uint32_t block, const void* data) = 0;
+};
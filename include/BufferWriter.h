@@ -0,0 +1,34 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+class BufferWriter {
+public:
+    BufferWriter(char* buffer, size_t size);
+    BufferWriter(char* buffer, size_t size, size_t offset);
+
+
+    void write(char c);
+    void write(const char* str);
+    void write(const uint8_t* data, size_t length);
+
+    void writeUnsigned(unsigned long value);
+    void writeSigned(long value);
+    void writeFixed(float value, uint8_t decimals);
+    void writeScaled(int32_t value, uint8_t scale, uint8_t decimals, bool trim = true);
+
+    size_t length();
+    size_t total();
+    bool overflow();
+private:
+    char* buffer;
+    size_t size;
+    size_t offset;
+    size_t position;
+    bool overflowed;
+
+
+    void writeDecimal(bool negative, unsigned long long fixed, uint8_t decimals, bool trim);
+};
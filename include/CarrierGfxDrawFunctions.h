@@ -2,10 +2,37 @@
 
 #include "Adafruit_ST7789.h"
 
+#include "CarrierGfxIcons.h"
+
+
+#define GFX_SPRITE_WIDTH_MAX 64
+#define GFX_SPRITE_BACKGROUND 0x0000
+
+
+struct GfxSprite {
+    const uint8_t* bitmap;      // 1 bit per pixel, MSB first, rows padded to a byte
+    uint8_t width;
+    uint8_t height;
+};
+
+// Pixels of a screen rectangle, row by row, rendered in memory before going out over SPI
+struct GfxBand {
+    uint16_t* pixels;
+    int x, y;
+    int width, rows;
+};
+
+
+extern const GfxSprite GFX_THERMOMETER_SPRITE;
+extern const GfxSprite GFX_DROPLET_SPRITE;
+extern const GfxSprite GFX_MOVEMENT_SPRITE;
+extern const GfxSprite GFX_ROTATION_SPRITE;
+extern const GfxSprite GFX_PRESSURE_SPRITE;
+
+
 void cleanDisplay(Adafruit_ST7789& display);
-void drawThermometerIcon(Adafruit_ST7789& display, int color, int x, int y);
-void drawDropletIcon(Adafruit_ST7789& display, int color, int x, int y);
-void drawMovementIcon(Adafruit_ST7789& display, int color, int x, int y);
-void drawRotationIcon(Adafruit_ST7789& display, int color, int x, int y);
-void drawPressureIcon(Adafruit_ST7789& display, int color, int x, int y);
+void drawSprite(Adafruit_ST7789& display, const GfxSprite& sprite, int color, int x, int y);
 void drawMessage(Adafruit_ST7789& display, const GFXfont *font, int x, int y, int color, String message);
+
+void renderSprite(GfxBand& band, const GfxSprite& sprite, int color, int x, int y);
+void renderMessage(GfxBand& band, const GFXfont* font, int x, int y, int color, const char* message, int screenWidth);
@@ -0,0 +1,51 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include <Adafruit_GFX.h>
+
+#include "CarrierGfxDrawFunctions.h"
+
+
+#define GFX_GLYPH_CACHE_CHARSET "0123456789-. "
+#define GFX_GLYPH_CACHE_CHARS (sizeof(GFX_GLYPH_CACHE_CHARSET) - 1)
+#define GFX_GLYPH_CACHE_POOL_BYTES 2048     // shared by all caches, FreeSans 18, 12 and 9 pt take ~1.8 KB
+
+
+// The characters of a numeric value, rasterized once from a GFXfont into fixed-size cells:
+// every cell is as wide as the widest advance and as tall as the charset's ascent plus descent,
+// with the glyph placed at its usual offset from the baseline. Each cell is a GfxSprite, so a
+// value is drawn as a row of opaque sprites and a changed character replaces exactly one cell.
+//
+// The bitmaps live in a static pool filled by begin(); a cache that did not fit is not ready.
+class CarrierGfxGlyphCache {
+public:
+    CarrierGfxGlyphCache(const GFXfont* font);
+
+
+    bool begin();
+    bool isReady() const;
+
+    const GFXfont* getFont() const;
+    const GfxSprite& getGlyph(char c) const;      // blank for characters outside the charset
+
+    uint8_t getCellWidth() const;
+    uint8_t getCellHeight() const;
+    int8_t getCellTop() const;                   // offset of the first row from the baseline
+private:
+    static uint8_t POOL[GFX_GLYPH_CACHE_POOL_BYTES];
+    static size_t POOL_USED;
+
+
+    const GFXfont* font;
+    GfxSprite glyphs[GFX_GLYPH_CACHE_CHARS];
+    bool ready;
+
+    uint8_t cellWidth;
+    uint8_t cellHeight;
+    int8_t cellTop;
+
+
+    void rasterize(char c, uint8_t* bitmap, size_t stride);
+};
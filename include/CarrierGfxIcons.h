@@ -0,0 +1,25 @@
+#pragma once
+
+// Generated by tools/generate_icons.py, do not edit
+
+
+#include <Arduino.h>
+
+
+#define GFX_THERMOMETER_WIDTH 31
+#define GFX_THERMOMETER_HEIGHT 61
+#define GFX_DROPLET_WIDTH 41
+#define GFX_DROPLET_HEIGHT 61
+#define GFX_MOVEMENT_WIDTH 61
+#define GFX_MOVEMENT_HEIGHT 61
+#define GFX_ROTATION_WIDTH 58
+#define GFX_ROTATION_HEIGHT 58
+#define GFX_PRESSURE_WIDTH 60
+#define GFX_PRESSURE_HEIGHT 60
+
+
+extern const uint8_t GFX_THERMOMETER_BITMAP[];
+extern const uint8_t GFX_DROPLET_BITMAP[];
+extern const uint8_t GFX_MOVEMENT_BITMAP[];
+extern const uint8_t GFX_ROTATION_BITMAP[];
+extern const uint8_t GFX_PRESSURE_BITMAP[];
@@ -0,0 +1,110 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7789.h>
+
+#include "CarrierGfxDrawFunctions.h"
+#include "CarrierGfxGlyphCache.h"
+
+
+#define GFX_SCREEN_WIDGETS_MAX 14
+#define GFX_SCREEN_TEXT_MAX 32
+#define GFX_SCREEN_BACKGROUND 0x0000
+#define GFX_SCREEN_OPS_MAX (2 * GFX_SCREEN_WIDGETS_MAX + 1)
+#define GFX_SCREEN_BAND_PIXELS 512      // per buffer, two buffers so one renders while the other is sent
+
+
+// Retained-mode model of the display: each frame declares its widgets in a fixed order, and
+// only the widgets that differ from the previous frame are erased and repainted. The screen is
+// cleared only when the page changes. A field is a value drawn in fixed-width glyph cells, when
+// only its characters change just the span of changed cells is repainted.
+//
+// endFrame() only queues the erase and paint operations. flush() draws them right away with the
+// blocking Adafruit_GFX primitives; flushAsync() renders them in bands of GFX_SCREEN_BAND_PIXELS
+// and sends each band with a single writePixels(). Built with USE_SPI_DMA a band goes out in the
+// background while the next one renders, and flushAsync() returns as soon as it is only waiting
+// on the transfer; the firmware envs leave it undefined, so there each band is a blocking write.
+// Either way flushAsync() returns once its time budget is spent.
+class CarrierGfxScreen {
+public:
+    CarrierGfxScreen(Adafruit_ST7789& display);
+
+
+    void beginFrame(int page);
+    void icon(const GfxSprite& sprite, int color, int x, int y);
+    void text(const GFXfont* font, int x, int y, int color, const String& text);
+    void field(const CarrierGfxGlyphCache& glyphs, int x, int y, int color, const char* value, int cells);
+    void endFrame();
+
+    void flush();
+    void flushAsync(unsigned long budgetUs);
+    bool isBusy();
+    void releaseBus();
+
+    void invalidate();
+private:
+    enum WidgetType {
+        WIDGET_NONE,
+        WIDGET_ICON,
+        WIDGET_TEXT,
+        WIDGET_FIELD
+    };
+
+    struct Widget {
+        WidgetType type;
+
+        const GfxSprite* sprite;
+        const GFXfont* font;
+        const CarrierGfxGlyphCache* glyphs;
+        int x, y;
+        int color;
+        char text[GFX_SCREEN_TEXT_MAX];     // a field's value, right-aligned in its cells
+        uint8_t cells;
+
+        int16_t boundsX, boundsY;
+        uint16_t boundsWidth, boundsHeight;
+    };
+
+    // A rectangle cleared to the background, then the widget painted in it unless it is -1
+    struct Operation {
+        int16_t x, y;
+        uint16_t width, height;
+        int8_t widget;
+    };
+
+
+    Adafruit_ST7789& display;
+
+    Widget widgets[GFX_SCREEN_WIDGETS_MAX];
+    Widget pending[GFX_SCREEN_WIDGETS_MAX];
+    size_t widgetCount;
+    size_t pendingCount;
+
+    int page;
+    int pendingPage;
+    bool valid;
+
+    Operation operations[GFX_SCREEN_OPS_MAX];
+    size_t operationCount;
+    size_t operationIndex;
+    uint16_t operationRow;      // first row of the current operation not rendered yet
+
+    uint16_t bands[2][GFX_SCREEN_BAND_PIXELS];
+    GfxBand band;               // rendered and waiting to be sent
+    uint8_t bandBuffer;         // the buffer the next band renders into
+    bool bandReady;
+    bool transferring;
+
+
+    Widget* nextWidget(WidgetType type);
+    bool sameWidget(const Widget& a, const Widget& b);
+    bool sameField(const Widget& a, const Widget& b);
+    void queue(int x, int y, int width, int height, int widget);
+    void drawField(const Widget& widget, const Operation& operation);
+    void renderBand();
+    void sendBand();
+    void finishTransfer();
+};
@@ -5,6 +5,17 @@
 
 #include <Arduino_MKRIoTCarrier.h>
 
+#include "CarrierGfxGlyphCache.h"
+#include "CarrierGfxScreen.h"
+#include "InputEventQueue.h"
+#include "LSM6DS3Fifo.h"
+#include "MahonyFilter.h"
+#include "SdFileBlockDevice.h"
+#include "SensorHistory.h"
+#include "SensorLog.h"
+#include "SensorScheduler.h"
+#include "SensorSnapshot.h"
+
 
 class CarrierManager {
 public:
@@ -21,14 +32,24 @@ public:
         bool enabled;
     };
 
+    struct LSM6DS3_AxisStatistics {
+        float mean, min, max, rms;
+    };
+
+    struct LSM6DS3_WindowStatistics {
+        LSM6DS3_AxisStatistics x, y, z;
+    };
+
     struct LSM6DS3_GyroscopeSensor {
         float x, y, z;
+        LSM6DS3_WindowStatistics statistics;
 
         bool enabled;
     };
 
     struct LSM6DS3_AccelerometerSensor {
         float x, y, z;
+        LSM6DS3_WindowStatistics statistics;
 
         bool enabled;
     };
@@ -36,6 +57,17 @@ public:
     struct LSM6DS3_IMUSensor {
         LSM6DS3_GyroscopeSensor gyroscope;
         LSM6DS3_AccelerometerSensor accelerometer;
+
+        unsigned int windowSamples;     // 1 without the FIFO
+        bool overrun;                   // samples were lost during the last window
+        bool fifo;
+    };
+
+    struct LSM6DS3_Orientation {
+        float qw, qx, qy, qz;
+        float roll, pitch, yaw;     // rad
+
+        bool enabled;
     };
 
     struct APDS9960_RGBSensor {
@@ -55,8 +87,14 @@ public:
         APDS9960_GestureSensor gesture;
     };
 
+    typedef void (*SensorsUpdateHook)();
+    typedef void (*InputEventHook)(const InputEvent& event);
+
+
     static int setCase(bool useCase);
     static int setPIR(bool usePIR);
+    static int setIMUFifo(bool useFifo);
+    static int setSensorLog(bool useLog);
     static unsigned long setSensorsUpdateTimeout(unsigned long timeout);
 
 
@@ -67,10 +105,28 @@ public:
     void begin();
     void loop();
 
+    void sensorsLoop();
+    void inputsLoop();
+    void gfxLoop();
+    void logLoop();
+
     HTS221_EnvironmentSensors getEnvironmentSensor();
     LPS22HB_PressureSensor getPressureSensor();
     LSM6DS3_IMUSensor getIMUSensor();
+    LSM6DS3_Orientation getOrientation();
     APDS9960_LightSensor getLightSensor();
+
+    SensorHistory& getHistory();
+    const SensorSnapshotBuffer& getSnapshots();
+
+    const SensorLog& getSensorLog();
+    void seekSensorLog(SensorLog::Cursor& cursor, uint32_t time);
+    bool nextSensorLog(SensorLog::Cursor& cursor, SensorLogRecord& record);
+    void setSensorLogTime(uint32_t time);
+
+    unsigned long getSensorGeneration(int group);
+    unsigned long getSensorUpdateMs(int group);
+    unsigned long getSensorTimeUntilUpdate(int group);
     
     Adafruit_ST7789& getDisplay();
 
@@ -81,28 +137,63 @@ public:
     void enableAccelerometerSensorUpdates(bool enable = true);
     void enableRGBSensorUpdates(bool enable = true);
     void enableGestureSensorUpdates(bool enable = true);
+    void enableOrientationUpdates(bool enable = true);
+
+    void setSensorPeriod(SensorGroup group, unsigned long period);
+
+    void setSensorsUpdateHook(SensorsUpdateHook hook);
+    void setInputEventHook(InputEventHook hook);
+    unsigned long getDroppedInputEvents();
 
     void setMessage(String msg);
     String getMessage();
 private:
     static int CASE;     // 0 = false, >0 = true, <0 = already started, cannot change
     static int PIR;      // 0 = false, >0 = true, <0 = already started, cannot change
+    static int IMU_FIFO; // 0 = false, >0 = true, <0 = already started, cannot change
+    static int LOG;      // 0 = false, >0 = true, <0 = already started, cannot change
     static unsigned long SENSORS_UPDATE_TIMEOUT_MS;
+    static InputEventQueue INTERRUPT_EVENTS;    // filled by the interrupt handlers, drained by inputsLoop()
+    static int PIR_PIN;
 
 
     MKRIoTCarrier carrier;
+    CarrierGfxScreen screen;
+    CarrierGfxGlyphCache glyphs18;
+    CarrierGfxGlyphCache glyphs12;
+    CarrierGfxGlyphCache glyphs9;
 
     HTS221_EnvironmentSensors environment;
     LPS22HB_PressureSensor pressure;
     LSM6DS3_IMUSensor imu;
+    LSM6DS3Fifo imuFifo;
+    unsigned long imuWindowStartMs;
+    MahonyFilter orientationFilter;
+    unsigned long orientationUpdateMs;
+    unsigned long orientationSetTicks;      // ms × LSM6DS3_FIFO_RATE_HZ of FIFO sets not integrated yet
+    bool orientationEnabled;
     APDS9960_LightSensor light;
+    SensorHistory history;
+    unsigned long lastHistoryMs;
+    SensorSnapshotBuffer snapshots;
+    SdFileBlockDevice logDevice;
+    SensorLog sensorLog;
+    unsigned long lastLogMs;
     String message;
 
     int lastLoopFunction;
     int selectedFunction;
+    int lastLedsFunction;
 
     long lastSensorsUpdateMs;
     bool lastSensorsUpdateDrawn;
+    unsigned long lastGfxUpdateMs;
+    SensorScheduler sensorScheduler;
+    unsigned long sensorsGeneration;
+    unsigned long sensorGenerations[SENSOR_GROUP_COUNT];
+    unsigned long sensorUpdateMs[SENSOR_GROUP_COUNT];
+    SensorsUpdateHook sensorsUpdateHook;
+    InputEventHook inputEventHook;
 
 
     void gfxInit();
@@ -111,11 +202,24 @@ private:
     void buttonsInit();
     void buttonsUpdate();
 
+    void inputEventsInit();
+    void inputEventsUpdate();
+    void inputEvent(const InputEvent& event);
+    static void pirInterrupt();
+    static void gestureInterrupt();
+
     void ledsInit();
     void ledsUpdate();
 
     void sensorsInit();
-    void sensorsUpdate();
+    bool sensorsUpdate(int group);
+    void historyUpdate(unsigned long now);
+    bool sensorGroupEnabled(int group);
+    int sensorGroupSource(int group);
+    void publishSnapshot();
+    bool imuFifoUpdate();
+    void orientationUpdate();
+    static void orientationSet(const int16_t set[LSM6DS3_FIFO_AXES], void* context);
 
     void closeRelays();
 };
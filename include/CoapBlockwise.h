@@ -0,0 +1,37 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include <coap-simple.h>
+
+#include "BufferWriter.h"
+#include "CoapMessage.h"
+
+
+#define COAP_BLOCK_SZX_MAX 3        // 128 byte blocks, fits the message buffer with headroom for options
+#define COAP_BLOCK_SIZE(szx) (1 << ((szx) + 4))
+#define COAP_BLOCK_SZX_RESERVED 7
+#define COAP_BLOCK_NUM_MAX 0xFFFFFUL    // 20 bits in a 3 byte option (RFC 7959 §2.2)
+#define COAP_BLOCK_OPTION_LENGTH_MAX 3
+
+
+typedef void (*CoapBlockGenerator)(BufferWriter& writer, const void* context);
+
+struct CoapBlock {
+    unsigned long num;
+    uint8_t szx;
+    bool requested;
+};
+
+struct CoapBytes {
+    const char* data;
+    size_t length;
+};
+
+
+bool coapBlockValid(const CoapPacket& packet);
+CoapBlock coapRequestedBlock(const CoapPacket& packet);
+bool coapWriteBlock(CoapMessage& message, CoapBlock block, CoapBlockGenerator generator, const void* context);
+
+void coapWriteBytes(BufferWriter& writer, const void* context);
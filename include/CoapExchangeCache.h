@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#include "CoapMessage.h"
+
+
+#define COAP_EXCHANGE_CACHE_SIZE 4
+#define COAP_EXCHANGE_RESPONSE_MAX COAP_MESSAGE_BUFFER_SIZE
+#define COAP_EXCHANGE_LIFETIME_MS 247000UL     // EXCHANGE_LIFETIME with the default transmission parameters
+
+
+// Responses to recent confirmable requests, keyed by endpoint and message ID, so that a
+// retransmitted request is answered with the same bytes instead of running the handler
+// again (RFC 7252 §4.5). When full, the oldest exchange makes room for the new one.
+class CoapExchangeCache {
+public:
+    CoapExchangeCache();
+
+
+    const uint8_t* find(IPAddress ip, int port, uint16_t messageId, unsigned long now, size_t& length);
+    void store(IPAddress ip, int port, uint16_t messageId, const uint8_t* response, size_t length, unsigned long now);
+private:
+    struct Exchange {
+        IPAddress ip;
+        int port;
+        uint16_t messageId;
+        unsigned long time;
+
+        uint8_t response[COAP_EXCHANGE_RESPONSE_MAX];
+        size_t length;
+
+        bool active;
+    };
+
+    Exchange exchanges[COAP_EXCHANGE_CACHE_SIZE];
+};
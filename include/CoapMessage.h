@@ -0,0 +1,50 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <Udp.h>
+
+#include <coap-simple.h>
+
+
+#define COAP_MESSAGE_BUFFER_SIZE 256
+#define COAP_MESSAGE_VERSION 1
+
+
+// Messages are built in one shared static buffer, so only one can be under construction at a time
+class CoapMessage {
+public:
+    static uint16_t nextMessageId();
+    static unsigned long sentCount();
+    static const uint8_t* lastSent(size_t& length);
+
+
+    CoapMessage(uint8_t type, uint8_t code, uint16_t messageId, const uint8_t* token, uint8_t tokenLength);
+
+
+    void setCode(uint8_t code);
+    void addOption(uint16_t number, const uint8_t* value, size_t length);
+    void addUintOption(uint16_t number, unsigned long value);
+    void addETagOption(uint32_t etag);
+    void setPayload(const uint8_t* payload, size_t length);
+
+    const uint8_t* data();
+    size_t length();
+    bool overflow();
+
+    bool send(UDP& udp, IPAddress ip, int port);
+private:
+    static uint8_t BUFFER[COAP_MESSAGE_BUFFER_SIZE];
+    static uint16_t MESSAGE_ID;
+    static unsigned long SENT_COUNT;
+    static size_t SENT_LENGTH;
+
+
+    size_t position;
+    uint16_t lastOption;
+    bool overflowed;
+
+
+    void write(uint8_t value);
+    void writeOptionNibble(uint16_t value, uint8_t& nibble, uint8_t* extended, size_t& extendedLength);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#include "SenMLWriter.h"
+
+
+#define COAP_OBSERVERS_MAX 8
+#define COAP_OBSERVERS_TOKEN_MAX 8
+#define COAP_OBSERVE_SEQUENCE_MASK 0xFFFFFF
+#define COAP_OBSERVE_CON_INTERVAL_MS 600000UL   // RFC 7641 §4.5 asks for at least one a day
+#define COAP_OBSERVE_ACK_TIMEOUT_MS 2000        // ACK_TIMEOUT (RFC 7252 §4.8), doubled per retransmission
+#define COAP_OBSERVE_MAX_RETRANSMIT 4
+
+
+// Observers of the sensor and event resources. Notifications are NON, except that every
+// COAP_OBSERVE_CON_INTERVAL_MS one goes out as CON and is retransmitted until acknowledged:
+// an observer that answers none of them, or answers with RST, is dropped, so clients that
+// went away without deregistering do not hold their slot forever.
+class CoapObservers {
+public:
+    struct Observer {
+        IPAddress ip;
+        int port;
+        uint8_t token[COAP_OBSERVERS_TOKEN_MAX];
+        uint8_t tokenLength;
+
+        uint8_t resource;
+        SenMLFormat format;
+
+        uint16_t messageId;         // of the last notification, matched against a client ACK or RST
+        unsigned long confirmedMs;  // millis() of the registration or the last acknowledged CON
+        unsigned long sentMs;       // millis() of the last transmission of the pending CON
+        uint8_t retransmissions;
+        bool confirming;            // a CON notification waits for its ACK
+        bool active;
+    };
+
+
+    CoapObservers();
+
+
+    bool add(uint8_t resource, IPAddress ip, int port, const uint8_t* token, uint8_t tokenLength, SenMLFormat format, unsigned long now);
+    void remove(uint8_t resource, IPAddress ip, int port);
+    void removeRejected(IPAddress ip, int port, uint16_t messageId);
+
+    uint8_t notificationType(const Observer& observer, unsigned long now);
+    void notified(Observer& observer, uint8_t type, unsigned long now);
+    void acknowledged(IPAddress ip, int port, uint16_t messageId, unsigned long now);
+    bool retransmissionDue(Observer& observer, unsigned long now);
+    void retransmitted(Observer& observer, unsigned long now);
+
+    bool observed(uint8_t resource);
+
+    size_t capacity();
+    Observer& get(size_t index);
+private:
+    Observer observers[COAP_OBSERVERS_MAX];
+
+
+    Observer* find(uint8_t resource, IPAddress ip, int port);
+};
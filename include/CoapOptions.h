@@ -0,0 +1,39 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include <coap-simple.h>
+
+
+#define COAP_OPTION_ETAG 4
+#define COAP_OPTION_OBSERVE 6
+#define COAP_OPTION_URI_PATH 11
+#define COAP_OPTION_CONTENT_FORMAT 12
+#define COAP_OPTION_MAX_AGE 14
+#define COAP_OPTION_URI_QUERY 15
+#define COAP_OPTION_ACCEPT 17
+#define COAP_OPTION_BLOCK2 23
+#define COAP_OPTION_SIZE2 28
+
+#define COAP_ETAG_LENGTH 4
+
+#define COAP_OBSERVE_REGISTER 0
+#define COAP_OBSERVE_DEREGISTER 1
+
+// coap-simple spells these COAP_NOT_FOUNT, COAP_METHOD_NOT_ALLOWD and COAP_SERVICE_UNAVALIABLE
+#define COAP_CODE(class, detail) (((class) << 5) | (detail))
+#define COAP_CODE_NOT_FOUND COAP_CODE(4, 4)
+#define COAP_CODE_METHOD_NOT_ALLOWED COAP_CODE(4, 5)
+#define COAP_CODE_SERVICE_UNAVAILABLE COAP_CODE(5, 3)
+
+// Not in coap-simple
+#define COAP_CODE_REQUEST_ENTITY_INCOMPLETE COAP_CODE(4, 8)
+
+#define COAP_CONTENT_FORMAT_SENML_JSON 110
+#define COAP_CONTENT_FORMAT_SENML_CBOR 112
+
+
+const CoapOption* coapFindOption(const CoapPacket& packet, uint8_t number);
+unsigned long coapOptionUint(const CoapOption& option);
+bool coapETagMatches(const CoapPacket& packet, uint32_t etag);
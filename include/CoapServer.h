@@ -0,0 +1,63 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <Udp.h>
+
+#include <coap-simple.h>
+
+#include "CoapExchangeCache.h"
+
+
+#define COAP_SERVER_BUFFER_SIZE 256
+#define COAP_SERVER_PATH_MAX 48
+#define COAP_SERVER_DRAIN_PACKETS 4
+#define COAP_SERVER_DRAIN_BUDGET_US 3000
+
+#define COAP_PATH_HASH_BASIS 2166136261u
+#define COAP_PATH_HASH_PRIME 16777619u
+
+
+// FNV-1a over the joined Uri-Path, usable in case labels; the basis is offset by a
+// seed so a resource table can pick one that keeps its paths in distinct slots
+constexpr uint32_t coapPathHash(const char* path, uint32_t hash = COAP_PATH_HASH_BASIS) {
+    return *path == '\0' ? hash : coapPathHash(path + 1, (hash ^ (uint8_t) *path) * COAP_PATH_HASH_PRIME);
+}
+
+
+// Receive side of the CoAP endpoint: parses one datagram into a CoapPacket and hands
+// requests to a single dispatcher with the Uri-Path already joined, e.g. "diag/tasks".
+// Pings and malformed confirmables are answered with RST, resets and ACKs go to their
+// handlers, retransmitted confirmables get the cached response of the first transmission.
+class CoapServer {
+public:
+    typedef void (*Dispatcher)(CoapPacket& packet, const char* path, IPAddress ip, int port);
+    typedef void (*ResetHandler)(IPAddress ip, int port, uint16_t messageId);
+    typedef void (*AckHandler)(IPAddress ip, int port, uint16_t messageId);
+
+
+    CoapServer(UDP& udp);
+
+
+    void setDispatcher(Dispatcher dispatcher);
+    void setResetHandler(ResetHandler handler);
+    void setAckHandler(AckHandler handler);
+
+    size_t loop(size_t maxPackets = COAP_SERVER_DRAIN_PACKETS, unsigned long budgetUs = COAP_SERVER_DRAIN_BUDGET_US);
+
+    static bool parse(uint8_t* data, size_t length, CoapPacket& packet);
+    static bool joinPath(const CoapPacket& packet, char* path, size_t size);
+private:
+    static uint8_t BUFFER[COAP_SERVER_BUFFER_SIZE];
+
+
+    UDP& udp;
+    Dispatcher dispatcher;
+    ResetHandler resetHandler;
+    AckHandler ackHandler;
+    CoapExchangeCache exchanges;
+
+
+    bool receive();
+    void sendReset(uint16_t messageId, IPAddress ip, int port);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define INPUT_EVENT_QUEUE_SIZE 32           // power of two
+
+
+enum InputEventType {
+    INPUT_EVENT_TOUCH,                      // value is the pad that went down
+    INPUT_EVENT_MOTION,                     // value is the PIR output, 1 when motion starts
+    INPUT_EVENT_GESTURE,                    // value is the APDS9960 gesture
+    INPUT_EVENT_GESTURE_PENDING             // the APDS9960 raised its interrupt, read it outside the ISR
+};
+
+struct InputEvent {
+    unsigned long time;                     // millis()
+    uint8_t type;
+    int8_t value;
+};
+
+
+// Fixed-size ring with one producer and one consumer, typically an interrupt handler and the
+// main loop. Each side only writes its own index, so neither needs to mask interrupts. A push
+// into a full ring is refused and counted, the events already queued are never overwritten.
+class InputEventQueue {
+public:
+    InputEventQueue();
+
+
+    bool push(const InputEvent& event);
+    bool pop(InputEvent& event);
+
+    size_t size() const;
+    unsigned long getDropped() const;
+private:
+    InputEvent events[INPUT_EVENT_QUEUE_SIZE];
+
+    volatile uint32_t head;                 // next slot to write, producer side
+    volatile uint32_t tail;                 // next slot to read, consumer side
+    volatile unsigned long dropped;
+};
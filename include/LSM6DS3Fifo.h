@@ -0,0 +1,74 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <Wire.h>
+
+
+#define LSM6DS3_FIFO_ADDRESS 0x6A
+#define LSM6DS3_FIFO_AXES 6                 // gyroscope x, y, z then accelerometer x, y, z
+#define LSM6DS3_FIFO_CHUNK_SETS 8           // 96 bytes per I2C transfer, below the Wire buffer size
+#define LSM6DS3_FIFO_BURST_SETS 64          // upper bound of sets drained per call
+#define LSM6DS3_FIFO_RATE_HZ 104
+
+#define LSM6DS3_FIFO_AXIS_GX 0
+#define LSM6DS3_FIFO_AXIS_GY 1
+#define LSM6DS3_FIFO_AXIS_GZ 2
+#define LSM6DS3_FIFO_AXIS_AX 3
+#define LSM6DS3_FIFO_AXIS_AY 4
+#define LSM6DS3_FIFO_AXIS_AZ 5
+
+
+// Runs the LSM6DS3 at 416 Hz with the FIFO sampling at 104 Hz in continuous mode, and drains
+// it in bursts into integer per-axis window statistics. Only the LSM6DS3 (carrier revision 1)
+// has this FIFO layout: begin() fails on the LSM6DSOX and callers keep single-sample reads.
+class LSM6DS3Fifo {
+public:
+    struct Window {
+        uint16_t samples;
+
+        int16_t min[LSM6DS3_FIFO_AXES];
+        int16_t max[LSM6DS3_FIFO_AXES];
+        int32_t sum[LSM6DS3_FIFO_AXES];
+        uint64_t sumSquares[LSM6DS3_FIFO_AXES];
+    };
+
+    // Gets every set drained, gyroscope then accelerometer in LSB, before it joins the window
+    typedef void (*SetHook)(const int16_t set[LSM6DS3_FIFO_AXES], void* context);
+
+    static const float ACCELEROMETER_SCALE;     // g per LSB at ±4 g
+    static const float GYROSCOPE_SCALE;         // dps per LSB at ±2000 dps
+
+
+    LSM6DS3Fifo(TwoWire& wire);
+
+
+    bool begin();
+    void end();
+    bool active();
+
+    size_t drain();
+    bool overrun();
+    void setSetHook(SetHook hook, void* context);
+
+    Window& getWindow();
+    void resetWindow();
+
+    static int16_t mean(const Window& window, int axis);
+    static uint16_t rms(const Window& window, int axis);
+private:
+    TwoWire& wire;
+    bool started;
+    bool overrunDetected;
+
+    Window window;
+    SetHook setHook;
+    void* setHookContext;
+
+
+    bool readRegisters(uint8_t reg, uint8_t* data, size_t length);
+    bool writeRegister(uint8_t reg, uint8_t value);
+    void accumulate(const int16_t* set);
+
+    static uint32_t isqrt(uint32_t value);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define MAHONY_Q30_ONE (1L << 30)
+#define MAHONY_Q16_ONE (1L << 16)
+
+#define MAHONY_DEFAULT_KP 1.0
+#define MAHONY_DEFAULT_KI 0.0
+#define MAHONY_DT_MAX_MS 1000           // longer gaps are integrated as one second
+#define MAHONY_STEP_MAX_MS 50           // keeps the half rotation angle of a step inside Q30
+
+
+// Mahony complementary filter (accelerometer + gyroscope) in fixed point, the SAMD21 has
+// no FPU. The quaternion and the unit vectors are Q30, rates and gains Q16, the time step
+// and the integral term Q24; floats are
+// only used to convert the inputs and, on demand, the outputs.
+class MahonyFilter {
+public:
+    struct Quaternion {
+        int32_t w, x, y, z;     // Q30
+    };
+
+
+    MahonyFilter();
+
+
+    void setGains(float kp, float ki);
+    void reset();
+
+    void update(float gx, float gy, float gz, float ax, float ay, float az, unsigned long dtMs);
+    void updateFixed(const int32_t gyro[3], const int32_t accel[3], unsigned long dtMs);
+
+    const Quaternion& getQuaternion();
+    void getQuaternion(float& w, float& x, float& y, float& z);
+    void getEuler(float& roll, float& pitch, float& yaw);
+private:
+    Quaternion q;
+    int32_t integral[3];        // Q24 rad/s
+
+    int32_t kp;                 // Q16
+    int32_t ki;                 // Q16
+
+
+    void step(const int32_t gyro[3], const int32_t accel[3], unsigned long dtMs);
+
+    static int32_t mulQ30(int32_t a, int32_t b);
+    static uint32_t isqrt64(uint64_t value);
+};
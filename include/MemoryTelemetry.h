@@ -0,0 +1,65 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define MEMORY_STACK_PAINT 0xC5
+#define MEMORY_STACK_PAINT_MARGIN 64        // bytes left unpainted below the painting frame
+
+
+enum MemorySubsystem {
+    MEMORY_SUBSYSTEM_CORE,
+    MEMORY_SUBSYSTEM_SENSORS,
+    MEMORY_SUBSYSTEM_GFX,
+    MEMORY_SUBSYSTEM_WIFI,
+    MEMORY_SUBSYSTEM_COAP,
+    MEMORY_SUBSYSTEM_COUNT
+};
+
+
+// Heap, stack and fragmentation figures. Allocations are attributed to the subsystem of the
+// enclosing MEMORY_SCOPE() through the malloc/realloc/free wrappers, which the build links
+// in with -Wl,--wrap=malloc,--wrap=realloc,--wrap=free. Outside the SAMD21 every figure is 0.
+class MemoryTelemetry {
+public:
+    struct Snapshot {
+        uint32_t heapUsed;          // bytes handed out by malloc
+        uint32_t heapPeak;
+        uint32_t heapFree;          // bytes on the free list
+        uint32_t heapLargestFree;   // largest free list chunk
+        uint32_t heapArena;         // bytes taken from sbrk
+        uint32_t gap;               // between the heap end and the deepest stack frame seen
+
+        uint32_t stackUsed;         // high-water mark from the painted area
+
+        uint32_t allocations[MEMORY_SUBSYSTEM_COUNT];
+        uint32_t frees;
+        uint32_t failures;
+    };
+
+    static const char* const SUBSYSTEM_NAMES[MEMORY_SUBSYSTEM_COUNT];
+
+
+    static void paintStack();
+    static void read(Snapshot& snapshot);
+    static void dump(Print& output);
+
+    static int enter(int subsystem);
+    static void leave(int previous);
+};
+
+
+// Attributes the allocations of the enclosing block
+class MemoryScope {
+public:
+    MemoryScope(int subsystem);
+    ~MemoryScope();
+private:
+    int previous;
+};
+
+
+#define MEMORY_CONCAT_(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_(a, b)
+#define MEMORY_SCOPE(subsystem) MemoryScope MEMORY_CONCAT(memoryScope, __LINE__)(subsystem)
@@ -0,0 +1,79 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define PROFILER_BUCKETS 32                 // bucket b holds durations of [2^(b-1), 2^b) cycles
+#define PROFILER_CYCLES_PER_US (F_CPU / 1000000)
+
+
+enum ProfilerPhase {
+    PROFILE_PHASE_SENSORS,
+    PROFILE_PHASE_BUTTONS,
+    PROFILE_PHASE_LEDS,
+    PROFILE_PHASE_GFX,
+    PROFILE_PHASE_WIFI,
+    PROFILE_PHASE_COAP,
+    PROFILE_PHASE_LOG,
+    PROFILE_PHASE_COUNT
+};
+
+
+uint32_t profilerCycles();
+
+
+// Per-phase log2 histograms of durations in CPU cycles. Only built with -DPROFILE_ENABLED:
+// otherwise PROFILE_SCOPE() expands to nothing and no profiler exists.
+class Profiler {
+public:
+    struct Histogram {
+        uint32_t buckets[PROFILER_BUCKETS];
+
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+    };
+
+
+    static const char* const PHASE_NAMES[PROFILE_PHASE_COUNT];
+
+
+    Profiler();
+
+
+    void record(int phase, uint32_t cycles);
+    void reset();
+
+    const Histogram& getHistogram(int phase);
+
+    static uint32_t percentile(const Histogram& histogram, uint8_t percent);
+private:
+    Histogram histograms[PROFILE_PHASE_COUNT];
+};
+
+
+// Times the enclosing block
+class ProfilerScope {
+public:
+    ProfilerScope(int phase);
+    ~ProfilerScope();
+private:
+    int phase;
+    uint32_t start;
+};
+
+
+#ifdef PROFILE_ENABLED
+
+extern Profiler profiler;
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(phase) ProfilerScope PROFILE_CONCAT(profilerScope, __LINE__)(phase)
+
+#else
+
+#define PROFILE_SCOPE(phase)
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "BlockDevice.h"
+
+
+// Blocks stored in one file on the SD card, so the card keeps its FAT filesystem and
+// stays readable on a PC. The file grows as blocks are first written, up to the fixed
+// block count; reading a block that was never written fails.
+class SdFileBlockDevice : public BlockDevice {
+public:
+    SdFileBlockDevice(const char* path, uint32_t blocks, uint8_t chipSelect);
+
+
+    bool begin();
+    uint32_t getBlockCount();
+
+    bool read(uint32_t block, size_t offset, void* data, size_t length);
+    bool write(uint32_t block, const void* data);
+private:
+    const char* path;
+    uint32_t blocks;
+    uint8_t chipSelect;
+
+    File file;
+    bool ready;
+};
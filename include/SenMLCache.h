@@ -0,0 +1,48 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include "SenMLWriter.h"
+
+
+class CarrierManager;
+
+
+#define SENML_CACHE_JSON_BUFFER_SIZE 192
+#define SENML_CACHE_CBOR_BUFFER_SIZE 128
+
+
+class SenMLCache {
+public:
+    typedef size_t (*Encoder)(CarrierManager& carrier, SenMLFormat format, char* buffer, size_t size);
+
+
+    SenMLCache(Encoder encoder);
+
+
+    const char* get(CarrierManager& carrier, unsigned long generation, SenMLFormat format, size_t& length);
+    void invalidate();
+
+    static unsigned long getFailures();
+private:
+    struct Entry {
+        char* buffer;
+        size_t size;
+        size_t length;
+
+        unsigned long generation;
+        bool valid;
+    };
+
+    static unsigned long FAILURES;
+
+
+    Encoder encoder;
+
+    char jsonBuffer[SENML_CACHE_JSON_BUFFER_SIZE];
+    char cborBuffer[SENML_CACHE_CBOR_BUFFER_SIZE];
+
+    Entry json;
+    Entry cbor;
+};
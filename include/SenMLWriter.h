@@ -0,0 +1,56 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include "BufferWriter.h"
+
+
+enum SenMLFormat {
+    SENML_FORMAT_JSON,
+    SENML_FORMAT_CBOR
+};
+
+struct SenMLRecord {
+    const char* name;
+    const char* unit;       // NULL when the record has no unit
+    uint8_t decimals;
+};
+
+
+// Streams a pack record by record, so packs of any length can be produced block-wise
+class SenMLPackWriter {
+public:
+    SenMLPackWriter(BufferWriter& writer, SenMLFormat format);
+
+
+    void begin(const char* baseName, unsigned long baseTime, float baseVersion, size_t count);
+    void record(const SenMLRecord& record, float value);
+    void record(const SenMLRecord& record, float value, long time);
+    void recordFixed(const SenMLRecord& record, int32_t value, uint8_t scale);
+    void recordFixed(const SenMLRecord& record, int32_t value, uint8_t scale, long time);
+    void end();
+private:
+    BufferWriter& writer;
+    SenMLFormat format;
+
+
+    void writeRecord(const SenMLRecord& record, float value, bool timed, long time);
+    void writeRecordFixed(const SenMLRecord& record, int32_t value, uint8_t scale, bool timed, long time);
+    void writeRecordHead(const SenMLRecord& record, bool timed);
+    void writeRecordTail(const SenMLRecord& record, bool timed, long time);
+};
+
+
+size_t senmlWriteFixed(SenMLFormat format, char* buffer, size_t size,
+    const char* baseName, unsigned long baseTime, float baseVersion,
+    const SenMLRecord* records, const int32_t* values, size_t count, uint8_t scale);
+
+
+// Record layout and value count are checked at compile time
+template <size_t N>
+size_t senmlWrite(SenMLFormat format, char* buffer, size_t size,
+        const char* baseName, unsigned long baseTime, float baseVersion,
+        const SenMLRecord (&records)[N], const int32_t (&values)[N], uint8_t scale) {
+    return senmlWriteFixed(format, buffer, size, baseName, baseTime, baseVersion, records, values, N, scale);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define SENSOR_HISTORY_CHANNELS 3           // temperature, humidity, pressure
+#define SENSOR_HISTORY_BLOCKS 40
+#define SENSOR_HISTORY_BLOCK_SAMPLES 16
+#define SENSOR_HISTORY_TICK_MS 100          // resolution of the time deltas
+
+
+// Samples are grouped in blocks: the first sample of a block is stored in fixed point, the
+// following ones as 8 bit deltas from their predecessor. A sample whose delta does not fit
+// opens a new block, and the oldest block is dropped when the ring is full.
+class SensorHistory {
+public:
+    struct Sample {
+        unsigned long time;
+        float values[SENSOR_HISTORY_CHANNELS];
+    };
+
+    struct Cursor {
+        size_t block;
+        uint8_t sample;
+
+        unsigned long time;
+        long fixed[SENSOR_HISTORY_CHANNELS];
+    };
+
+
+    SensorHistory();
+
+
+    void append(unsigned long time, const float* values);
+    void clear();
+
+    size_t size();
+    size_t capacity();
+    unsigned long appended();
+
+    void begin(Cursor& cursor);
+    bool next(Cursor& cursor, Sample& sample);
+private:
+    struct Delta {
+        uint8_t time;
+        int8_t values[SENSOR_HISTORY_CHANNELS];
+    };
+
+    struct Block {
+        unsigned long time;
+        long base[SENSOR_HISTORY_CHANNELS];
+        uint8_t count;
+        Delta deltas[SENSOR_HISTORY_BLOCK_SAMPLES - 1];
+    };
+
+    static const long SCALES[SENSOR_HISTORY_CHANNELS];
+
+
+    Block blocks[SENSOR_HISTORY_BLOCKS];
+    size_t first;
+    size_t used;
+    size_t samples;
+    unsigned long appends;
+
+    unsigned long lastTime;
+    long lastFixed[SENSOR_HISTORY_CHANNELS];
+
+
+    void openBlock(unsigned long time, const long* fixed);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+#include "BlockDevice.h"
+#include "SensorSnapshot.h"
+
+
+#define SENSOR_LOG_MAGIC 0x534C4F47         // "SLOG"
+#define SENSOR_LOG_BLOCK_RECORDS 11         // 16 byte header + 11 * 44 byte records in a 512 byte block
+#define SENSOR_LOG_INDEX_SIZE 64            // sampled block headers kept in RAM
+
+
+// One snapshot as stored on the card. The CRC covers the block sequence as well, so a record
+// left over from the previous lap of the ring never passes for a current one.
+struct SensorLogRecord {
+    uint32_t time;                          // log clock, seconds
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+    uint32_t crc;
+};
+
+
+// Append-only ring of blocks on a BlockDevice. Records are collected in a RAM block that
+// reaches the device only through flush(), so the caller decides when the bus is free; the
+// oldest block is overwritten once the ring is full.
+//
+// Every block starts with a header carrying a sequence number that orders the ring. One header
+// out of every stride blocks is sampled into a RAM index at mount, which bounds both the mount
+// and the seek of a time range to the index size plus one stride of header reads.
+//
+// A write torn by a reset leaves records that fail their CRC: begin() resumes after the last
+// valid record and the next flush() rewrites the block without them.
+class SensorLog {
+public:
+    struct Cursor {
+        uint32_t sequence;                  // block
+        uint8_t record;
+    };
+
+
+    SensorLog(BlockDevice& device);
+
+
+    bool begin(unsigned long ms);
+    bool isReady() const;
+
+    uint32_t now(unsigned long ms);
+    void setTime(uint32_t time, unsigned long ms);
+
+    bool append(const SensorSnapshot& snapshot, unsigned long ms);
+    bool isFlushDue(unsigned long ms, unsigned long delayMs) const;
+    bool flush();
+
+    void seek(Cursor& cursor, uint32_t time);
+    bool next(Cursor& cursor, SensorLogRecord& record);
+
+    uint32_t size() const;
+    uint32_t capacity() const;
+    uint32_t getPosition() const;
+    unsigned long getErrors() const;
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t sequence;                  // blocks started since the log was created
+        uint32_t time;                      // of the first record
+        uint32_t crc;
+    };
+
+    struct Block {
+        Header header;
+        SensorLogRecord records[SENSOR_LOG_BLOCK_RECORDS];
+        uint8_t padding[BLOCK_DEVICE_BLOCK_SIZE - sizeof(Header) - SENSOR_LOG_BLOCK_RECORDS * sizeof(SensorLogRecord)];
+    };
+
+    struct IndexEntry {
+        uint32_t sequence;
+        uint32_t time;
+    };
+
+
+    BlockDevice& device;
+    bool ready;
+
+    uint32_t blocks;                        // a multiple of stride
+    uint32_t stride;
+    IndexEntry index[SENSOR_LOG_INDEX_SIZE];
+
+    Block head;                             // the block being filled, its sequence is the newest
+    uint8_t count;
+    bool started;                           // false until the first record
+    bool dirty;
+    unsigned long dirtyMs;                  // millis() of the oldest record not on the device
+    unsigned long errors;
+
+    uint32_t clock;                         // seconds, carries on from the last record after a reset
+    unsigned long clockMs;                  // millis() at which clock was last advanced
+
+
+    uint32_t oldest() const;
+    bool readHeader(uint32_t position, Header& header);
+    uint8_t countRecords(const Block& block);
+    void openBlock(uint32_t sequence, uint32_t time);
+    void indexBlock(uint32_t sequence, uint32_t time);
+
+    static uint32_t headerCrc(const Header& header);
+    static uint32_t recordCrc(uint32_t sequence, const SensorLogRecord& record);
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+enum SensorGroup {
+    SENSOR_GROUP_ENVIRONMENT,
+    SENSOR_GROUP_PRESSURE,
+    SENSOR_GROUP_ACCELEROMETER,
+    SENSOR_GROUP_GYROSCOPE,
+    SENSOR_GROUP_RGB,
+    SENSOR_GROUP_GESTURE,
+    SENSOR_GROUP_ORIENTATION,
+    SENSOR_GROUP_COUNT
+};
+
+
+// Deadline queue with one period per sensor group. Deadlines are compared through signed
+// differences, so scheduling keeps working when millis() wraps around after ~49 days.
+class SensorScheduler {
+public:
+    SensorScheduler();
+
+
+    void setPeriod(int group, unsigned long period);
+    unsigned long getPeriod(int group);
+
+    void start(unsigned long now);
+    int next(unsigned long now);
+
+    unsigned long timeUntil(int group, unsigned long now);
+private:
+    unsigned long periods[SENSOR_GROUP_COUNT];
+    unsigned long deadlines[SENSOR_GROUP_COUNT];
+};
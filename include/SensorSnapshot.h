@@ -0,0 +1,57 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define SENSOR_SNAPSHOT_DECIMALS 3          // channels hold thousandths of their unit
+#define SENSOR_SNAPSHOT_SCALE 1000
+#define SENSOR_SNAPSHOT_INVALID INT32_MIN   // NaN or out of range reading
+
+
+enum SensorChannel {
+    SENSOR_CHANNEL_TEMPERATURE,             // m°C
+    SENSOR_CHANNEL_HUMIDITY,                // m%RH
+    SENSOR_CHANNEL_PRESSURE,                // mPa
+    SENSOR_CHANNEL_ACCELEROMETER_X,         // mg
+    SENSOR_CHANNEL_ACCELEROMETER_Y,
+    SENSOR_CHANNEL_ACCELEROMETER_Z,
+    SENSOR_CHANNEL_GYROSCOPE_X,             // mdps
+    SENSOR_CHANNEL_GYROSCOPE_Y,
+    SENSOR_CHANNEL_GYROSCOPE_Z,
+    SENSOR_CHANNEL_COUNT
+};
+
+
+// Every published reading at one point in time
+struct SensorSnapshot {
+    int32_t channels[SENSOR_CHANNEL_COUNT];
+
+    unsigned long time;         // millis() of the refresh that published it
+    unsigned long generation;   // sensor refreshes counted up to and including that one
+};
+
+
+int32_t sensorFixed(float value);
+
+
+// Double-buffered snapshot with a sequence counter. The writer fills the back slot and flips
+// it to the front; readers use the front slot in place and afterwards check with valid() that
+// the writer has not started reusing it, retrying when it has. Neither side blocks or masks
+// interrupts, the writer may run from an interrupt as long as there is only one.
+//
+// The sequence is odd while a slot is being written, and slot (sequence / 2) & 1 is the front.
+class SensorSnapshotBuffer {
+public:
+    SensorSnapshotBuffer();
+
+
+    SensorSnapshot& edit();
+    void publish();
+
+    const SensorSnapshot& read(uint32_t& sequence) const;
+    bool valid(uint32_t sequence) const;
+private:
+    SensorSnapshot slots[2];
+    volatile uint32_t sequence;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+#define TASK_SCHEDULER_MAX 8
+#define TASK_WHEEL_SLOTS 16
+#define TASK_WHEEL_TICK_MS 5            // one revolution covers 80 ms, longer periods wait for their lap
+
+
+// Cooperative scheduler on a hashed timer wheel: each task sits in the slot of its next
+// deadline, so a pass only walks the slots that elapsed instead of every task. Due tasks
+// run by priority, 0 first. With nothing due the core sleeps until the next interrupt.
+class TaskScheduler {
+public:
+    typedef void (*TaskFunction)();
+
+    struct Task {
+        const char* name;
+        TaskFunction function;
+        unsigned long period;
+        uint8_t priority;
+
+        unsigned long deadline;
+        unsigned long runs;
+        unsigned long overruns;         // activations skipped because the task ran a period late
+        unsigned long maxRunUs;
+
+        Task* next;
+    };
+
+
+    TaskScheduler();
+
+
+    int add(const char* name, TaskFunction function, unsigned long period, uint8_t priority);
+
+    void start(unsigned long now);
+    bool run(unsigned long now);
+    void idle();
+
+    size_t count();
+    const Task& get(size_t i);
+private:
+    Task tasks[TASK_SCHEDULER_MAX];
+    size_t taskCount;
+
+    Task* wheel[TASK_WHEEL_SLOTS];
+    unsigned long wheelTick;
+
+
+    void schedule(Task* task);
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <WiFiNINA.h>
+
+
+#define WIFI_STATUS_POLL_MS 500             // at most one SPI status round trip per period
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+
+
+enum WiFiConnectionState {
+    WIFI_STATE_IDLE,
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_BACKOFF
+};
+
+
+// Drives the NINA connection without blocking: the passphrase is handed to the
+// coprocessor and the link status is then polled at WIFI_STATUS_POLL_MS, never more often.
+// Failed or lost connections are retried after an exponential backoff. Everything else
+// reads the cached state.
+class WiFiConnection {
+public:
+    WiFiConnection(const char* ssid, const char* passphrase);
+
+
+    void begin(unsigned long now);
+    bool loop(unsigned long now);
+
+    bool connected();
+    IPAddress getLocalIP();
+private:
+    const char* ssid;
+    const char* passphrase;
+
+    WiFiConnectionState state;
+    uint8_t status;
+    IPAddress localIP;
+
+    unsigned long lastPollMs;
+    unsigned long stateSinceMs;
+    unsigned long backoffMs;
+    unsigned long retryDelayMs;
+
+
+    void connect(unsigned long now);
+    void retry(unsigned long now);
+};
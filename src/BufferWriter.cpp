@@ -0,0 +1,173 @@
+#include "BufferWriter.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+BufferWriter::BufferWriter(char* buffer, size_t size) {
+    this->buffer = buffer;
+    this->size = size;
+    this->offset = 0;
+    this->position = 0;
+    this->overflowed = false;
+}
+
+// Window mode: the first offset bytes are counted but not stored, which lets a
+// generator be replayed to produce any slice of its output without holding all of it
+BufferWriter::BufferWriter(char* buffer, size_t size, size_t offset) {
+    this->buffer = buffer;
+    this->size = size;
+    this->offset = offset;
+    this->position = 0;
+    this->overflowed = false;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void BufferWriter::write(char c) {
+    if (this->position >= this->offset) {
+        if (this->position - this->offset < this->size) {
+            this->buffer[this->position - this->offset] = c;
+        } else {
+            this->overflowed = true;
+        }
+    }
+
+    this->position++;
+}
+
+void BufferWriter::write(const char* str) {
+    while (*str != '\0') {
+        this->write(*str++);
+    }
+}
+
+void BufferWriter::write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        this->write((char) data[i]);
+    }
+}
+
+void BufferWriter::writeUnsigned(unsigned long value) {
+    char digits[sizeof(value) * 3];
+    int count = 0;
+
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0) {
+        this->write(digits[--count]);
+    }
+}
+
+void BufferWriter::writeSigned(long value) {
+    if (value < 0) {
+        this->write('-');
+        this->writeUnsigned(0UL - (unsigned long) value);
+    } else {
+        this->writeUnsigned((unsigned long) value);
+    }
+}
+
+// Rounds to a fixed number of decimals with integer arithmetic and drops trailing zeros,
+// so the same reading always produces the same bytes
+void BufferWriter::writeFixed(float value, uint8_t decimals) {
+    if (isnan(value) || isinf(value)) {
+        this->write("null");
+        return;
+    }
+
+    unsigned long scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+
+    bool negative = value < 0;
+    double scaled = (negative ? -(double) value : (double) value) * scale + 0.5;
+    if (scaled >= 4294967296.0 * scale) {
+        this->write("null");
+        return;
+    }
+
+    this->writeDecimal(negative, (unsigned long long) scaled, decimals, true);
+}
+
+// Integer-only counterpart of writeFixed() for a value carrying scale decimals, e.g. 21375
+// with scale 3 is 21.375; INT32_MIN marks a missing value and is written as null.
+// Without trim exactly the given decimals are written.
+void BufferWriter::writeScaled(int32_t value, uint8_t scale, uint8_t decimals, bool trim) {
+    if (value == INT32_MIN) {
+        this->write("null");
+        return;
+    }
+
+    decimals = decimals < scale ? decimals : scale;
+
+    unsigned long divisor = 1;
+    for (uint8_t i = decimals; i < scale; i++) {
+        divisor *= 10;
+    }
+
+    bool negative = value < 0;
+    unsigned long magnitude = negative ? 0UL - (unsigned long) value : (unsigned long) value;
+
+    this->writeDecimal(negative, (magnitude + divisor / 2) / divisor, decimals, trim);
+}
+
+size_t BufferWriter::length() {
+    if (this->position <= this->offset) {
+        return 0;
+    }
+
+    size_t length = this->position - this->offset;
+    return length < this->size ? length : this->size;
+}
+
+size_t BufferWriter::total() {
+    return this->position;
+}
+
+bool BufferWriter::overflow() {
+    return this->overflowed;
+}
+
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// fixed is the magnitude in units of 10^-decimals, already rounded
+void BufferWriter::writeDecimal(bool negative, unsigned long long fixed, uint8_t decimals, bool trim) {
+    unsigned long scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+
+    unsigned long long integer = fixed / scale;
+    unsigned long fraction = (unsigned long) (fixed % scale);
+
+    while (trim && decimals > 0 && fraction % 10 == 0) {
+        fraction /= 10;
+        scale /= 10;
+        decimals--;
+    }
+
+    if (negative && fixed > 0) {
+        this->write('-');
+    }
+
+    this->writeUnsigned((unsigned long) integer);
+
+    if (decimals > 0) {
+        this->write('.');
+        for (scale /= 10; scale > 0; scale /= 10) {
+            this->write('0' + (fraction / scale) % 10);
+        }
+    }
+}
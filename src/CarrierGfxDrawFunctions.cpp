@@ -1,82 +1,126 @@
 #include "CarrierGfxDrawFunctions.h"
 
 
-void cleanDisplay(Adafruit_ST7789& display) {
-    display.fillScreen(0x0000);
-}
+// Icons are pre-rasterized by tools/generate_icons.py, see CarrierGfxIcons.h
+const GfxSprite GFX_THERMOMETER_SPRITE = { GFX_THERMOMETER_BITMAP, GFX_THERMOMETER_WIDTH, GFX_THERMOMETER_HEIGHT };
+const GfxSprite GFX_DROPLET_SPRITE = { GFX_DROPLET_BITMAP, GFX_DROPLET_WIDTH, GFX_DROPLET_HEIGHT };
+const GfxSprite GFX_MOVEMENT_SPRITE = { GFX_MOVEMENT_BITMAP, GFX_MOVEMENT_WIDTH, GFX_MOVEMENT_HEIGHT };
+const GfxSprite GFX_ROTATION_SPRITE = { GFX_ROTATION_BITMAP, GFX_ROTATION_WIDTH, GFX_ROTATION_HEIGHT };
+const GfxSprite GFX_PRESSURE_SPRITE = { GFX_PRESSURE_BITMAP, GFX_PRESSURE_WIDTH, GFX_PRESSURE_HEIGHT };
 
-void drawThermometerIcon(Adafruit_ST7789& display, int color, int x, int y) {
-    display.fillCircle(x+15, y+10, 10, color);
-    display.fillRect(x+5, y+10, 21, 28, color);
-    display.fillCircle(x+15, y+45, 15, color);
 
-    display.fillCircle(x+15, y+10, 7, 0x0000);
-    display.fillRect(x+8, y+13, 15, 25, 0x0000);
-    display.fillCircle(x+15, y+45, 12, 0x0000);
+void cleanDisplay(Adafruit_ST7789& display) {
+    display.fillScreen(0x0000);
 }
 
-void drawDropletIcon(Adafruit_ST7789& display, int color, int x, int y) {
-    display.fillTriangle(x+2, y+30, x+20, y, x+38, y+30, color);
-    display.fillCircle(x+20, y+40, 20, color);
-    display.fillTriangle(x+6, y+30, x+20, y+5, x+34, y+30, 0x0000);
-    display.fillCircle(x+20, y+40, 17, 0x0000);
-}
+// The whole sprite goes out as one address window and a burst of pixel data,
+// instead of a window per line of every primitive
+void drawSprite(Adafruit_ST7789& display, const GfxSprite& sprite, int color, int x, int y) {
+    if (x < 0 || y < 0 || x + sprite.width > display.width() || y + sprite.height > display.height()) {
+        return;
+    }
 
-void drawMovementIcon(Adafruit_ST7789& display, int color, int x, int y) {
-    display.fillTriangle(x+20, y+15, x+30, y, x+40, y+15, color);      // North
-    display.fillTriangle(x+25, y+12, x+30, y+5, x+35, y+12, 0x0000);
-    display.fillTriangle(x, y+30, x+15, y+20, x+15, y+40, color);      // West
-    display.fillTriangle(x+5, y+30, x+12, y+25, x+12, y+35, 0x0000);
-    display.fillTriangle(x+20, y+45, x+40, y+45, x+30, y+60, color);   // South
-    display.fillTriangle(x+25, y+48, x+35, y+48, x+30, y+55, 0x0000);
-    display.fillTriangle(x+45, y+40, x+45, y+20, x+60, y+30, color);   // East
-    display.fillTriangle(x+48, y+35, x+48, y+25, x+55, y+30, 0x0000);
-    display.fillRect(x+15, y+25, 30, 10, color);                         // Horizontal
-    display.fillRect(x+25, y+15, 10, 30, color);                         // Vertical
-    display.fillRect(x+12, y+28, 36, 4, 0x0000);
-    display.fillRect(x+28, y+12, 4, 36, 0x0000);
-}
+    uint16_t line[GFX_SPRITE_WIDTH_MAX];
+    size_t stride = (sprite.width + 7) / 8;
 
-void drawRotationIcon(Adafruit_ST7789& display, int color, int x, int y) {
-    display.fillCircle(x+30, y+30, 27, color);
-    display.fillCircle(x+30, y+30, 24, 0x0000);
-    display.fillCircle(x+30, y+30, 20, color);
-    display.fillCircle(x+30, y+30, 17, 0x0000);
+    display.startWrite();
+    display.setAddrWindow(x, y, sprite.width, sprite.height);
 
-    display.fillTriangle(x, y, x+30, y, x+30, y+30, 0x0000);
+    for (int row = 0; row < sprite.height; row++) {
+        const uint8_t* bits = sprite.bitmap + row * stride;
 
-    display.fillTriangle(x+15, y+7, x+30, y, x+30, y+15, color);
-    display.fillTriangle(x+22, y+7, x+27, y+5, x+27, y+10, 0x0000);
+        for (int column = 0; column < sprite.width; column++) {
+            bool on = pgm_read_byte(&bits[column >> 3]) & (0x80 >> (column & 0x07));
+            line[column] = on ? color : GFX_SPRITE_BACKGROUND;
+        }
 
-    display.fillRect(x+27, y+6, 4, 4, 0x0000);
+        display.writePixels(line, sprite.width);
+    }
 
-    display.fillTriangle(x+12, y+12, x+17, y+17, x+12, y+15, color);
+    display.endWrite();
+}
 
-    display.fillCircle(x+30, y+30, 5, color);
-    display.fillCircle(x+30, y+30, 2, 0x0000);
+void drawMessage(Adafruit_ST7789& display, const GFXfont *font, int x, int y, int color, String message) {
+    display.setFont(font);
+    display.setTextColor(color);
+    display.setCursor(x, y);
+    display.print(message);
 }
 
-void drawPressureIcon(Adafruit_ST7789& display, int color, int x, int y) {
-    display.fillRect(x, y+50, 60, 10, color);
 
-    display.fillTriangle(x+5, y+35, x+25, y+35, x+15, y+50, color);
-    display.fillTriangle(x+35, y+35, x+55, y+35, x+45, y+50, color);
+// In-memory counterparts of drawSprite() and drawMessage(): they set the same pixels,
+// clipped to the band, so a frame rendered band by band matches the direct drawing
 
-    display.fillRect(x+10, y, 10, 35, color);
-    display.fillRect(x+40, y, 10, 35, color);
+void renderSprite(GfxBand& band, const GfxSprite& sprite, int color, int x, int y) {
+    size_t stride = (sprite.width + 7) / 8;
 
-    display.fillRect(x+3, y+53, 54, 4, 0x0000);
+    for (int row = 0; row < band.rows; row++) {
+        int spriteRow = band.y + row - y;
+        if (spriteRow < 0 || spriteRow >= sprite.height) {
+            continue;
+        }
 
-    display.fillTriangle(x+10, y+38, x+20, y+38, x+15, y+45, 0x0000);
-    display.fillTriangle(x+40, y+38, x+50, y+38, x+45, y+45, 0x0000);
+        const uint8_t* bits = sprite.bitmap + spriteRow * stride;
+        uint16_t* pixels = band.pixels + row * band.width;
 
-    display.fillRect(x+13, y+3, 4, 35, 0x0000);
-    display.fillRect(x+43, y+3, 4, 35, 0x0000);
+        for (int column = 0; column < band.width; column++) {
+            int spriteColumn = band.x + column - x;
+            if (spriteColumn < 0 || spriteColumn >= sprite.width) {
+                continue;
+            }
+
+            bool on = pgm_read_byte(&bits[spriteColumn >> 3]) & (0x80 >> (spriteColumn & 0x07));
+            pixels[column] = on ? color : GFX_SPRITE_BACKGROUND;
+        }
+    }
 }
 
-void drawMessage(Adafruit_ST7789& display, const GFXfont *font, int x, int y, int color, String message) {
-    display.setFont(font);
-    display.setTextColor(color);
-    display.setCursor(x, y);
-    display.print(message);
-}
\ No newline at end of file
+// Glyph placement and wrapping follow Adafruit_GFX::write() for custom fonts at text size 1
+void renderMessage(GfxBand& band, const GFXfont* font, int x, int y, int color, const char* message, int screenWidth) {
+    int cursorX = x;
+    int cursorY = y;
+
+    for (const char* c = message; *c != '\0'; c++) {
+        if (*c == '\n') {
+            cursorX = 0;
+            cursorY += font->yAdvance;
+            continue;
+        }
+
+        if (*c == '\r' || (uint8_t) *c < font->first || (uint8_t) *c > font->last) {
+            continue;
+        }
+
+        const GFXglyph& glyph = font->glyph[(uint8_t) *c - font->first];
+
+        if (glyph.width > 0 && glyph.height > 0) {
+            if (cursorX + glyph.xOffset + glyph.width > screenWidth) {
+                cursorX = 0;
+                cursorY += font->yAdvance;
+            }
+
+            const uint8_t* bitmap = font->bitmap + glyph.bitmapOffset;
+            int left = cursorX + glyph.xOffset;
+            int top = cursorY + glyph.yOffset;
+
+            // Glyph bits run on across rows without padding
+            for (int row = 0; row < glyph.height; row++) {
+                int bandRow = top + row - band.y;
+                if (bandRow < 0 || bandRow >= band.rows) {
+                    continue;
+                }
+
+                for (int column = 0; column < glyph.width; column++) {
+                    int bandColumn = left + column - band.x;
+                    unsigned int bit = row * glyph.width + column;
+
+                    if (bandColumn >= 0 && bandColumn < band.width && (pgm_read_byte(&bitmap[bit >> 3]) & (0x80 >> (bit & 0x07)))) {
+                        band.pixels[bandRow * band.width + bandColumn] = color;
+                    }
+                }
+            }
+        }
+
+        cursorX += glyph.xAdvance;
+    }
+}
@@ -0,0 +1,141 @@
+#include "CarrierGfxGlyphCache.h"
+
+
+uint8_t CarrierGfxGlyphCache::POOL[GFX_GLYPH_CACHE_POOL_BYTES];
+size_t CarrierGfxGlyphCache::POOL_USED = 0;
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CarrierGfxGlyphCache::CarrierGfxGlyphCache(const GFXfont* font) {
+    this->font = font;
+    this->ready = false;
+
+    this->cellWidth = 0;
+    this->cellHeight = 0;
+    this->cellTop = 0;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+bool CarrierGfxGlyphCache::begin() {
+    if (this->ready) {
+        return true;
+    }
+
+    const char* charset = GFX_GLYPH_CACHE_CHARSET;
+    int width = 0;
+    int top = 0;
+    int bottom = 0;
+
+    for (size_t i = 0; i < GFX_GLYPH_CACHE_CHARS; i++) {
+        uint8_t c = charset[i];
+        if (c < this->font->first || c > this->font->last) {
+            continue;
+        }
+
+        const GFXglyph& glyph = this->font->glyph[c - this->font->first];
+        int right = glyph.xOffset + glyph.width;
+
+        width = glyph.xAdvance > width ? glyph.xAdvance : width;
+        width = right > width ? right : width;
+        if (glyph.height > 0) {
+            top = glyph.yOffset < top ? glyph.yOffset : top;
+            bottom = glyph.yOffset + glyph.height > bottom ? glyph.yOffset + glyph.height : bottom;
+        }
+    }
+
+    if (width == 0 || width > GFX_SPRITE_WIDTH_MAX || bottom == top) {
+        return false;
+    }
+
+    size_t stride = (width + 7) / 8;
+    size_t size = stride * (bottom - top);
+
+    if (CarrierGfxGlyphCache::POOL_USED + size * GFX_GLYPH_CACHE_CHARS > GFX_GLYPH_CACHE_POOL_BYTES) {
+        return false;
+    }
+
+    this->cellWidth = width;
+    this->cellHeight = bottom - top;
+    this->cellTop = top;
+
+    for (size_t i = 0; i < GFX_GLYPH_CACHE_CHARS; i++) {
+        uint8_t* bitmap = CarrierGfxGlyphCache::POOL + CarrierGfxGlyphCache::POOL_USED;
+        CarrierGfxGlyphCache::POOL_USED += size;
+
+        this->rasterize(charset[i], bitmap, stride);
+
+        this->glyphs[i].bitmap = bitmap;
+        this->glyphs[i].width = this->cellWidth;
+        this->glyphs[i].height = this->cellHeight;
+    }
+
+    this->ready = true;
+    return true;
+}
+
+bool CarrierGfxGlyphCache::isReady() const {
+    return this->ready;
+}
+
+const GFXfont* CarrierGfxGlyphCache::getFont() const {
+    return this->font;
+}
+
+const GfxSprite& CarrierGfxGlyphCache::getGlyph(char c) const {
+    const char* position = strchr(GFX_GLYPH_CACHE_CHARSET, c);
+
+    if (c == '\0' || position == NULL) {
+        position = strchr(GFX_GLYPH_CACHE_CHARSET, ' ');
+    }
+
+    return this->glyphs[position - GFX_GLYPH_CACHE_CHARSET];
+}
+
+uint8_t CarrierGfxGlyphCache::getCellWidth() const {
+    return this->cellWidth;
+}
+
+uint8_t CarrierGfxGlyphCache::getCellHeight() const {
+    return this->cellHeight;
+}
+
+int8_t CarrierGfxGlyphCache::getCellTop() const {
+    return this->cellTop;
+}
+
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// Same bit order as Adafruit_GFX::drawChar(), glyph bits run on across rows without padding
+void CarrierGfxGlyphCache::rasterize(char c, uint8_t* bitmap, size_t stride) {
+    memset(bitmap, 0, stride * this->cellHeight);
+
+    if ((uint8_t) c < this->font->first || (uint8_t) c > this->font->last) {
+        return;
+    }
+
+    const GFXglyph& glyph = this->font->glyph[(uint8_t) c - this->font->first];
+    const uint8_t* bits = this->font->bitmap + glyph.bitmapOffset;
+
+    for (int row = 0; row < glyph.height; row++) {
+        int cellRow = glyph.yOffset + row - this->cellTop;
+
+        for (int column = 0; column < glyph.width; column++) {
+            int cellColumn = glyph.xOffset + column;
+            unsigned int bit = row * glyph.width + column;
+
+            if (cellColumn >= 0 && cellColumn < this->cellWidth && (pgm_read_byte(&bits[bit >> 3]) & (0x80 >> (bit & 0x07)))) {
+                bitmap[cellRow * stride + (cellColumn >> 3)] |= 0x80 >> (cellColumn & 0x07);
+            }
+        }
+    }
+}
@@ -0,0 +1,320 @@
+// Generated by tools/generate_icons.py, do not edit
+
+#include "CarrierGfxIcons.h"
+
+
+const uint8_t GFX_THERMOMETER_BITMAP[] PROGMEM = {
+    0x00, 0x0F, 0xE0, 0x00,
+    0x00, 0x3F, 0xF8, 0x00,
+    0x00, 0x7F, 0xFC, 0x00,
+    0x00, 0xF8, 0x3E, 0x00,
+    0x01, 0xE0, 0x0F, 0x00,
+    0x03, 0xC0, 0x07, 0x80,
+    0x03, 0x80, 0x03, 0x80,
+    0x07, 0x80, 0x03, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x07, 0x00, 0x01, 0xC0,
+    0x0F, 0x00, 0x01, 0xE0,
+    0x1E, 0x00, 0x00, 0xF0,
+    0x3C, 0x00, 0x00, 0x78,
+    0x38, 0x00, 0x00, 0x38,
+    0x78, 0x00, 0x00, 0x3C,
+    0x70, 0x00, 0x00, 0x1C,
+    0x70, 0x00, 0x00, 0x1C,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0xE0, 0x00, 0x00, 0x0E,
+    0x70, 0x00, 0x00, 0x1C,
+    0x70, 0x00, 0x00, 0x1C,
+    0x78, 0x00, 0x00, 0x3C,
+    0x38, 0x00, 0x00, 0x38,
+    0x3C, 0x00, 0x00, 0x78,
+    0x1E, 0x00, 0x00, 0xF0,
+    0x0F, 0x00, 0x01, 0xE0,
+    0x07, 0xC0, 0x07, 0xC0,
+    0x03, 0xF0, 0x1F, 0x80,
+    0x01, 0xFF, 0xFF, 0x00,
+    0x00, 0x7F, 0xFC, 0x00,
+    0x00, 0x0F, 0xE0, 0x00,
+};
+
+const uint8_t GFX_DROPLET_BITMAP[] PROGMEM = {
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x1C, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x1C, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x3E, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x77, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xE3, 0x80, 0x00, 0x00,
+    0x00, 0x00, 0xE3, 0x80, 0x00, 0x00,
+    0x00, 0x01, 0xC1, 0xC0, 0x00, 0x00,
+    0x00, 0x03, 0xC1, 0xE0, 0x00, 0x00,
+    0x00, 0x03, 0x80, 0xE0, 0x00, 0x00,
+    0x00, 0x07, 0x80, 0xF0, 0x00, 0x00,
+    0x00, 0x07, 0x00, 0x70, 0x00, 0x00,
+    0x00, 0x0E, 0x00, 0x38, 0x00, 0x00,
+    0x00, 0x1E, 0x00, 0x3C, 0x00, 0x00,
+    0x00, 0x1C, 0x00, 0x1C, 0x00, 0x00,
+    0x00, 0x3C, 0x00, 0x1E, 0x00, 0x00,
+    0x00, 0x38, 0x00, 0x0E, 0x00, 0x00,
+    0x00, 0x78, 0x00, 0x0F, 0x00, 0x00,
+    0x00, 0xF0, 0x00, 0x07, 0x80, 0x00,
+    0x00, 0xF0, 0x00, 0x07, 0x80, 0x00,
+    0x01, 0xE0, 0x00, 0x03, 0xC0, 0x00,
+    0x01, 0xC0, 0x00, 0x01, 0xC0, 0x00,
+    0x03, 0xC0, 0x00, 0x01, 0xE0, 0x00,
+    0x07, 0x80, 0x00, 0x00, 0xF0, 0x00,
+    0x07, 0x80, 0x00, 0x00, 0xF0, 0x00,
+    0x0F, 0x00, 0x00, 0x00, 0x78, 0x00,
+    0x0F, 0x00, 0x00, 0x00, 0x78, 0x00,
+    0x1E, 0x00, 0x00, 0x00, 0x3C, 0x00,
+    0x3C, 0x00, 0x00, 0x00, 0x1E, 0x00,
+    0x3C, 0x00, 0x00, 0x00, 0x1E, 0x00,
+    0x38, 0x00, 0x00, 0x00, 0x0E, 0x00,
+    0x78, 0x00, 0x00, 0x00, 0x0F, 0x00,
+    0x70, 0x00, 0x00, 0x00, 0x07, 0x00,
+    0x70, 0x00, 0x00, 0x00, 0x07, 0x00,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0xE0, 0x00, 0x00, 0x00, 0x03, 0x80,
+    0x70, 0x00, 0x00, 0x00, 0x07, 0x00,
+    0x70, 0x00, 0x00, 0x00, 0x07, 0x00,
+    0x78, 0x00, 0x00, 0x00, 0x0F, 0x00,
+    0x38, 0x00, 0x00, 0x00, 0x0E, 0x00,
+    0x3C, 0x00, 0x00, 0x00, 0x1E, 0x00,
+    0x1C, 0x00, 0x00, 0x00, 0x1C, 0x00,
+    0x1E, 0x00, 0x00, 0x00, 0x3C, 0x00,
+    0x0F, 0x00, 0x00, 0x00, 0x78, 0x00,
+    0x07, 0x80, 0x00, 0x00, 0xF0, 0x00,
+    0x03, 0xC0, 0x00, 0x01, 0xE0, 0x00,
+    0x01, 0xF0, 0x00, 0x07, 0xC0, 0x00,
+    0x00, 0xFC, 0x00, 0x1F, 0x80, 0x00,
+    0x00, 0x7F, 0x00, 0x7F, 0x00, 0x00,
+    0x00, 0x1F, 0xFF, 0xFC, 0x00, 0x00,
+    0x00, 0x07, 0xFF, 0xF0, 0x00, 0x00,
+    0x00, 0x00, 0xFF, 0x80, 0x00, 0x00,
+};
+
+const uint8_t GFX_MOVEMENT_BITMAP[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x0F, 0x80, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x0F, 0x80, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x1D, 0xC0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x3D, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x38, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0x70, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xF0, 0x78, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xE0, 0x38, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0xC0, 0x1C, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0x80, 0x0E, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0xF0, 0xFE, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x07, 0xF0, 0xFF, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x0F, 0xF0, 0xFF, 0x80, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x70, 0xE0, 0x04, 0x00, 0x00,
+    0x00, 0x03, 0x00, 0x70, 0xE0, 0x06, 0x00, 0x00,
+    0x00, 0x0F, 0x00, 0x70, 0xE0, 0x07, 0x80, 0x00,
+    0x00, 0x1F, 0x00, 0x70, 0xE0, 0x07, 0xC0, 0x00,
+    0x00, 0x7F, 0x00, 0x70, 0xE0, 0x07, 0xF0, 0x00,
+    0x00, 0xF7, 0xFF, 0xF0, 0xFF, 0xFF, 0x78, 0x00,
+    0x03, 0xE7, 0xFF, 0xF0, 0xFF, 0xFF, 0x3E, 0x00,
+    0x07, 0xC7, 0xFF, 0xF0, 0xFF, 0xFF, 0x1F, 0x00,
+    0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xC0,
+    0x3E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xE0,
+    0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8,
+    0x7C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xF0,
+    0x1E, 0x07, 0xFF, 0xF0, 0xFF, 0xFF, 0x03, 0xC0,
+    0x0F, 0x87, 0xFF, 0xF0, 0xFF, 0xFF, 0x0F, 0x80,
+    0x03, 0xC7, 0xFF, 0xF0, 0xFF, 0xFF, 0x1E, 0x00,
+    0x01, 0xF7, 0x00, 0x70, 0xE0, 0x07, 0x7C, 0x00,
+    0x00, 0x7F, 0x00, 0x70, 0xE0, 0x07, 0xF0, 0x00,
+    0x00, 0x3F, 0x00, 0x70, 0xE0, 0x07, 0xE0, 0x00,
+    0x00, 0x0F, 0x00, 0x70, 0xE0, 0x07, 0x80, 0x00,
+    0x00, 0x07, 0x00, 0x70, 0xE0, 0x07, 0x00, 0x00,
+    0x00, 0x01, 0x00, 0x70, 0xE0, 0x04, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x0F, 0xF0, 0xFF, 0x80, 0x00, 0x00,
+    0x00, 0x00, 0x0F, 0xF0, 0xFF, 0x80, 0x00, 0x00,
+    0x00, 0x00, 0x07, 0xF0, 0xFF, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0x80, 0x0E, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0x80, 0x0E, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0xC0, 0x1C, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xE0, 0x38, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xE0, 0x38, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x70, 0x70, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x38, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x3D, 0xE0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x1F, 0xC0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x0F, 0x80, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x0F, 0x80, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+};
+
+const uint8_t GFX_ROTATION_BITMAP[] PROGMEM = {
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x0E, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x3E, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xFF, 0xF0, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0xFF, 0xFE, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x0F, 0xEF, 0xFF, 0xC0, 0x00, 0x00,
+    0x00, 0x00, 0x3F, 0x80, 0x1F, 0xF0, 0x00, 0x00,
+    0x00, 0x01, 0xFC, 0x00, 0x01, 0xF8, 0x00, 0x00,
+    0x00, 0x00, 0xFE, 0x00, 0x00, 0x7E, 0x00, 0x00,
+    0x00, 0x00, 0x3F, 0x80, 0x00, 0x1F, 0x00, 0x00,
+    0x00, 0x00, 0x0F, 0xEF, 0xE0, 0x0F, 0x80, 0x00,
+    0x00, 0x00, 0x03, 0xFF, 0xFC, 0x03, 0xC0, 0x00,
+    0x00, 0x38, 0x00, 0xFF, 0xFF, 0x01, 0xE0, 0x00,
+    0x00, 0x7C, 0x00, 0x3E, 0x1F, 0xC0, 0xF0, 0x00,
+    0x00, 0xFE, 0x00, 0x0E, 0x07, 0xE0, 0x78, 0x00,
+    0x00, 0xEF, 0x00, 0x02, 0x01, 0xF0, 0x38, 0x00,
+    0x01, 0xE3, 0x80, 0x00, 0x00, 0x78, 0x3C, 0x00,
+    0x03, 0xC1, 0xC0, 0x00, 0x00, 0x3C, 0x1E, 0x00,
+    0x03, 0x83, 0xC0, 0x00, 0x00, 0x1E, 0x0E, 0x00,
+    0x07, 0x87, 0x80, 0x00, 0x00, 0x0F, 0x0F, 0x00,
+    0x07, 0x07, 0x00, 0x00, 0x00, 0x07, 0x07, 0x00,
+    0x07, 0x0F, 0x00, 0x00, 0x00, 0x07, 0x87, 0x00,
+    0x0E, 0x0E, 0x00, 0x00, 0x00, 0x03, 0x83, 0x80,
+    0x0E, 0x1E, 0x00, 0x00, 0x00, 0x03, 0xC3, 0x80,
+    0x0E, 0x1C, 0x00, 0x00, 0x00, 0x01, 0xC3, 0x80,
+    0x1E, 0x1C, 0x00, 0x0F, 0x80, 0x01, 0xC3, 0xC0,
+    0x1C, 0x38, 0x00, 0x1F, 0xC0, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x3F, 0xE0, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x78, 0xF0, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x70, 0x70, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x70, 0x70, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x70, 0x70, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x78, 0xF0, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x3F, 0xE0, 0x00, 0xE1, 0xC0,
+    0x1C, 0x38, 0x00, 0x1F, 0xC0, 0x00, 0xE1, 0xC0,
+    0x1E, 0x1C, 0x00, 0x0F, 0x80, 0x01, 0xC3, 0xC0,
+    0x0E, 0x1C, 0x00, 0x00, 0x00, 0x01, 0xC3, 0x80,
+    0x0E, 0x1E, 0x00, 0x00, 0x00, 0x03, 0xC3, 0x80,
+    0x0E, 0x0E, 0x00, 0x00, 0x00, 0x03, 0x83, 0x80,
+    0x07, 0x0F, 0x00, 0x00, 0x00, 0x07, 0x87, 0x00,
+    0x07, 0x07, 0x00, 0x00, 0x00, 0x07, 0x07, 0x00,
+    0x07, 0x87, 0x80, 0x00, 0x00, 0x0F, 0x0F, 0x00,
+    0x03, 0x83, 0xC0, 0x00, 0x00, 0x1E, 0x0E, 0x00,
+    0x03, 0xC1, 0xE0, 0x00, 0x00, 0x3C, 0x1E, 0x00,
+    0x01, 0xE0, 0xF0, 0x00, 0x00, 0x78, 0x3C, 0x00,
+    0x00, 0xE0, 0x7C, 0x00, 0x01, 0xF0, 0x38, 0x00,
+    0x00, 0xF0, 0x3F, 0x00, 0x07, 0xE0, 0x78, 0x00,
+    0x00, 0x78, 0x1F, 0xC0, 0x1F, 0xC0, 0xF0, 0x00,
+    0x00, 0x3C, 0x07, 0xFF, 0xFF, 0x01, 0xE0, 0x00,
+    0x00, 0x1E, 0x01, 0xFF, 0xFC, 0x03, 0xC0, 0x00,
+    0x00, 0x0F, 0x80, 0x3F, 0xE0, 0x0F, 0x80, 0x00,
+    0x00, 0x07, 0xC0, 0x00, 0x00, 0x1F, 0x00, 0x00,
+    0x00, 0x03, 0xF0, 0x00, 0x00, 0x7E, 0x00, 0x00,
+    0x00, 0x00, 0xFC, 0x00, 0x01, 0xF8, 0x00, 0x00,
+    0x00, 0x00, 0x7F, 0xC0, 0x1F, 0xF0, 0x00, 0x00,
+    0x00, 0x00, 0x1F, 0xFF, 0xFF, 0xC0, 0x00, 0x00,
+    0x00, 0x00, 0x03, 0xFF, 0xFE, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x7F, 0xF0, 0x00, 0x00, 0x00,
+};
+
+const uint8_t GFX_PRESSURE_BITMAP[] PROGMEM = {
+    0x00, 0x3F, 0xF0, 0x00, 0x00, 0xFF, 0xC0, 0x00,
+    0x00, 0x3F, 0xF0, 0x00, 0x00, 0xFF, 0xC0, 0x00,
+    0x00, 0x3F, 0xF0, 0x00, 0x00, 0xFF, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x00, 0x38, 0x70, 0x00, 0x00, 0xE1, 0xC0, 0x00,
+    0x07, 0xF8, 0x7F, 0xC0, 0x1F, 0xE1, 0xFF, 0x00,
+    0x07, 0xF8, 0x7F, 0xC0, 0x1F, 0xE1, 0xFF, 0x00,
+    0x03, 0xF8, 0x7F, 0x80, 0x0F, 0xE1, 0xFE, 0x00,
+    0x01, 0xC0, 0x07, 0x00, 0x07, 0x00, 0x1C, 0x00,
+    0x01, 0xC0, 0x07, 0x00, 0x07, 0x00, 0x1C, 0x00,
+    0x00, 0xE0, 0x0E, 0x00, 0x03, 0x80, 0x38, 0x00,
+    0x00, 0x70, 0x1C, 0x00, 0x01, 0xC0, 0x70, 0x00,
+    0x00, 0x70, 0x1C, 0x00, 0x01, 0xC0, 0x70, 0x00,
+    0x00, 0x38, 0x38, 0x00, 0x00, 0xE0, 0xE0, 0x00,
+    0x00, 0x1C, 0x70, 0x00, 0x00, 0x71, 0xC0, 0x00,
+    0x00, 0x1E, 0xF0, 0x00, 0x00, 0x7B, 0xC0, 0x00,
+    0x00, 0x0F, 0xE0, 0x00, 0x00, 0x3F, 0x80, 0x00,
+    0x00, 0x07, 0xC0, 0x00, 0x00, 0x1F, 0x00, 0x00,
+    0x00, 0x07, 0xC0, 0x00, 0x00, 0x1F, 0x00, 0x00,
+    0x00, 0x03, 0x80, 0x00, 0x00, 0x0E, 0x00, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+    0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70,
+    0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70,
+    0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70,
+    0xE0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x70,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0,
+};
@@ -0,0 +1,366 @@
+#include "CarrierGfxScreen.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CarrierGfxScreen::CarrierGfxScreen(Adafruit_ST7789& display) : display(display) {
+    this->widgetCount = 0;
+    this->pendingCount = 0;
+    this->page = -1;
+    this->pendingPage = -1;
+    this->valid = false;
+
+    this->operationCount = 0;
+    this->operationIndex = 0;
+    this->operationRow = 0;
+    this->bandBuffer = 0;
+    this->bandReady = false;
+    this->transferring = false;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void CarrierGfxScreen::beginFrame(int page) {
+    this->pendingPage = page;
+    this->pendingCount = 0;
+}
+
+void CarrierGfxScreen::icon(const GfxSprite& sprite, int color, int x, int y) {
+    Widget* widget = this->nextWidget(WIDGET_ICON);
+    if (widget == NULL) {
+        return;
+    }
+
+    widget->sprite = &sprite;
+    widget->color = color;
+    widget->x = x;
+    widget->y = y;
+
+    widget->boundsX = x;
+    widget->boundsY = y;
+    widget->boundsWidth = sprite.width;
+    widget->boundsHeight = sprite.height;
+}
+
+void CarrierGfxScreen::text(const GFXfont* font, int x, int y, int color, const String& text) {
+    Widget* widget = this->nextWidget(WIDGET_TEXT);
+    if (widget == NULL) {
+        return;
+    }
+
+    widget->font = font;
+    widget->color = color;
+    widget->x = x;
+    widget->y = y;
+    strncpy(widget->text, text.c_str(), GFX_SCREEN_TEXT_MAX - 1);
+    widget->text[GFX_SCREEN_TEXT_MAX - 1] = '\0';
+
+    this->display.setFont(font);
+    this->display.getTextBounds(widget->text, x, y,
+        &widget->boundsX, &widget->boundsY, &widget->boundsWidth, &widget->boundsHeight);
+}
+
+// Falls back to proportional text with the cache's font when the cache is not ready
+void CarrierGfxScreen::field(const CarrierGfxGlyphCache& glyphs, int x, int y, int color, const char* value, int cells) {
+    if (!glyphs.isReady()) {
+        this->text(glyphs.getFont(), x, y, color, value);
+        return;
+    }
+
+    Widget* widget = this->nextWidget(WIDGET_FIELD);
+    if (widget == NULL) {
+        return;
+    }
+
+    cells = cells < GFX_SCREEN_TEXT_MAX - 1 ? cells : GFX_SCREEN_TEXT_MAX - 1;
+
+    // Right-aligned so the digits keep their cells as the value grows, too long a value is cut
+    int length = strlen(value);
+    int padding = cells > length ? cells - length : 0;
+
+    memset(widget->text, ' ', padding);
+    strncpy(widget->text + padding, value, cells - padding);
+    widget->text[cells] = '\0';
+
+    widget->glyphs = &glyphs;
+    widget->font = glyphs.getFont();
+    widget->color = color;
+    widget->x = x;
+    widget->y = y;
+    widget->cells = cells;
+
+    widget->boundsX = x;
+    widget->boundsY = y + glyphs.getCellTop();
+    widget->boundsWidth = cells * glyphs.getCellWidth();
+    widget->boundsHeight = glyphs.getCellHeight();
+}
+
+// A frame still going out is completed first, its operations refer to the current widgets
+void CarrierGfxScreen::endFrame() {
+    if (this->isBusy()) {
+        this->flush();
+    }
+
+    this->operationCount = 0;
+    this->operationIndex = 0;
+    this->operationRow = 0;
+
+    if (!this->valid || this->pendingPage != this->page) {
+        this->queue(0, 0, this->display.width(), this->display.height(), -1);
+
+        for (size_t i = 0; i < this->pendingCount; i++) {
+            const Widget& widget = this->pending[i];
+            this->queue(widget.boundsX, widget.boundsY, widget.boundsWidth, widget.boundsHeight, i);
+        }
+    } else {
+        size_t count = this->widgetCount > this->pendingCount ? this->widgetCount : this->pendingCount;
+
+        for (size_t i = 0; i < count; i++) {
+            bool hadOld = i < this->widgetCount;
+            bool hasNew = i < this->pendingCount;
+
+            if (hadOld && hasNew && this->sameWidget(this->widgets[i], this->pending[i])) {
+                continue;
+            }
+
+            // Cells are opaque, the span from the first to the last changed one is simply repainted
+            if (hadOld && hasNew && this->sameField(this->widgets[i], this->pending[i])) {
+                const Widget& widget = this->pending[i];
+                int first = 0;
+                int last = widget.cells - 1;
+
+                while (widget.text[first] == this->widgets[i].text[first]) {
+                    first++;
+                }
+                while (widget.text[last] == this->widgets[i].text[last]) {
+                    last--;
+                }
+
+                int cellWidth = widget.glyphs->getCellWidth();
+                this->queue(widget.x + first * cellWidth, widget.boundsY, (last - first + 1) * cellWidth, widget.boundsHeight, i);
+                continue;
+            }
+
+            if (hadOld) {
+                const Widget& widget = this->widgets[i];
+                this->queue(widget.boundsX, widget.boundsY, widget.boundsWidth, widget.boundsHeight, -1);
+            }
+            if (hasNew) {
+                const Widget& widget = this->pending[i];
+                this->queue(widget.boundsX, widget.boundsY, widget.boundsWidth, widget.boundsHeight, i);
+            }
+        }
+    }
+
+    memcpy(this->widgets, this->pending, this->pendingCount * sizeof(Widget));
+    this->widgetCount = this->pendingCount;
+    this->page = this->pendingPage;
+    this->valid = true;
+}
+
+// Draws whatever is left of the frame with the blocking primitives
+void CarrierGfxScreen::flush() {
+    this->finishTransfer();
+    if (this->bandReady) {
+        this->sendBand();
+        this->finishTransfer();
+    }
+
+    for (; this->operationIndex < this->operationCount; this->operationIndex++) {
+        const Operation& operation = this->operations[this->operationIndex];
+
+        if (operation.widget < 0) {
+            this->display.fillRect(operation.x, operation.y, operation.width, operation.height, GFX_SCREEN_BACKGROUND);
+            continue;
+        }
+
+        const Widget& widget = this->widgets[operation.widget];
+
+        if (widget.type == WIDGET_ICON) {
+            drawSprite(this->display, *widget.sprite, widget.color, widget.x, widget.y);
+        } else if (widget.type == WIDGET_FIELD) {
+            this->drawField(widget, operation);
+        } else {
+            drawMessage(this->display, widget.font, widget.x, widget.y, widget.color, widget.text);
+        }
+    }
+
+    this->operationRow = 0;
+}
+
+// Renders the next band while the previous one is still on the bus, and gives the rest of
+// the budget back once there is nothing left to do but wait for the transfer
+void CarrierGfxScreen::flushAsync(unsigned long budgetUs) {
+    unsigned long start = micros();
+
+    while (this->isBusy() && micros() - start < budgetUs) {
+        if (!this->bandReady && this->operationIndex < this->operationCount) {
+            this->renderBand();
+            continue;
+        }
+
+#if defined(USE_SPI_DMA)
+        if (this->transferring && this->display.dmaBusy()) {
+            return;
+        }
+#endif
+
+        this->finishTransfer();
+        if (this->bandReady) {
+            this->sendBand();
+        }
+    }
+}
+
+bool CarrierGfxScreen::isBusy() {
+    return this->operationIndex < this->operationCount || this->bandReady || this->transferring;
+}
+
+// Waits for the band in flight and lets go of chip select, so another device on the SPI bus
+// can be used in between. The frame carries on with the next flushAsync().
+void CarrierGfxScreen::releaseBus() {
+    this->finishTransfer();
+}
+
+void CarrierGfxScreen::invalidate() {
+    this->valid = false;
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+CarrierGfxScreen::Widget* CarrierGfxScreen::nextWidget(WidgetType type) {
+    if (this->pendingCount >= GFX_SCREEN_WIDGETS_MAX) {
+        return NULL;
+    }
+
+    Widget* widget = &this->pending[this->pendingCount++];
+    memset(widget, 0, sizeof(Widget));
+    widget->type = type;
+
+    return widget;
+}
+
+bool CarrierGfxScreen::sameWidget(const Widget& a, const Widget& b) {
+    if (a.type != b.type || a.x != b.x || a.y != b.y || a.color != b.color) {
+        return false;
+    }
+
+    if (a.type == WIDGET_ICON) {
+        return a.sprite == b.sprite;
+    }
+
+    return a.font == b.font && a.glyphs == b.glyphs && a.cells == b.cells && strcmp(a.text, b.text) == 0;
+}
+
+// Same field in the same place, only the value may differ
+bool CarrierGfxScreen::sameField(const Widget& a, const Widget& b) {
+    return a.type == WIDGET_FIELD && b.type == WIDGET_FIELD && a.glyphs == b.glyphs && a.cells == b.cells &&
+        a.x == b.x && a.y == b.y && a.color == b.color;
+}
+
+// Clipped to the screen, a widget is painted over its bounds cleared to the background
+void CarrierGfxScreen::queue(int x, int y, int width, int height, int widget) {
+    int right = x + width < this->display.width() ? x + width : this->display.width();
+    int bottom = y + height < this->display.height() ? y + height : this->display.height();
+
+    x = x > 0 ? x : 0;
+    y = y > 0 ? y : 0;
+    if (x >= right || y >= bottom || this->operationCount >= GFX_SCREEN_OPS_MAX) {
+        return;
+    }
+
+    Operation& operation = this->operations[this->operationCount++];
+    operation.x = x;
+    operation.y = y;
+    operation.width = right - x;
+    operation.height = bottom - y;
+    operation.widget = widget;
+}
+
+// Every cell the operation covers goes out as its own sprite
+void CarrierGfxScreen::drawField(const Widget& widget, const Operation& operation) {
+    int cellWidth = widget.glyphs->getCellWidth();
+    int last = (operation.x + operation.width - 1 - widget.x) / cellWidth;
+
+    for (int cell = (operation.x - widget.x) / cellWidth; cell <= last; cell++) {
+        drawSprite(this->display, widget.glyphs->getGlyph(widget.text[cell]), widget.color, widget.x + cell * cellWidth, widget.boundsY);
+    }
+}
+
+void CarrierGfxScreen::renderBand() {
+    const Operation& operation = this->operations[this->operationIndex];
+    int rows = GFX_SCREEN_BAND_PIXELS / operation.width;
+
+    if (rows > operation.height - this->operationRow) {
+        rows = operation.height - this->operationRow;
+    }
+
+    this->band.pixels = this->bands[this->bandBuffer];
+    this->band.x = operation.x;
+    this->band.y = operation.y + this->operationRow;
+    this->band.width = operation.width;
+    this->band.rows = rows;
+
+    for (int i = 0; i < operation.width * rows; i++) {
+        this->band.pixels[i] = GFX_SCREEN_BACKGROUND;
+    }
+
+    if (operation.widget >= 0) {
+        const Widget& widget = this->widgets[operation.widget];
+
+        if (widget.type == WIDGET_ICON) {
+            renderSprite(this->band, *widget.sprite, widget.color, widget.x, widget.y);
+        } else if (widget.type == WIDGET_FIELD) {
+            int cellWidth = widget.glyphs->getCellWidth();
+            int last = (this->band.x + this->band.width - 1 - widget.x) / cellWidth;
+
+            for (int cell = (this->band.x - widget.x) / cellWidth; cell <= last; cell++) {
+                renderSprite(this->band, widget.glyphs->getGlyph(widget.text[cell]), widget.color, widget.x + cell * cellWidth, widget.boundsY);
+            }
+        } else {
+            renderMessage(this->band, widget.font, widget.x, widget.y, widget.color, widget.text, this->display.width());
+        }
+    }
+
+    this->operationRow += rows;
+    if (this->operationRow >= operation.height) {
+        this->operationIndex++;
+        this->operationRow = 0;
+    }
+
+    this->bandReady = true;
+}
+
+// With DMA the chip select stays asserted until finishTransfer() sees the transfer done
+void CarrierGfxScreen::sendBand() {
+    this->display.startWrite();
+    this->display.setAddrWindow(this->band.x, this->band.y, this->band.width, this->band.rows);
+
+#if defined(USE_SPI_DMA)
+    this->display.writePixels(this->band.pixels, this->band.width * this->band.rows, false);
+    this->transferring = true;
+#else
+    this->display.writePixels(this->band.pixels, this->band.width * this->band.rows);
+    this->display.endWrite();
+#endif
+
+    this->bandBuffer ^= 1;
+    this->bandReady = false;
+}
+
+void CarrierGfxScreen::finishTransfer() {
+    if (!this->transferring) {
+        return;
+    }
+
+    this->display.dmaWait();
+    this->display.endWrite();
+    this->transferring = false;
+}
@@ -8,7 +8,33 @@
 
 #include "CarrierManager.h"
 
+#include "BufferWriter.h"
 #include "CarrierGfxDrawFunctions.h"
+#include "Profiler.h"
+
+
+#define GFX_UPDATE_MIN_INTERVAL_MS 250
+#define GFX_FLUSH_BUDGET_US 2000        // display time per gfxLoop() while a frame is going out
+// #define GFX_FLUSH_SYNC                  // draw each frame at once with the blocking primitives
+// #define GFX_TEXT_FIELDS                 // no glyph caches, values are drawn as proportional text
+
+#define IMU_FIFO_DRAIN_MS 100           // ~10 sets at 104 Hz, far from the 682 sets the FIFO holds
+#define IMU_FIFO_WINDOW_MS 1000
+#define IMU_FIFO_GYRO_Q16_Q8 17872      // FIFO gyroscope LSB to Q16 rad/s, in Q8: 2000 / 32768 · π / 180 · 2^16 · 2^8
+
+#define SENSOR_HISTORY_PERIOD_MS 1000   // 640 samples, at least 10 minutes of history
+
+#define SENSOR_LOG_PATH "SENSORS.LOG"
+#define SENSOR_LOG_DEVICE_BLOCKS 4096   // 2 MB, 45056 records or 5 days at SENSOR_LOG_PERIOD_MS
+#define SENSOR_LOG_PERIOD_MS 10000
+#define SENSOR_LOG_FLUSH_MS 60000       // longest a record waits in RAM before it reaches the card
+
+// #define GESTURE_INTERRUPT_PIN <pin>      // APDS9960 INT wired to an interrupt pin, otherwise inputsLoop() polls
+
+
+void imuStatistics(const LSM6DS3Fifo::Window& window, int axis, float scale, CarrierManager::LSM6DS3_AxisStatistics& statistics);
+void imuSampleStatistics(float value, CarrierManager::LSM6DS3_AxisStatistics& statistics);
+const char* gfxFormatChannel(char* text, size_t size, int32_t value, uint8_t decimals, uint8_t scale = SENSOR_SNAPSHOT_DECIMALS);
 
 
 // ---------------
@@ -31,20 +57,53 @@ int CarrierManager::setPIR(bool usePIR) {
     return CarrierManager::PIR;
 }
 
+// Burst acquisition through the LSM6DS3 FIFO, ignored on carriers with the LSM6DSOX
+int CarrierManager::setIMUFifo(bool useFifo) {
+    if (CarrierManager::IMU_FIFO > -1) {
+        CarrierManager::IMU_FIFO = (useFifo ? 1 : 0);
+    }
+
+    return CarrierManager::IMU_FIFO;
+}
+
+int CarrierManager::setSensorLog(bool useLog) {
+    if (CarrierManager::LOG > -1) {
+        CarrierManager::LOG = (useLog ? 1 : 0);
+    }
+
+    return CarrierManager::LOG;
+}
+
+// Default period for the sensor groups without one set through setSensorPeriod()
 unsigned long CarrierManager::setSensorsUpdateTimeout(unsigned long timeout) {
     CarrierManager::SENSORS_UPDATE_TIMEOUT_MS = timeout;
+
+    return CarrierManager::SENSORS_UPDATE_TIMEOUT_MS;
 }
 
 // ---------------
 // CONSTRUCTORS & DESTRUCTORS
 // ---------------
 
-CarrierManager::CarrierManager() {
+CarrierManager::CarrierManager() : screen(carrier.display), glyphs18(&FreeSans18pt7b), glyphs12(&FreeSans12pt7b),
+        glyphs9(&FreeSans9pt7b), imuFifo(Wire), logDevice(SENSOR_LOG_PATH, SENSOR_LOG_DEVICE_BLOCKS, SD_CS),
+        sensorLog(logDevice) {
+    this->sensorsGeneration = 0;
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        this->sensorGenerations[group] = 0;
+        this->sensorUpdateMs[group] = 0;
+    }
+    this->sensorsUpdateHook = NULL;
+    this->inputEventHook = NULL;
+    this->orientationEnabled = false;
 }
 
 CarrierManager::~CarrierManager() {
     CarrierManager::CASE = 0;
     CarrierManager::PIR = 0;
+    CarrierManager::PIR_PIN = -1;
+    CarrierManager::IMU_FIFO = 0;
+    CarrierManager::LOG = 0;
     CarrierManager::SENSORS_UPDATE_TIMEOUT_MS = 1000;
 }
 
@@ -63,7 +122,8 @@ void CarrierManager::begin() {
     CarrierManager::CASE = -1;
 
     if (CarrierManager::PIR > 0) {
-        pinMode((this->carrier.getBoardRevision() == 1 ? A5 : A0), INPUT);
+        CarrierManager::PIR_PIN = (this->carrier.getBoardRevision() == 1 ? A5 : A0);
+        pinMode(CarrierManager::PIR_PIN, INPUT);
     }
 
     CarrierManager::PIR = -1;
@@ -76,25 +136,117 @@ void CarrierManager::begin() {
     this->buttonsInit();
     this->ledsInit();
     this->sensorsInit();
+    this->inputEventsInit();
+
+    if (CarrierManager::LOG > 0) {
+        this->sensorLog.begin(millis());
+    }
+
+    CarrierManager::LOG = -1;
+    this->lastLogMs = millis();
+    this->lastHistoryMs = millis();
+
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        if (!this->sensorGroupEnabled(group)) {
+            this->sensorScheduler.setPeriod(group, 0);
+        } else if (this->imu.fifo && group == SENSOR_GROUP_ACCELEROMETER) {
+            this->sensorScheduler.setPeriod(group, IMU_FIFO_DRAIN_MS);
+        } else if (this->imu.fifo && group == SENSOR_GROUP_GYROSCOPE) {
+            this->sensorScheduler.setPeriod(group, 0);      // drained with the accelerometer
+        } else if (group == SENSOR_GROUP_GESTURE) {
+            this->sensorScheduler.setPeriod(group, 0);      // read by inputsLoop()
+        } else if (this->sensorScheduler.getPeriod(group) == 0) {
+            this->sensorScheduler.setPeriod(group, CarrierManager::SENSORS_UPDATE_TIMEOUT_MS);
+        }
+
+        // Disabled groups keep generation 0 instead of publishing values never read
+        if (this->sensorGroupEnabled(group)) {
+            this->sensorsUpdate(group);
+        }
+    }
+    this->sensorScheduler.start(millis());
 
-    this->sensorsUpdate();
-    this->lastLoopFunction = -1;
     this->selectedFunction = 0;
     this->lastSensorsUpdateDrawn = false;
-    this->lastSensorsUpdateMs = millis();
     this->gfxUpdate();
+    this->screen.flush();
+    this->lastLoopFunction = this->selectedFunction;
+    this->lastSensorsUpdateDrawn = true;
+    this->lastGfxUpdateMs = millis();
 }
 void CarrierManager::loop() {
-    if (millis() > this->lastSensorsUpdateMs + CarrierManager::SENSORS_UPDATE_TIMEOUT_MS) {
-        this->sensorsUpdate();
+    this->sensorsLoop();
+    this->inputsLoop();
+    this->gfxLoop();
+    this->logLoop();
+}
+
+// The four parts of loop(), for callers that run them as separate tasks
+
+void CarrierManager::sensorsLoop() {
+    PROFILE_SCOPE(PROFILE_PHASE_SENSORS);
+
+    int group = this->sensorScheduler.next(millis());
+    if (group >= 0 && this->sensorsUpdate(group)) {
         this->lastSensorsUpdateDrawn = false;
-        this->lastSensorsUpdateMs = millis();
     }
+
+    unsigned long now = millis();
+    if (now - this->lastHistoryMs >= SENSOR_HISTORY_PERIOD_MS) {
+        this->historyUpdate(now);
+        this->lastHistoryMs = now;
+    }
+}
+
+void CarrierManager::inputsLoop() {
     this->buttonsUpdate();
     this->ledsUpdate();
-    if (!this->lastSensorsUpdateDrawn || this->lastLoopFunction != this->selectedFunction) {
+}
+
+void CarrierManager::gfxLoop() {
+    PROFILE_SCOPE(PROFILE_PHASE_GFX);
+
+    // The next frame waits until the current one is out
+    if (this->screen.isBusy()) {
+        this->screen.flushAsync(GFX_FLUSH_BUDGET_US);
+        return;
+    }
+
+    if (this->lastLoopFunction != this->selectedFunction ||
+            (!this->lastSensorsUpdateDrawn && millis() - this->lastGfxUpdateMs >= GFX_UPDATE_MIN_INTERVAL_MS)) {
         this->gfxUpdate();
+        this->lastLoopFunction = this->selectedFunction;
         this->lastSensorsUpdateDrawn = true;
+        this->lastGfxUpdateMs = millis();
+    }
+}
+
+// Takes a record every SENSOR_LOG_PERIOD_MS and writes the RAM block once it is full or has
+// waited SENSOR_LOG_FLUSH_MS. The card shares the SPI bus with the display, so nothing is
+// written while a frame is going out; the next call tries again.
+void CarrierManager::logLoop() {
+    PROFILE_SCOPE(PROFILE_PHASE_LOG);
+
+    if (!this->sensorLog.isReady()) {
+        return;
+    }
+
+    unsigned long now = millis();
+
+    if (now - this->lastLogMs >= SENSOR_LOG_PERIOD_MS) {
+        SensorSnapshot snapshot;
+        uint32_t sequence;
+
+        do {
+            snapshot = this->snapshots.read(sequence);
+        } while (!this->snapshots.valid(sequence));
+
+        this->sensorLog.append(snapshot, now);
+        this->lastLogMs = now;
+    }
+
+    if (this->sensorLog.isFlushDue(now, SENSOR_LOG_FLUSH_MS) && !this->screen.isBusy()) {
+        this->sensorLog.flush();
     }
 }
 
@@ -107,10 +259,67 @@ CarrierManager::LPS22HB_PressureSensor CarrierManager::getPressureSensor() {
 CarrierManager::LSM6DS3_IMUSensor CarrierManager::getIMUSensor() {
     return this->imu;
 }
+// The filter state is converted to floats here, only when someone asks for it
+CarrierManager::LSM6DS3_Orientation CarrierManager::getOrientation() {
+    LSM6DS3_Orientation orientation;
+
+    this->orientationFilter.getQuaternion(orientation.qw, orientation.qx, orientation.qy, orientation.qz);
+    this->orientationFilter.getEuler(orientation.roll, orientation.pitch, orientation.yaw);
+    orientation.enabled = this->orientationEnabled;
+
+    return orientation;
+}
 CarrierManager::APDS9960_LightSensor CarrierManager::getLightSensor() {
     return this->light;
 }
 
+SensorHistory& CarrierManager::getHistory() {
+    return this->history;
+}
+
+// The readings in fixed point, one consistent set per refresh
+const SensorSnapshotBuffer& CarrierManager::getSnapshots() {
+    return this->snapshots;
+}
+
+const SensorLog& CarrierManager::getSensorLog() {
+    return this->sensorLog;
+}
+
+// Reads answer requests and cannot wait for the frame to end: they only wait for the band in flight
+void CarrierManager::seekSensorLog(SensorLog::Cursor& cursor, uint32_t time) {
+    this->screen.releaseBus();
+    this->sensorLog.seek(cursor, time);
+}
+
+bool CarrierManager::nextSensorLog(SensorLog::Cursor& cursor, SensorLogRecord& record) {
+    this->screen.releaseBus();
+    return this->sensorLog.next(cursor, record);
+}
+
+// Seconds, e.g. the Unix time once the network has it
+void CarrierManager::setSensorLogTime(uint32_t time) {
+    this->sensorLog.setTime(time, millis());
+}
+
+// A group only moves when its own values change
+unsigned long CarrierManager::getSensorGeneration(int group) {
+    return this->sensorGenerations[this->sensorGroupSource(group)];
+}
+unsigned long CarrierManager::getSensorUpdateMs(int group) {
+    return this->sensorUpdateMs[this->sensorGroupSource(group)];
+}
+// 0 when the refresh is due or the group is not scheduled
+unsigned long CarrierManager::getSensorTimeUntilUpdate(int group) {
+    int source = this->sensorGroupSource(group);
+
+    if (this->sensorScheduler.getPeriod(source) == 0) {
+        return 0;
+    }
+
+    return this->sensorScheduler.timeUntil(source, millis());
+}
+
 void CarrierManager::enableEnvironmentSensorUpdates(bool enable){
     this->environment.enabled = enable;
 }
@@ -129,9 +338,33 @@ void CarrierManager::enableRGBSensorUpdates(bool enable){
 void CarrierManager::enableGestureSensorUpdates(bool enable){
     this->light.gesture.enabled = enable;
 }
+// Needs the accelerometer and the gyroscope, runs on the SENSOR_GROUP_ORIENTATION period
+void CarrierManager::enableOrientationUpdates(bool enable){
+    this->orientationEnabled = enable;
+}
+
+// Set before begin(), 0 selects the default SENSORS_UPDATE_TIMEOUT_MS
+void CarrierManager::setSensorPeriod(SensorGroup group, unsigned long period) {
+    this->sensorScheduler.setPeriod(group, period);
+}
+
+void CarrierManager::setSensorsUpdateHook(SensorsUpdateHook hook) {
+    this->sensorsUpdateHook = hook;
+}
+
+// Called from inputsLoop() for every touch, motion and gesture event, oldest first
+void CarrierManager::setInputEventHook(InputEventHook hook) {
+    this->inputEventHook = hook;
+}
+
+// Interrupt events lost because inputsLoop() fell more than INPUT_EVENT_QUEUE_SIZE behind
+unsigned long CarrierManager::getDroppedInputEvents() {
+    return CarrierManager::INTERRUPT_EVENTS.getDropped();
+}
 
 void CarrierManager::setMessage(String msg){
     this->message = msg;
+    this->lastSensorsUpdateDrawn = false;
 }
 
 String CarrierManager::getMessage() {
@@ -144,63 +377,100 @@ String CarrierManager::getMessage() {
 
 int CarrierManager::CASE = 0;
 int CarrierManager::PIR = 0;
+int CarrierManager::IMU_FIFO = 0;
+int CarrierManager::LOG = 0;
 unsigned long CarrierManager::SENSORS_UPDATE_TIMEOUT_MS = 1000;
+InputEventQueue CarrierManager::INTERRUPT_EVENTS;
+int CarrierManager::PIR_PIN = -1;
 
 // GFX
 
+// Fields fall back to proportional text when their cache is not ready, which makes
+// GFX_TEXT_FIELDS a way to compare both paths in the gfx phase of the profiler
 void CarrierManager::gfxInit() {
     this->carrier.display.setRotation(0);
+
+#ifndef GFX_TEXT_FIELDS
+    this->glyphs18.begin();
+    this->glyphs12.begin();
+    this->glyphs9.begin();
+#endif
 }
 
 
 void CarrierManager::gfxUpdate() {
-    cleanDisplay(this->carrier.display);
-    switch (this->selectedFunction) {
-        case 0:
+    uint32_t sequence;
+    char text[GFX_SCREEN_TEXT_MAX];
+
+    // The widgets copy their values, a frame declared from a snapshot that changed meanwhile is declared again
+    do {
+        const SensorSnapshot& snapshot = this->snapshots.read(sequence);
+
+        this->screen.beginFrame(this->selectedFunction);
+        switch (this->selectedFunction) {
+            case 0:
 
-            // TEMPERATURE
-            drawThermometerIcon(this->carrier.display, 0x07E0, 45, 50);
+                // TEMPERATURE
+                this->screen.icon(GFX_THERMOMETER_SPRITE, 0x07E0, 45, 50);
 
-            drawMessage(this->carrier.display, &FreeSans18pt7b, 100, 95, 0xFFFF, String((int) this->environment.temperature) + " C");
+                this->screen.field(this->glyphs18, 100, 95, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_TEMPERATURE], 0), 3);
+                this->screen.text(&FreeSans18pt7b, 167, 95, 0xFFFF, "C");
 
-            // HUMIDITY
-            drawDropletIcon(this->carrier.display, 0x07FF, 40, 130);
+                // HUMIDITY
+                this->screen.icon(GFX_DROPLET_SPRITE, 0x07FF, 40, 130);
 
-            drawMessage(this->carrier.display, &FreeSans18pt7b, 100, 175, 0xFFFF, String((int) this->environment.humidity) + " %");
+                this->screen.field(this->glyphs18, 100, 175, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_HUMIDITY], 0), 3);
+                this->screen.text(&FreeSans18pt7b, 167, 175, 0xFFFF, "%");
         
-            break;
+                break;
         
-        case 1:
-            // ACCELEROMETER
+            case 1:
+                // ACCELEROMETER
 
-            drawMovementIcon(this->carrier.display, 0x001F, 30, 50);
+                this->screen.icon(GFX_MOVEMENT_SPRITE, 0x001F, 30, 50);
 
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 70, 0xFFFF, "X: " + String(this->imu.accelerometer.x));
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 90, 0xFFFF, "Y: " + String(this->imu.accelerometer.y));
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 110, 0xFFFF, "Z: " + String(this->imu.accelerometer.z));
+                this->screen.text(&FreeSans9pt7b, 100, 70, 0xFFFF, "X:");
+                this->screen.field(this->glyphs9, 122, 70, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_X], 2), 5);
+                this->screen.text(&FreeSans9pt7b, 100, 90, 0xFFFF, "Y:");
+                this->screen.field(this->glyphs9, 122, 90, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_Y], 2), 5);
+                this->screen.text(&FreeSans9pt7b, 100, 110, 0xFFFF, "Z:");
+                this->screen.field(this->glyphs9, 122, 110, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_Z], 2), 5);
             
-            // GYROSCOPE
+                // GYROSCOPE
             
-            drawRotationIcon(this->carrier.display, 0xF800, 30, 130);
-
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 150, 0xFFFF, "X: " + String(this->imu.gyroscope.x));
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 170, 0xFFFF, "Y: " + String(this->imu.gyroscope.y));
-            drawMessage(this->carrier.display, &FreeSans9pt7b, 100, 190, 0xFFFF, "Z: " + String(this->imu.gyroscope.z));
-
-            break;
-        case 2:
-            // PRESSURE
-
-            drawPressureIcon(this->carrier.display, 0xFFE0, 30, 85);
-
-            drawMessage(this->carrier.display, &FreeSans12pt7b, 100, 120, 0xFFFF, String(this->pressure.pressure) + " kPa");
-
-            break;
-        case 4:
-            // MESSAGE
-            drawMessage(this->carrier.display, &FreeSans12pt7b, 20, 120, 0xFFFF, this->message);
-            break;
-    }
+                this->screen.icon(GFX_ROTATION_SPRITE, 0xF800, 30, 130);
+
+                this->screen.text(&FreeSans9pt7b, 100, 150, 0xFFFF, "X:");
+                this->screen.field(this->glyphs9, 122, 150, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_X], 2), 8);
+                this->screen.text(&FreeSans9pt7b, 100, 170, 0xFFFF, "Y:");
+                this->screen.field(this->glyphs9, 122, 170, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_Y], 2), 8);
+                this->screen.text(&FreeSans9pt7b, 100, 190, 0xFFFF, "Z:");
+                this->screen.field(this->glyphs9, 122, 190, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_Z], 2), 8);
+
+                break;
+            case 2:
+                // PRESSURE
+
+                this->screen.icon(GFX_PRESSURE_SPRITE, 0xFFE0, 30, 85);
+
+                this->screen.field(this->glyphs12, 100, 120, 0xFFFF, gfxFormatChannel(text, sizeof(text), snapshot.channels[SENSOR_CHANNEL_PRESSURE], 2, SENSOR_SNAPSHOT_DECIMALS + 3), 6);
+                this->screen.text(&FreeSans12pt7b, 185, 120, 0xFFFF, "kPa");
+
+                break;
+            case 4:
+                // MESSAGE
+                this->screen.text(&FreeSans12pt7b, 20, 120, 0xFFFF, this->message);
+                break;
+        }
+    } while (!this->snapshots.valid(sequence));
+
+    this->screen.endFrame();
+
+#ifdef GFX_FLUSH_SYNC
+    this->screen.flush();
+#else
+    this->screen.flushAsync(GFX_FLUSH_BUDGET_US);
+#endif
 }
 
 // BUTTONS
@@ -209,26 +479,103 @@ void CarrierManager::buttonsInit() {
 }
 
 void CarrierManager::buttonsUpdate() {
+    PROFILE_SCOPE(PROFILE_PHASE_BUTTONS);
+
     this->carrier.Buttons.update();
 
-    this->lastLoopFunction = this->selectedFunction;
+    int pad = -1;
 
     if (this->carrier.Buttons.onTouchDown(TOUCH0)) {
-        //this->carrier.Buzzer.beep();
-        this->selectedFunction = 0;
+        pad = 0;
     } else if (this->carrier.Buttons.onTouchDown(TOUCH1)) {
-        //this->carrier.Buzzer.beep();
-        this->selectedFunction = 1;
+        pad = 1;
     } else if (this->carrier.Buttons.onTouchDown(TOUCH2)) {
-        //this->carrier.Buzzer.beep();
-        this->selectedFunction = 2;
+        pad = 2;
     } else if (this->carrier.Buttons.onTouchDown(TOUCH3)) {
-        //this->carrier.Buzzer.beep();
-        this->selectedFunction = 3;
+        pad = 3;
     } else if (this->carrier.Buttons.onTouchDown(TOUCH4)) {
-        //this->carrier.Buzzer.beep();
-        this->selectedFunction = 4;
+        pad = 4;
     }
+
+    // The pads are polled through the PTC, so their events never go through the interrupt queue
+    if (pad >= 0) {
+        InputEvent event = { millis(), INPUT_EVENT_TOUCH, (int8_t) pad };
+        this->inputEvent(event);
+    }
+
+    // Timed with the pads
+    this->inputEventsUpdate();
+}
+
+// INPUT EVENTS
+
+// Every attachInterrupt() callback runs from the same EIC handler, so the handlers below never
+// preempt each other and the queue keeps a single producer
+void CarrierManager::inputEventsInit() {
+    if (CarrierManager::PIR_PIN >= 0) {
+        attachInterrupt(digitalPinToInterrupt(CarrierManager::PIR_PIN), CarrierManager::pirInterrupt, CHANGE);
+    }
+
+#ifdef GESTURE_INTERRUPT_PIN
+    if (this->light.gesture.enabled) {
+        pinMode(GESTURE_INTERRUPT_PIN, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(GESTURE_INTERRUPT_PIN), CarrierManager::gestureInterrupt, FALLING);
+    }
+#endif
+}
+
+// The APDS9960 sits on I2C, which cannot be used from an interrupt: its handler only queues a
+// marker and the gesture is read here. Without the INT pin the sensor is polled on every call.
+void CarrierManager::inputEventsUpdate() {
+    InputEvent event;
+
+    while (CarrierManager::INTERRUPT_EVENTS.pop(event)) {
+        if (event.type == INPUT_EVENT_GESTURE_PENDING) {
+            if (!this->carrier.Light.gestureAvailable()) {
+                continue;
+            }
+
+            event.type = INPUT_EVENT_GESTURE;
+            event.value = this->carrier.Light.readGesture();
+        }
+
+        this->inputEvent(event);
+    }
+
+#ifndef GESTURE_INTERRUPT_PIN
+    if (this->light.gesture.enabled && this->carrier.Light.gestureAvailable()) {
+        InputEvent gesture = { millis(), INPUT_EVENT_GESTURE, (int8_t) this->carrier.Light.readGesture() };
+        this->inputEvent(gesture);
+    }
+#endif
+}
+
+void CarrierManager::inputEvent(const InputEvent& event) {
+    switch (event.type) {
+        case INPUT_EVENT_TOUCH:
+            //this->carrier.Buzzer.beep();
+            this->selectedFunction = event.value;
+            break;
+        case INPUT_EVENT_GESTURE:
+            this->light.gesture.gesture = event.value;
+            this->sensorUpdateMs[SENSOR_GROUP_GESTURE] = event.time;
+            this->sensorGenerations[SENSOR_GROUP_GESTURE]++;
+            break;
+    }
+
+    if (this->inputEventHook != NULL) {
+        this->inputEventHook(event);
+    }
+}
+
+void CarrierManager::pirInterrupt() {
+    InputEvent event = { millis(), INPUT_EVENT_MOTION, (int8_t) digitalRead(CarrierManager::PIR_PIN) };
+    CarrierManager::INTERRUPT_EVENTS.push(event);
+}
+
+void CarrierManager::gestureInterrupt() {
+    InputEvent event = { millis(), INPUT_EVENT_GESTURE_PENDING, 0 };
+    CarrierManager::INTERRUPT_EVENTS.push(event);
 }
 
 // LEDS
@@ -241,9 +588,19 @@ void CarrierManager::ledsInit() {
     this->carrier.leds.setPixelColor(3, 0, 255, 255);
     this->carrier.leds.setPixelColor(4, 0, 0, 255);
     this->carrier.leds.show();
+
+    this->lastLedsFunction = -1;
 }
 
+// The LED strip is only rewritten when the selection changes
 void CarrierManager::ledsUpdate() {
+    PROFILE_SCOPE(PROFILE_PHASE_LEDS);
+
+    if (this->lastLedsFunction == this->selectedFunction) {
+        return;
+    }
+    this->lastLedsFunction = this->selectedFunction;
+
     this->carrier.leds.clear();
     this->carrier.leds.setPixelColor(0, 0, 0, 0);
     this->carrier.leds.setPixelColor(1, 0, 0, 0);
@@ -261,46 +618,268 @@ void CarrierManager::sensorsInit() {
     this->carrier.Pressure.begin();
     this->carrier.IMUmodule.begin();
     this->carrier.Light.begin();
+
+    this->imu.windowSamples = 1;
+    this->imu.overrun = false;
+    this->imu.fifo = CarrierManager::IMU_FIFO > 0 && this->carrier.getBoardRevision() == 1 && this->imuFifo.begin();
+    this->imuWindowStartMs = millis();
+    this->orientationUpdateMs = millis();
+    this->orientationSetTicks = 0;
+
+    if (this->imu.fifo) {
+        this->imuFifo.setSetHook(CarrierManager::orientationSet, this);
+    }
+
+    CarrierManager::IMU_FIFO = -1;
 }
 
-void CarrierManager::sensorsUpdate() {
-    if (this->environment.enabled) {
-        this->environment.temperature = this->carrier.Env.readTemperature();
-        this->environment.humidity = this->carrier.Env.readHumidity();
+// Reads a single sensor group, the scheduler spreads the groups across loop iterations.
+// Returns false when nothing was published, e.g. a FIFO drain in the middle of a window.
+bool CarrierManager::sensorsUpdate(int group) {
+    switch (group) {
+        case SENSOR_GROUP_ENVIRONMENT:
+            if (this->environment.enabled) {
+                this->environment.temperature = this->carrier.Env.readTemperature();
+                this->environment.humidity = this->carrier.Env.readHumidity();
+            }
+            break;
+        case SENSOR_GROUP_PRESSURE:
+            if (this->pressure.enabled) {
+                this->pressure.pressure = this->carrier.Pressure.readPressure();
+            }
+            break;
+        case SENSOR_GROUP_ACCELEROMETER:
+            if (this->imu.fifo) {
+                // Nothing to publish until the window closes
+                if (!this->imuFifoUpdate()) {
+                    return false;
+                }
+            } else if (this->imu.accelerometer.enabled && this->carrier.IMUmodule.accelerationAvailable()) {
+                this->carrier.IMUmodule.readAcceleration(this->imu.accelerometer.x, this->imu.accelerometer.y, this->imu.accelerometer.z);
+
+                imuSampleStatistics(this->imu.accelerometer.x, this->imu.accelerometer.statistics.x);
+                imuSampleStatistics(this->imu.accelerometer.y, this->imu.accelerometer.statistics.y);
+                imuSampleStatistics(this->imu.accelerometer.z, this->imu.accelerometer.statistics.z);
+            }
+            break;
+        case SENSOR_GROUP_GYROSCOPE:
+            if (this->imu.gyroscope.enabled && this->carrier.IMUmodule.gyroscopeAvailable()) {
+                this->carrier.IMUmodule.readGyroscope(this->imu.gyroscope.x, this->imu.gyroscope.y, this->imu.gyroscope.z);
+
+                imuSampleStatistics(this->imu.gyroscope.x, this->imu.gyroscope.statistics.x);
+                imuSampleStatistics(this->imu.gyroscope.y, this->imu.gyroscope.statistics.y);
+                imuSampleStatistics(this->imu.gyroscope.z, this->imu.gyroscope.statistics.z);
+            }
+            break;
+        case SENSOR_GROUP_RGB:
+            if (this->light.rgb.enabled && this->carrier.Light.colorAvailable()) {
+                this->carrier.Light.readColor(this->light.rgb.r, this->light.rgb.g, this->light.rgb.b);
+            }
+            break;
+        case SENSOR_GROUP_GESTURE:
+            // Read as input events, see inputEventsUpdate()
+            return false;
+        case SENSOR_GROUP_ORIENTATION:
+            // Internal state only, read through getOrientation()
+            this->orientationUpdate();
+            return false;
     }
 
-    if (this->pressure.enabled) {
-        this->pressure.pressure = this->carrier.Pressure.readPressure();
+    this->lastSensorsUpdateMs = millis();
+    this->sensorsGeneration++;
+    this->sensorUpdateMs[group] = this->lastSensorsUpdateMs;
+    this->sensorGenerations[group]++;
+    this->publishSnapshot();
+
+    if (this->sensorsUpdateHook != NULL) {
+        this->sensorsUpdateHook();
     }
 
-    if (this->imu.accelerometer.enabled && this->carrier.IMUmodule.accelerationAvailable()) {
-        this->carrier.IMUmodule.readAcceleration(this->imu.accelerometer.x, this->imu.accelerometer.y, this->imu.accelerometer.z);
+    return true;
+}
+
+// Samples the latest environment and pressure values on a timer of its own, so that neither
+// group's period decides how fresh the other one's value is
+void CarrierManager::historyUpdate(unsigned long now) {
+    if (!this->environment.enabled && !this->pressure.enabled) {
+        return;
     }
-    if (this->imu.gyroscope.enabled && this->carrier.IMUmodule.gyroscopeAvailable()) {
-        this->carrier.IMUmodule.readGyroscope(this->imu.gyroscope.x, this->imu.gyroscope.y, this->imu.gyroscope.z);
+
+    const float values[SENSOR_HISTORY_CHANNELS] = {
+        this->environment.temperature, this->environment.humidity, this->pressure.pressure * 1000   // kPa to Pa
+    };
+
+    this->history.append(now, values);
+}
+
+bool CarrierManager::sensorGroupEnabled(int group) {
+    switch (group) {
+        case SENSOR_GROUP_ENVIRONMENT:
+            return this->environment.enabled;
+        case SENSOR_GROUP_PRESSURE:
+            return this->pressure.enabled;
+        case SENSOR_GROUP_ACCELEROMETER:
+            return this->imu.accelerometer.enabled || (this->imu.fifo && this->imu.gyroscope.enabled);
+        case SENSOR_GROUP_GYROSCOPE:
+            return this->imu.gyroscope.enabled;
+        case SENSOR_GROUP_RGB:
+            return this->light.rgb.enabled;
+        case SENSOR_GROUP_GESTURE:
+            return this->light.gesture.enabled;
+        case SENSOR_GROUP_ORIENTATION:
+            return this->orientationEnabled && this->imu.accelerometer.enabled && this->imu.gyroscope.enabled;
+        default:
+            return false;
     }
-    
-    if (this->light.rgb.enabled && this->carrier.Light.colorAvailable()) {
-        this->carrier.Light.readColor(this->light.rgb.r, this->light.rgb.g, this->light.rgb.b);
+}
+
+// The group whose reads refresh the values of the given one
+int CarrierManager::sensorGroupSource(int group) {
+    if (this->imu.fifo && group == SENSOR_GROUP_GYROSCOPE) {
+        return SENSOR_GROUP_ACCELEROMETER;      // drained with the accelerometer
     }
-    if (this->light.gesture.enabled && this->carrier.Light.gestureAvailable()) {
-        this->light.gesture.gesture = this->carrier.Light.readGesture();
+
+    return group;
+}
+
+void CarrierManager::publishSnapshot() {
+    SensorSnapshot& snapshot = this->snapshots.edit();
+
+    snapshot.channels[SENSOR_CHANNEL_TEMPERATURE] = sensorFixed(this->environment.temperature);
+    snapshot.channels[SENSOR_CHANNEL_HUMIDITY] = sensorFixed(this->environment.humidity);
+    snapshot.channels[SENSOR_CHANNEL_PRESSURE] = sensorFixed(this->pressure.pressure * 1000);     // kPa to Pa
+    snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_X] = sensorFixed(this->imu.accelerometer.x);
+    snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_Y] = sensorFixed(this->imu.accelerometer.y);
+    snapshot.channels[SENSOR_CHANNEL_ACCELEROMETER_Z] = sensorFixed(this->imu.accelerometer.z);
+    snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_X] = sensorFixed(this->imu.gyroscope.x);
+    snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_Y] = sensorFixed(this->imu.gyroscope.y);
+    snapshot.channels[SENSOR_CHANNEL_GYROSCOPE_Z] = sensorFixed(this->imu.gyroscope.z);
+
+    snapshot.time = this->lastSensorsUpdateMs;
+    snapshot.generation = this->sensorsGeneration;
+
+    this->snapshots.publish();
+}
+
+// Drains the FIFO and, once per IMU_FIFO_WINDOW_MS, turns the integer window into the
+// published statistics. The means also replace the instantaneous x, y, z readings.
+bool CarrierManager::imuFifoUpdate() {
+    this->imuFifo.drain();
+
+    LSM6DS3Fifo::Window& window = this->imuFifo.getWindow();
+    if (millis() - this->imuWindowStartMs < IMU_FIFO_WINDOW_MS || window.samples == 0) {
+        return false;
+    }
+
+    if (this->imu.accelerometer.enabled) {
+        LSM6DS3_WindowStatistics& statistics = this->imu.accelerometer.statistics;
+
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_AX, LSM6DS3Fifo::ACCELEROMETER_SCALE, statistics.x);
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_AY, LSM6DS3Fifo::ACCELEROMETER_SCALE, statistics.y);
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_AZ, LSM6DS3Fifo::ACCELEROMETER_SCALE, statistics.z);
+
+        this->imu.accelerometer.x = statistics.x.mean;
+        this->imu.accelerometer.y = statistics.y.mean;
+        this->imu.accelerometer.z = statistics.z.mean;
+    }
+
+    if (this->imu.gyroscope.enabled) {
+        LSM6DS3_WindowStatistics& statistics = this->imu.gyroscope.statistics;
+
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_GX, LSM6DS3Fifo::GYROSCOPE_SCALE, statistics.x);
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_GY, LSM6DS3Fifo::GYROSCOPE_SCALE, statistics.y);
+        imuStatistics(window, LSM6DS3_FIFO_AXIS_GZ, LSM6DS3Fifo::GYROSCOPE_SCALE, statistics.z);
+
+        this->imu.gyroscope.x = statistics.x.mean;
+        this->imu.gyroscope.y = statistics.y.mean;
+        this->imu.gyroscope.z = statistics.z.mean;
     }
+
+    this->imu.windowSamples = window.samples;
+    this->imu.overrun = this->imuFifo.overrun();
+
+    this->imuFifo.resetWindow();
+    this->imuWindowStartMs = millis();
+
+    return true;
 }
 
-// RELAYS
+// Without the FIFO a fresh sample is read here, so the filter rate does not depend on the
+// accelerometer and gyroscope periods. With it, the FIFO is drained here as well and every
+// set goes through orientationSet(); the window statistics still collect every set.
+void CarrierManager::orientationUpdate() {
+    if (this->imu.fifo) {
+        this->imuFifo.drain();
+        return;
+    }
 
-void CarrierManager::closeRelays() {
-    this->carrier.Relay1.close();
-    this->carrier.Relay2.close();
+    float gx = this->imu.gyroscope.x, gy = this->imu.gyroscope.y, gz = this->imu.gyroscope.z;
+    float ax = this->imu.accelerometer.x, ay = this->imu.accelerometer.y, az = this->imu.accelerometer.z;
+
+    if (this->carrier.IMUmodule.gyroscopeAvailable()) {
+        this->carrier.IMUmodule.readGyroscope(gx, gy, gz);
+    }
+    if (this->carrier.IMUmodule.accelerationAvailable()) {
+        this->carrier.IMUmodule.readAcceleration(ax, ay, az);
+    }
+
+    unsigned long now = millis();
+    this->orientationFilter.update(gx, gy, gz, ax, ay, az, now - this->orientationUpdateMs);
+    this->orientationUpdateMs = now;
 }
 
+// One filter step per FIFO set, 1 / LSM6DS3_FIFO_RATE_HZ apart. The filter takes whole
+// milliseconds, so steps of 9 and 10 ms alternate and the remainder carries over.
+void CarrierManager::orientationSet(const int16_t set[LSM6DS3_FIFO_AXES], void* context) {
+    CarrierManager* manager = (CarrierManager*) context;
+
+    if (!manager->sensorGroupEnabled(SENSOR_GROUP_ORIENTATION)) {
+        return;
+    }
+
+    const int32_t gyro[3] = {
+        ((int32_t) set[LSM6DS3_FIFO_AXIS_GX] * IMU_FIFO_GYRO_Q16_Q8) >> 8,
+        ((int32_t) set[LSM6DS3_FIFO_AXIS_GY] * IMU_FIFO_GYRO_Q16_Q8) >> 8,
+        ((int32_t) set[LSM6DS3_FIFO_AXIS_GZ] * IMU_FIFO_GYRO_Q16_Q8) >> 8
+    };
+    const int32_t accel[3] = { set[LSM6DS3_FIFO_AXIS_AX], set[LSM6DS3_FIFO_AXIS_AY], set[LSM6DS3_FIFO_AXIS_AZ] };
 
-// DRAW METHODS
-void drawMovementIcon(Adafruit_ST7789& display) {
+    manager->orientationSetTicks += 1000;
+    unsigned long dtMs = manager->orientationSetTicks / LSM6DS3_FIFO_RATE_HZ;
+    manager->orientationSetTicks -= dtMs * LSM6DS3_FIFO_RATE_HZ;
 
+    manager->orientationFilter.updateFixed(gyro, accel, dtMs);
 }
 
-void drawRotationIcon(Adafruit_ST7789& display) {
-    
+void imuStatistics(const LSM6DS3Fifo::Window& window, int axis, float scale, CarrierManager::LSM6DS3_AxisStatistics& statistics) {
+    statistics.mean = LSM6DS3Fifo::mean(window, axis) * scale;
+    statistics.min = window.min[axis] * scale;
+    statistics.max = window.max[axis] * scale;
+    statistics.rms = LSM6DS3Fifo::rms(window, axis) * scale;
+}
+
+// Without the FIFO a window is the single sample just read
+void imuSampleStatistics(float value, CarrierManager::LSM6DS3_AxisStatistics& statistics) {
+    statistics.mean = value;
+    statistics.min = value;
+    statistics.max = value;
+    statistics.rms = fabs(value);
+}
+
+// Integer formatting of a snapshot channel with a fixed number of decimals, so digits keep their cells.
+// A larger scale shows the channel in a multiple of its unit, as the pressure in kPa.
+const char* gfxFormatChannel(char* text, size_t size, int32_t value, uint8_t decimals, uint8_t scale) {
+    BufferWriter writer(text, size - 1);
+
+    writer.writeScaled(value, scale, decimals, false);
+    text[writer.length()] = '\0';
+
+    return text;
+}
+
+// RELAYS
+
+void CarrierManager::closeRelays() {
+    this->carrier.Relay1.close();
+    this->carrier.Relay2.close();
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "CoapBlockwise.h"
+
+#include "CoapOptions.h"
+
+
+static char BLOCK_BUFFER[COAP_BLOCK_SIZE(COAP_BLOCK_SZX_MAX)];
+
+
+// A Block2 option longer than 3 bytes, with the reserved SZX 7 or with a NUM that no longer
+// fits once scaled to the server block size is a bad request (RFC 7959 §2.2)
+bool coapBlockValid(const CoapPacket& packet) {
+    const CoapOption* option = coapFindOption(packet, COAP_OPTION_BLOCK2);
+
+    if (option == NULL) {
+        return true;
+    }
+
+    if (option->length > COAP_BLOCK_OPTION_LENGTH_MAX) {
+        return false;
+    }
+
+    unsigned long value = coapOptionUint(*option);
+    unsigned long num = value >> 4;
+    uint8_t szx = value & 0x07;
+
+    if (szx == COAP_BLOCK_SZX_RESERVED) {
+        return false;
+    }
+
+    return szx <= COAP_BLOCK_SZX_MAX || num <= (COAP_BLOCK_NUM_MAX >> (szx - COAP_BLOCK_SZX_MAX));
+}
+
+// Without a Block2 option the client gets block 0 at the server's preferred size.
+// The packet must have passed coapBlockValid().
+CoapBlock coapRequestedBlock(const CoapPacket& packet) {
+    CoapBlock block = { 0, COAP_BLOCK_SZX_MAX, false };
+    const CoapOption* option = coapFindOption(packet, COAP_OPTION_BLOCK2);
+
+    if (option != NULL) {
+        unsigned long value = coapOptionUint(*option);
+
+        block.num = value >> 4;
+        block.szx = value & 0x07;
+        block.requested = true;
+
+        // A smaller server block size is negotiated by scaling the block number
+        if (block.szx > COAP_BLOCK_SZX_MAX) {
+            block.num <<= (block.szx - COAP_BLOCK_SZX_MAX);
+            block.szx = COAP_BLOCK_SZX_MAX;
+        }
+    }
+
+    return block;
+}
+
+// Replays the generator to produce only the requested block, then appends Block2/Size2 and the
+// payload. Options numbered below Block2 must already be in the message.
+// Returns false if the block lies past the end of the representation.
+bool coapWriteBlock(CoapMessage& message, CoapBlock block, CoapBlockGenerator generator, const void* context) {
+    size_t blockSize = COAP_BLOCK_SIZE(block.szx);
+    BufferWriter writer(BLOCK_BUFFER, blockSize, block.num * blockSize);
+
+    generator(writer, context);
+
+    size_t total = writer.total();
+    bool more = total > (block.num + 1) * blockSize;
+
+    if (block.num > 0 && writer.length() == 0) {
+        return false;
+    }
+
+    if (block.requested || more) {
+        message.addUintOption(COAP_OPTION_BLOCK2, (block.num << 4) | (more ? 0x08 : 0) | block.szx);
+
+        if (block.num == 0) {
+            message.addUintOption(COAP_OPTION_SIZE2, total);
+        }
+    }
+
+    message.setPayload((const uint8_t*) BLOCK_BUFFER, writer.length());
+
+    return true;
+}
+
+void coapWriteBytes(BufferWriter& writer, const void* context) {
+    const CoapBytes* bytes = (const CoapBytes*) context;
+
+    writer.write((const uint8_t*) bytes->data, bytes->length);
+}
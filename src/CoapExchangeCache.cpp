@@ -0,0 +1,69 @@
+#include "CoapExchangeCache.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CoapExchangeCache::CoapExchangeCache() {
+    for (size_t i = 0; i < COAP_EXCHANGE_CACHE_SIZE; i++) {
+        this->exchanges[i].active = false;
+    }
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// Returns NULL for a new exchange, expired entries are dropped on the way
+const uint8_t* CoapExchangeCache::find(IPAddress ip, int port, uint16_t messageId, unsigned long now, size_t& length) {
+    for (size_t i = 0; i < COAP_EXCHANGE_CACHE_SIZE; i++) {
+        Exchange& exchange = this->exchanges[i];
+
+        if (!exchange.active) {
+            continue;
+        }
+
+        if (now - exchange.time >= COAP_EXCHANGE_LIFETIME_MS) {
+            exchange.active = false;
+            continue;
+        }
+
+        if (exchange.messageId == messageId && exchange.port == port && exchange.ip == ip) {
+            length = exchange.length;
+            return exchange.response;
+        }
+    }
+
+    return NULL;
+}
+
+void CoapExchangeCache::store(IPAddress ip, int port, uint16_t messageId, const uint8_t* response, size_t length, unsigned long now) {
+    if (length > COAP_EXCHANGE_RESPONSE_MAX) {
+        return;
+    }
+
+    Exchange* slot = &this->exchanges[0];
+
+    for (size_t i = 0; i < COAP_EXCHANGE_CACHE_SIZE; i++) {
+        Exchange& exchange = this->exchanges[i];
+
+        if (!exchange.active || now - exchange.time >= COAP_EXCHANGE_LIFETIME_MS) {
+            slot = &exchange;
+            break;
+        }
+
+        if (now - exchange.time > now - slot->time) {
+            slot = &exchange;
+        }
+    }
+
+    slot->ip = ip;
+    slot->port = port;
+    slot->messageId = messageId;
+    slot->time = now;
+    memcpy(slot->response, response, length);
+    slot->length = length;
+    slot->active = true;
+}
@@ -0,0 +1,180 @@
+#include "CoapMessage.h"
+
+#include "CoapOptions.h"
+
+
+// ---------------
+// STATIC METHODS
+// ---------------
+
+uint16_t CoapMessage::nextMessageId() {
+    if (CoapMessage::MESSAGE_ID == 0) {
+        CoapMessage::MESSAGE_ID = (uint16_t) random(1, 0xFFFF);
+    }
+
+    return CoapMessage::MESSAGE_ID++;
+}
+
+unsigned long CoapMessage::sentCount() {
+    return CoapMessage::SENT_COUNT;
+}
+
+// The last message sent, until the next one is constructed in the shared buffer
+const uint8_t* CoapMessage::lastSent(size_t& length) {
+    length = CoapMessage::SENT_LENGTH;
+    return CoapMessage::BUFFER;
+}
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CoapMessage::CoapMessage(uint8_t type, uint8_t code, uint16_t messageId, const uint8_t* token, uint8_t tokenLength) {
+    this->position = 0;
+    this->lastOption = 0;
+    this->overflowed = false;
+    CoapMessage::SENT_LENGTH = 0;
+
+    if (tokenLength > 8) {
+        tokenLength = 8;
+    }
+
+    this->write((COAP_MESSAGE_VERSION << 6) | ((type & 0x03) << 4) | tokenLength);
+    this->write(code);
+    this->write(messageId >> 8);
+    this->write(messageId & 0xFF);
+
+    for (uint8_t i = 0; i < tokenLength; i++) {
+        this->write(token[i]);
+    }
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void CoapMessage::setCode(uint8_t code) {
+    CoapMessage::BUFFER[1] = code;
+}
+
+// Options must be added in ascending option number order (RFC 7252 §3.1)
+void CoapMessage::addOption(uint16_t number, const uint8_t* value, size_t length) {
+    uint8_t deltaNibble, lengthNibble;
+    uint8_t deltaExtended[2], lengthExtended[2];
+    size_t deltaExtendedLength, lengthExtendedLength;
+
+    this->writeOptionNibble(number - this->lastOption, deltaNibble, deltaExtended, deltaExtendedLength);
+    this->writeOptionNibble(length, lengthNibble, lengthExtended, lengthExtendedLength);
+
+    this->write((deltaNibble << 4) | lengthNibble);
+    for (size_t i = 0; i < deltaExtendedLength; i++) {
+        this->write(deltaExtended[i]);
+    }
+    for (size_t i = 0; i < lengthExtendedLength; i++) {
+        this->write(lengthExtended[i]);
+    }
+    for (size_t i = 0; i < length; i++) {
+        this->write(value[i]);
+    }
+
+    this->lastOption = number;
+}
+
+void CoapMessage::addUintOption(uint16_t number, unsigned long value) {
+    uint8_t bytes[4];
+    size_t length = 0;
+
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        if (length > 0 || ((value >> shift) & 0xFF) != 0) {
+            bytes[length++] = (value >> shift) & 0xFF;
+        }
+    }
+
+    this->addOption(number, bytes, length);
+}
+
+// Always COAP_ETAG_LENGTH bytes, unlike a uint option that drops its leading zeros
+void CoapMessage::addETagOption(uint32_t etag) {
+    const uint8_t value[COAP_ETAG_LENGTH] = {
+        (uint8_t) (etag >> 24), (uint8_t) (etag >> 16), (uint8_t) (etag >> 8), (uint8_t) etag
+    };
+
+    this->addOption(COAP_OPTION_ETAG, value, sizeof(value));
+}
+
+void CoapMessage::setPayload(const uint8_t* payload, size_t length) {
+    if (length == 0) {
+        return;
+    }
+
+    this->write(0xFF);
+    for (size_t i = 0; i < length; i++) {
+        this->write(payload[i]);
+    }
+}
+
+const uint8_t* CoapMessage::data() {
+    return CoapMessage::BUFFER;
+}
+
+size_t CoapMessage::length() {
+    return this->position;
+}
+
+bool CoapMessage::overflow() {
+    return this->overflowed;
+}
+
+bool CoapMessage::send(UDP& udp, IPAddress ip, int port) {
+    if (this->overflowed) {
+        return false;
+    }
+
+    udp.beginPacket(ip, port);
+    udp.write(CoapMessage::BUFFER, this->position);
+    if (udp.endPacket() != 1) {
+        return false;
+    }
+
+    CoapMessage::SENT_COUNT++;
+    CoapMessage::SENT_LENGTH = this->position;
+    return true;
+}
+
+// ---------------
+// PRIVATE STATIC ATTRIBUTES
+// ---------------
+
+uint8_t CoapMessage::BUFFER[COAP_MESSAGE_BUFFER_SIZE];
+uint16_t CoapMessage::MESSAGE_ID = 0;
+unsigned long CoapMessage::SENT_COUNT = 0;
+size_t CoapMessage::SENT_LENGTH = 0;
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+void CoapMessage::write(uint8_t value) {
+    if (this->position < COAP_MESSAGE_BUFFER_SIZE) {
+        CoapMessage::BUFFER[this->position++] = value;
+    } else {
+        this->overflowed = true;
+    }
+}
+
+void CoapMessage::writeOptionNibble(uint16_t value, uint8_t& nibble, uint8_t* extended, size_t& extendedLength) {
+    if (value < 13) {
+        nibble = value;
+        extendedLength = 0;
+    } else if (value < 269) {
+        nibble = 13;
+        extended[0] = value - 13;
+        extendedLength = 1;
+    } else {
+        nibble = 14;
+        extended[0] = (value - 269) >> 8;
+        extended[1] = (value - 269) & 0xFF;
+        extendedLength = 2;
+    }
+}
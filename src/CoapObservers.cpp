@@ -0,0 +1,155 @@
+#include "CoapObservers.h"
+
+#include <coap-simple.h>
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CoapObservers::CoapObservers() {
+    for (size_t i = 0; i < COAP_OBSERVERS_MAX; i++) {
+        this->observers[i].active = false;
+    }
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// A client re-registering the same resource replaces its entry (RFC 7641 §4.1)
+bool CoapObservers::add(uint8_t resource, IPAddress ip, int port, const uint8_t* token, uint8_t tokenLength, SenMLFormat format, unsigned long now) {
+    Observer* observer = this->find(resource, ip, port);
+
+    for (size_t i = 0; observer == NULL && i < COAP_OBSERVERS_MAX; i++) {
+        if (!this->observers[i].active) {
+            observer = &this->observers[i];
+        }
+    }
+
+    if (observer == NULL || tokenLength > COAP_OBSERVERS_TOKEN_MAX) {
+        return false;
+    }
+
+    observer->ip = ip;
+    observer->port = port;
+    memcpy(observer->token, token, tokenLength);
+    observer->tokenLength = tokenLength;
+    observer->resource = resource;
+    observer->format = format;
+    observer->messageId = 0;
+    observer->confirmedMs = now;
+    observer->confirming = false;
+    observer->active = true;
+
+    return true;
+}
+
+void CoapObservers::remove(uint8_t resource, IPAddress ip, int port) {
+    Observer* observer = this->find(resource, ip, port);
+
+    if (observer != NULL) {
+        observer->active = false;
+    }
+}
+
+// A client answering a notification with RST is no longer interested (RFC 7641 §3.6)
+void CoapObservers::removeRejected(IPAddress ip, int port, uint16_t messageId) {
+    for (size_t i = 0; i < COAP_OBSERVERS_MAX; i++) {
+        Observer& observer = this->observers[i];
+
+        if (observer.active && observer.ip == ip && observer.port == port && observer.messageId == messageId) {
+            observer.active = false;
+        }
+    }
+}
+
+// CON while one is due or still waits for its ACK: a newer notification takes over the
+// retransmissions of the pending one (RFC 7641 §4.5.2)
+uint8_t CoapObservers::notificationType(const Observer& observer, unsigned long now) {
+    if (observer.confirming || now - observer.confirmedMs >= COAP_OBSERVE_CON_INTERVAL_MS) {
+        return COAP_CON;
+    }
+
+    return COAP_NONCON;
+}
+
+void CoapObservers::notified(Observer& observer, uint8_t type, unsigned long now) {
+    if (type != COAP_CON) {
+        return;
+    }
+
+    if (!observer.confirming) {
+        observer.confirming = true;
+        observer.retransmissions = 0;
+    }
+
+    observer.sentMs = now;
+}
+
+void CoapObservers::acknowledged(IPAddress ip, int port, uint16_t messageId, unsigned long now) {
+    for (size_t i = 0; i < COAP_OBSERVERS_MAX; i++) {
+        Observer& observer = this->observers[i];
+
+        if (observer.active && observer.confirming && observer.ip == ip && observer.port == port && observer.messageId == messageId) {
+            observer.confirming = false;
+            observer.confirmedMs = now;
+        }
+    }
+}
+
+// The timeout doubles with every retransmission (RFC 7252 §4.2). Once the last one has
+// timed out as well the observer is dropped and false is returned.
+bool CoapObservers::retransmissionDue(Observer& observer, unsigned long now) {
+    if (!observer.active || !observer.confirming ||
+            now - observer.sentMs < ((unsigned long) COAP_OBSERVE_ACK_TIMEOUT_MS << observer.retransmissions)) {
+        return false;
+    }
+
+    if (observer.retransmissions >= COAP_OBSERVE_MAX_RETRANSMIT) {
+        observer.active = false;
+        return false;
+    }
+
+    return true;
+}
+
+void CoapObservers::retransmitted(Observer& observer, unsigned long now) {
+    observer.retransmissions++;
+    observer.sentMs = now;
+}
+
+bool CoapObservers::observed(uint8_t resource) {
+    for (size_t i = 0; i < COAP_OBSERVERS_MAX; i++) {
+        if (this->observers[i].active && this->observers[i].resource == resource) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t CoapObservers::capacity() {
+    return COAP_OBSERVERS_MAX;
+}
+
+CoapObservers::Observer& CoapObservers::get(size_t index) {
+    return this->observers[index];
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+CoapObservers::Observer* CoapObservers::find(uint8_t resource, IPAddress ip, int port) {
+    for (size_t i = 0; i < COAP_OBSERVERS_MAX; i++) {
+        Observer& observer = this->observers[i];
+
+        if (observer.active && observer.resource == resource && observer.ip == ip && observer.port == port) {
+            return &observer;
+        }
+    }
+
+    return NULL;
+}
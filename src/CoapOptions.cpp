@@ -0,0 +1,36 @@
+#include "CoapOptions.h"
+
+
+const CoapOption* coapFindOption(const CoapPacket& packet, uint8_t number) {
+    for (int i = 0; i < packet.optionnum; i++) {
+        if (packet.options[i].number == number) {
+            return &packet.options[i];
+        }
+    }
+
+    return NULL;
+}
+
+// uint options are big-endian with leading zero bytes stripped (RFC 7252 §3.2)
+unsigned long coapOptionUint(const CoapOption& option) {
+    unsigned long value = 0;
+
+    for (int i = 0; i < option.length && i < 4; i++) {
+        value = (value << 8) | option.buffer[i];
+    }
+
+    return value;
+}
+
+// A request may list several ETags, any of them validates (RFC 7252 §5.10.6.2)
+bool coapETagMatches(const CoapPacket& packet, uint32_t etag) {
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption& option = packet.options[i];
+
+        if (option.number == COAP_OPTION_ETAG && option.length == COAP_ETAG_LENGTH && coapOptionUint(option) == etag) {
+            return true;
+        }
+    }
+
+    return false;
+}
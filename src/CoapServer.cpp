@@ -0,0 +1,262 @@
+#include "CoapServer.h"
+
+#include "CoapMessage.h"
+#include "CoapOptions.h"
+
+
+#define COAP_HEADER_SIZE 4
+#define COAP_TOKEN_MAX 8
+#define COAP_PAYLOAD_MARKER 0xFF
+
+
+uint8_t CoapServer::BUFFER[COAP_SERVER_BUFFER_SIZE];
+
+
+// ---------------
+// STATIC METHODS
+// ---------------
+
+// Options point into the datagram buffer; numbers above 255 do not fit CoapOption and
+// are skipped, none of the handlers understand them anyway (RFC 7252 §3.1)
+bool CoapServer::parse(uint8_t* data, size_t length, CoapPacket& packet) {
+    if (length < COAP_HEADER_SIZE || (data[0] >> 6) != COAP_MESSAGE_VERSION) {
+        return false;
+    }
+
+    packet.type = (data[0] >> 4) & 0x03;
+    packet.tokenlen = data[0] & 0x0F;
+    packet.code = data[1];
+    packet.messageid = (data[2] << 8) | data[3];
+    packet.optionnum = 0;
+    packet.payload = NULL;
+    packet.payloadlen = 0;
+
+    if (packet.tokenlen > COAP_TOKEN_MAX || (size_t) (COAP_HEADER_SIZE + packet.tokenlen) > length) {
+        return false;
+    }
+
+    packet.token = data + COAP_HEADER_SIZE;
+
+    size_t position = COAP_HEADER_SIZE + packet.tokenlen;
+    uint16_t number = 0;
+
+    while (position < length) {
+        uint8_t header = data[position++];
+
+        if (header == COAP_PAYLOAD_MARKER) {
+            if (position == length) {
+                return false;
+            }
+
+            packet.payload = data + position;
+            packet.payloadlen = length - position;
+            return true;
+        }
+
+        uint16_t values[2] = { (uint16_t) (header >> 4), (uint16_t) (header & 0x0F) };
+
+        for (int i = 0; i < 2; i++) {
+            if (values[i] == 13 && position + 1 <= length) {
+                values[i] = data[position] + 13;
+                position += 1;
+            } else if (values[i] == 14 && position + 2 <= length) {
+                values[i] = ((data[position] << 8) | data[position + 1]) + 269;
+                position += 2;
+            } else if (values[i] >= 13) {
+                return false;
+            }
+        }
+
+        number += values[0];
+        if (position + values[1] > length) {
+            return false;
+        }
+
+        if (number <= 0xFF) {
+            if (packet.optionnum == COAP_MAX_OPTION_NUM) {
+                return false;
+            }
+
+            CoapOption& option = packet.options[packet.optionnum++];
+            option.number = number;
+            option.length = values[1];
+            option.buffer = data + position;
+        }
+
+        position += values[1];
+    }
+
+    return true;
+}
+
+bool CoapServer::joinPath(const CoapPacket& packet, char* path, size_t size) {
+    size_t position = 0;
+
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption& option = packet.options[i];
+
+        if (option.number != COAP_OPTION_URI_PATH) {
+            continue;
+        }
+
+        if (position + (position > 0) + option.length >= size) {
+            return false;
+        }
+
+        if (position > 0) {
+            path[position++] = '/';
+        }
+        memcpy(path + position, option.buffer, option.length);
+        position += option.length;
+    }
+
+    path[position] = '\0';
+    return true;
+}
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+CoapServer::CoapServer(UDP& udp) : udp(udp) {
+    this->dispatcher = NULL;
+    this->resetHandler = NULL;
+    this->ackHandler = NULL;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void CoapServer::setDispatcher(Dispatcher dispatcher) {
+    this->dispatcher = dispatcher;
+}
+
+void CoapServer::setResetHandler(ResetHandler handler) {
+    this->resetHandler = handler;
+}
+
+void CoapServer::setAckHandler(AckHandler handler) {
+    this->ackHandler = handler;
+}
+
+// Drains queued datagrams until maxPackets are handled, the socket is empty or budgetUs
+// has passed. The budget is checked between datagrams, so one is always handled.
+size_t CoapServer::loop(size_t maxPackets, unsigned long budgetUs) {
+    unsigned long start = micros();
+    size_t handled = 0;
+
+    while (handled < maxPackets && this->receive()) {
+        handled++;
+
+        if (micros() - start >= budgetUs) {
+            break;
+        }
+    }
+
+    return handled;
+}
+
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// Handles at most one datagram, returns false when none was waiting
+bool CoapServer::receive() {
+    int size = this->udp.parsePacket();
+
+    if (size <= 0) {
+        return false;
+    }
+
+    IPAddress ip = this->udp.remoteIP();
+    int port = this->udp.remotePort();
+
+    // Oversized datagrams are dropped whole rather than parsed truncated,
+    // the next parsePacket() discards whatever was left unread
+    if ((size_t) size > COAP_SERVER_BUFFER_SIZE) {
+        return true;
+    }
+
+    int read = this->udp.read(CoapServer::BUFFER, COAP_SERVER_BUFFER_SIZE);
+    size_t length = read > 0 ? read : 0;
+
+    CoapPacket packet;
+    bool confirmable = length >= COAP_HEADER_SIZE && ((CoapServer::BUFFER[0] >> 4) & 0x03) == COAP_CON;
+
+    if (!CoapServer::parse(CoapServer::BUFFER, length, packet)) {
+        if (confirmable) {
+            this->sendReset((CoapServer::BUFFER[2] << 8) | CoapServer::BUFFER[3], ip, port);
+        }
+        return true;
+    }
+
+    if (packet.type == COAP_RESET) {
+        if (this->resetHandler != NULL) {
+            this->resetHandler(ip, port, packet.messageid);
+        }
+        return true;
+    }
+
+    // Acknowledges a confirmable notification, the server sends no other CON
+    if (packet.type == COAP_ACK) {
+        if (this->ackHandler != NULL) {
+            this->ackHandler(ip, port, packet.messageid);
+        }
+        return true;
+    }
+
+    // Empty confirmable is a ping (RFC 7252 §4.3), responses need nothing from a server
+    if (packet.code == 0) {
+        if (packet.type == COAP_CON) {
+            this->sendReset(packet.messageid, ip, port);
+        }
+        return true;
+    }
+
+    if ((packet.code >> 5) != 0) {
+        return true;
+    }
+
+    unsigned long now = millis();
+    size_t replayLength;
+    const uint8_t* replay = confirmable ? this->exchanges.find(ip, port, packet.messageid, now, replayLength) : NULL;
+
+    if (replay != NULL) {
+        this->udp.beginPacket(ip, port);
+        this->udp.write(replay, replayLength);
+        this->udp.endPacket();
+        return true;
+    }
+
+    char path[COAP_SERVER_PATH_MAX];
+
+    if (!CoapServer::joinPath(packet, path, sizeof(path))) {
+        path[0] = '\0';
+    }
+
+    unsigned long sent = CoapMessage::sentCount();
+
+    if (this->dispatcher != NULL) {
+        this->dispatcher(packet, path, ip, port);
+    }
+
+    // Handlers answer with a single message, the piggybacked response is still in the shared buffer
+    size_t responseLength;
+    const uint8_t* response = CoapMessage::lastSent(responseLength);
+
+    if (confirmable && CoapMessage::sentCount() != sent && responseLength > 0) {
+        this->exchanges.store(ip, port, packet.messageid, response, responseLength, now);
+    }
+
+    return true;
+}
+
+void CoapServer::sendReset(uint16_t messageId, IPAddress ip, int port) {
+    CoapMessage message(COAP_RESET, 0, messageId, NULL, 0);
+
+    message.send(this->udp, ip, port);
+}
@@ -0,0 +1,61 @@
+#include "InputEventQueue.h"
+
+
+// Keeps the slot access on the right side of the index update; a single core needs no more
+#define INPUT_EVENT_QUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+InputEventQueue::InputEventQueue() {
+    this->head = 0;
+    this->tail = 0;
+    this->dropped = 0;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// Producer side only. The indices run freely and wrap modulo 2^32, head - tail is the fill level.
+bool InputEventQueue::push(const InputEvent& event) {
+    uint32_t head = this->head;
+
+    if (head - this->tail >= INPUT_EVENT_QUEUE_SIZE) {
+        this->dropped = this->dropped + 1;
+        return false;
+    }
+
+    this->events[head & (INPUT_EVENT_QUEUE_SIZE - 1)] = event;
+    INPUT_EVENT_QUEUE_BARRIER();
+    this->head = head + 1;
+
+    return true;
+}
+
+// Consumer side only
+bool InputEventQueue::pop(InputEvent& event) {
+    uint32_t tail = this->tail;
+
+    if (tail == this->head) {
+        return false;
+    }
+
+    INPUT_EVENT_QUEUE_BARRIER();
+    event = this->events[tail & (INPUT_EVENT_QUEUE_SIZE - 1)];
+    INPUT_EVENT_QUEUE_BARRIER();
+    this->tail = tail + 1;
+
+    return true;
+}
+
+size_t InputEventQueue::size() const {
+    return this->head - this->tail;
+}
+
+unsigned long InputEventQueue::getDropped() const {
+    return this->dropped;
+}
@@ -0,0 +1,269 @@
+#include "LSM6DS3Fifo.h"
+
+
+#define LSM6DS3_WHO_AM_I 0x0F
+#define LSM6DS3_WHO_AM_I_VALUE 0x69
+
+#define LSM6DS3_FIFO_CTRL3 0x08
+#define LSM6DS3_FIFO_CTRL5 0x0A
+#define LSM6DS3_CTRL1_XL 0x10
+#define LSM6DS3_CTRL2_G 0x11
+#define LSM6DS3_FIFO_STATUS1 0x3A
+#define LSM6DS3_FIFO_STATUS3 0x3C
+#define LSM6DS3_FIFO_DATA_OUT_L 0x3E
+
+#define LSM6DS3_FIFO_NO_DECIMATION 0x09     // gyroscope and accelerometer both in the FIFO, no decimation
+#define LSM6DS3_FIFO_CONTINUOUS_104HZ 0x26  // ODR_FIFO 104 Hz, continuous mode
+#define LSM6DS3_FIFO_BYPASS 0x00
+#define LSM6DS3_XL_416HZ_4G 0x6A            // 416 Hz, ±4 g, 100 Hz anti-aliasing
+#define LSM6DS3_G_416HZ_2000DPS 0x6C        // 416 Hz, ±2000 dps
+#define LSM6DS3_XL_104HZ_4G 0x4A            // Arduino_LSM6DS3 defaults
+#define LSM6DS3_G_104HZ_2000DPS 0x4C
+
+#define LSM6DS3_FIFO_STATUS2_OVER_RUN 0x40
+#define LSM6DS3_FIFO_STATUS2_EMPTY 0x10
+
+
+// ---------------
+// STATIC METHODS
+// ---------------
+
+int16_t LSM6DS3Fifo::mean(const Window& window, int axis) {
+    if (window.samples == 0) {
+        return 0;
+    }
+
+    return window.sum[axis] / (int32_t) window.samples;
+}
+
+uint16_t LSM6DS3Fifo::rms(const Window& window, int axis) {
+    if (window.samples == 0) {
+        return 0;
+    }
+
+    // A mean square is at most 32768², it fits in 32 bits
+    return LSM6DS3Fifo::isqrt((uint32_t) (window.sumSquares[axis] / window.samples));
+}
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+LSM6DS3Fifo::LSM6DS3Fifo(TwoWire& wire) : wire(wire) {
+    this->started = false;
+    this->overrunDetected = false;
+    this->setHook = NULL;
+    this->setHookContext = NULL;
+    this->resetWindow();
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+bool LSM6DS3Fifo::begin() {
+    uint8_t whoAmI;
+
+    if (!this->readRegisters(LSM6DS3_WHO_AM_I, &whoAmI, 1) || whoAmI != LSM6DS3_WHO_AM_I_VALUE) {
+        return false;
+    }
+
+    // Going through bypass clears whatever the FIFO held
+    this->started =
+        this->writeRegister(LSM6DS3_FIFO_CTRL5, LSM6DS3_FIFO_BYPASS) &&
+        this->writeRegister(LSM6DS3_CTRL1_XL, LSM6DS3_XL_416HZ_4G) &&
+        this->writeRegister(LSM6DS3_CTRL2_G, LSM6DS3_G_416HZ_2000DPS) &&
+        this->writeRegister(LSM6DS3_FIFO_CTRL3, LSM6DS3_FIFO_NO_DECIMATION) &&
+        this->writeRegister(LSM6DS3_FIFO_CTRL5, LSM6DS3_FIFO_CONTINUOUS_104HZ);
+
+    this->resetWindow();
+    return this->started;
+}
+
+void LSM6DS3Fifo::end() {
+    this->writeRegister(LSM6DS3_FIFO_CTRL5, LSM6DS3_FIFO_BYPASS);
+    this->writeRegister(LSM6DS3_CTRL1_XL, LSM6DS3_XL_104HZ_4G);
+    this->writeRegister(LSM6DS3_CTRL2_G, LSM6DS3_G_104HZ_2000DPS);
+
+    this->started = false;
+}
+
+bool LSM6DS3Fifo::active() {
+    return this->started;
+}
+
+// Reads every complete set in the FIFO, at most LSM6DS3_FIFO_BURST_SETS, into the window
+size_t LSM6DS3Fifo::drain() {
+    if (!this->started) {
+        return 0;
+    }
+
+    uint8_t status[4];
+    if (!this->readRegisters(LSM6DS3_FIFO_STATUS1, status, sizeof(status))) {
+        return 0;
+    }
+
+    if (status[1] & LSM6DS3_FIFO_STATUS2_OVER_RUN) {
+        this->overrunDetected = true;
+    }
+    if (status[1] & LSM6DS3_FIFO_STATUS2_EMPTY) {
+        return 0;
+    }
+
+    size_t words = ((status[1] & 0x0F) << 8) | status[0];
+    size_t pattern = ((status[3] & 0x03) << 8) | status[2];
+
+    // Realign on a set boundary: the pattern says which axis the next word belongs to
+    uint8_t data[LSM6DS3_FIFO_CHUNK_SETS * LSM6DS3_FIFO_AXES * 2];
+    if (pattern != 0) {
+        size_t skip = LSM6DS3_FIFO_AXES - pattern;
+
+        if (skip > words || !this->readRegisters(LSM6DS3_FIFO_DATA_OUT_L, data, skip * 2)) {
+            return 0;
+        }
+        words -= skip;
+    }
+
+    size_t sets = words / LSM6DS3_FIFO_AXES;
+    if (sets > LSM6DS3_FIFO_BURST_SETS) {
+        sets = LSM6DS3_FIFO_BURST_SETS;
+    }
+
+    size_t drained = 0;
+    while (drained < sets) {
+        size_t chunk = sets - drained;
+        if (chunk > LSM6DS3_FIFO_CHUNK_SETS) {
+            chunk = LSM6DS3_FIFO_CHUNK_SETS;
+        }
+
+        if (!this->readRegisters(LSM6DS3_FIFO_DATA_OUT_L, data, chunk * LSM6DS3_FIFO_AXES * 2)) {
+            break;
+        }
+
+        for (size_t i = 0; i < chunk; i++) {
+            const uint8_t* bytes = &data[i * LSM6DS3_FIFO_AXES * 2];
+            int16_t set[LSM6DS3_FIFO_AXES];
+
+            for (int axis = 0; axis < LSM6DS3_FIFO_AXES; axis++) {
+                set[axis] = (int16_t) (bytes[axis * 2] | (bytes[axis * 2 + 1] << 8));
+            }
+
+            if (this->setHook != NULL) {
+                this->setHook(set, this->setHookContext);
+            }
+            this->accumulate(set);
+        }
+        drained += chunk;
+    }
+
+    return drained;
+}
+
+// Set when the FIFO filled up between two drains, cleared by resetWindow()
+bool LSM6DS3Fifo::overrun() {
+    return this->overrunDetected;
+}
+
+void LSM6DS3Fifo::setSetHook(SetHook hook, void* context) {
+    this->setHook = hook;
+    this->setHookContext = context;
+}
+
+LSM6DS3Fifo::Window& LSM6DS3Fifo::getWindow() {
+    return this->window;
+}
+
+void LSM6DS3Fifo::resetWindow() {
+    this->window.samples = 0;
+
+    for (int axis = 0; axis < LSM6DS3_FIFO_AXES; axis++) {
+        this->window.min[axis] = INT16_MAX;
+        this->window.max[axis] = INT16_MIN;
+        this->window.sum[axis] = 0;
+        this->window.sumSquares[axis] = 0;
+    }
+
+    this->overrunDetected = false;
+}
+
+// ---------------
+// PRIVATE STATIC ATTRIBUTES
+// ---------------
+
+const float LSM6DS3Fifo::ACCELEROMETER_SCALE = 4.0 / 32768.0;
+const float LSM6DS3Fifo::GYROSCOPE_SCALE = 2000.0 / 32768.0;
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// FIFO_DATA_OUT rolls back from H to L, so one burst read returns consecutive words
+bool LSM6DS3Fifo::readRegisters(uint8_t reg, uint8_t* data, size_t length) {
+    this->wire.beginTransmission(LSM6DS3_FIFO_ADDRESS);
+    this->wire.write(reg);
+    if (this->wire.endTransmission(false) != 0) {
+        return false;
+    }
+
+    if (this->wire.requestFrom(LSM6DS3_FIFO_ADDRESS, length) != length) {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        data[i] = this->wire.read();
+    }
+
+    return true;
+}
+
+bool LSM6DS3Fifo::writeRegister(uint8_t reg, uint8_t value) {
+    this->wire.beginTransmission(LSM6DS3_FIFO_ADDRESS);
+    this->wire.write(reg);
+    this->wire.write(value);
+
+    return this->wire.endTransmission() == 0;
+}
+
+void LSM6DS3Fifo::accumulate(const int16_t* set) {
+    if (this->window.samples == UINT16_MAX) {
+        return;
+    }
+
+    for (int axis = 0; axis < LSM6DS3_FIFO_AXES; axis++) {
+        int16_t value = set[axis];
+
+        if (value < this->window.min[axis]) {
+            this->window.min[axis] = value;
+        }
+        if (value > this->window.max[axis]) {
+            this->window.max[axis] = value;
+        }
+
+        this->window.sum[axis] += value;
+        this->window.sumSquares[axis] += (uint32_t) ((int32_t) value * value);
+    }
+
+    this->window.samples++;
+}
+
+uint32_t LSM6DS3Fifo::isqrt(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
@@ -0,0 +1,184 @@
+#include "MahonyFilter.h"
+
+
+#define MAHONY_ACCEL_SCALE 16384.0                                  // g to Q14, ±4 g fits
+#define MAHONY_GYRO_SCALE (MAHONY_Q16_ONE * 3.14159265 / 180.0)    // dps to Q16 rad/s
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+MahonyFilter::MahonyFilter() {
+    this->setGains(MAHONY_DEFAULT_KP, MAHONY_DEFAULT_KI);
+    this->reset();
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void MahonyFilter::setGains(float kp, float ki) {
+    this->kp = (int32_t) (kp * MAHONY_Q16_ONE);
+    this->ki = (int32_t) (ki * MAHONY_Q16_ONE);
+}
+
+void MahonyFilter::reset() {
+    this->q.w = MAHONY_Q30_ONE;
+    this->q.x = 0;
+    this->q.y = 0;
+    this->q.z = 0;
+
+    this->integral[0] = 0;
+    this->integral[1] = 0;
+    this->integral[2] = 0;
+}
+
+// Rates in dps and accelerations in g, as published by CarrierManager
+void MahonyFilter::update(float gx, float gy, float gz, float ax, float ay, float az, unsigned long dtMs) {
+    const int32_t gyro[3] = {
+        (int32_t) (gx * MAHONY_GYRO_SCALE), (int32_t) (gy * MAHONY_GYRO_SCALE), (int32_t) (gz * MAHONY_GYRO_SCALE)
+    };
+    const int32_t accel[3] = {
+        (int32_t) (ax * MAHONY_ACCEL_SCALE), (int32_t) (ay * MAHONY_ACCEL_SCALE), (int32_t) (az * MAHONY_ACCEL_SCALE)
+    };
+
+    this->updateFixed(gyro, accel, dtMs);
+}
+
+// Rates in Q16 rad/s, the acceleration in any scale up to ±2^16 per axis: only its direction is used
+void MahonyFilter::updateFixed(const int32_t gyro[3], const int32_t accel[3], unsigned long dtMs) {
+    if (dtMs > MAHONY_DT_MAX_MS) {
+        dtMs = MAHONY_DT_MAX_MS;
+    }
+
+    while (dtMs > MAHONY_STEP_MAX_MS) {
+        this->step(gyro, accel, MAHONY_STEP_MAX_MS);
+        dtMs -= MAHONY_STEP_MAX_MS;
+    }
+    this->step(gyro, accel, dtMs);
+}
+
+const MahonyFilter::Quaternion& MahonyFilter::getQuaternion() {
+    return this->q;
+}
+
+void MahonyFilter::getQuaternion(float& w, float& x, float& y, float& z) {
+    w = (float) this->q.w / MAHONY_Q30_ONE;
+    x = (float) this->q.x / MAHONY_Q30_ONE;
+    y = (float) this->q.y / MAHONY_Q30_ONE;
+    z = (float) this->q.z / MAHONY_Q30_ONE;
+}
+
+// Radians, aerospace sequence. Yaw drifts: there is no magnetometer on the carrier.
+void MahonyFilter::getEuler(float& roll, float& pitch, float& yaw) {
+    float w, x, y, z;
+    this->getQuaternion(w, x, y, z);
+
+    float sinPitch = 2.0f * (w * y - z * x);
+    if (sinPitch > 1.0f) {
+        sinPitch = 1.0f;
+    } else if (sinPitch < -1.0f) {
+        sinPitch = -1.0f;
+    }
+
+    roll = atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+    pitch = asinf(sinPitch);
+    yaw = atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+void MahonyFilter::step(const int32_t gyro[3], const int32_t accel[3], unsigned long dtMs) {
+    int32_t dt = (int32_t) ((dtMs << 24) / 1000);       // Q24 s, Q16 would be 0.05% off at 20 ms
+    int32_t rate[3] = { gyro[0], gyro[1], gyro[2] };
+
+    uint64_t accelSquared = (uint64_t) ((int64_t) accel[0] * accel[0] + (int64_t) accel[1] * accel[1] + (int64_t) accel[2] * accel[2]);
+    uint32_t accelNorm = MahonyFilter::isqrt64(accelSquared);
+
+    // No reading yet: integrate the gyroscope alone
+    if (accelNorm != 0) {
+        int64_t inverseNorm = (int64_t) ((1ULL << 60) / accelNorm);
+        int32_t a[3];
+        for (int i = 0; i < 3; i++) {
+            a[i] = (int32_t) ((accel[i] * inverseNorm) >> 30);
+        }
+
+        // Gravity as seen from the current estimate, half of it to stay inside Q30
+        int32_t vx = mulQ30(this->q.x, this->q.z) - mulQ30(this->q.w, this->q.y);
+        int32_t vy = mulQ30(this->q.w, this->q.x) + mulQ30(this->q.y, this->q.z);
+        int32_t vz = (mulQ30(this->q.w, this->q.w) - mulQ30(this->q.x, this->q.x) -
+                      mulQ30(this->q.y, this->q.y) + mulQ30(this->q.z, this->q.z)) / 2;
+
+        // Error is a × v, doubled back from the half-scale gravity
+        int32_t e[3] = {
+            2 * (mulQ30(a[1], vz) - mulQ30(a[2], vy)),
+            2 * (mulQ30(a[2], vx) - mulQ30(a[0], vz)),
+            2 * (mulQ30(a[0], vy) - mulQ30(a[1], vx))
+        };
+
+        for (int i = 0; i < 3; i++) {
+            if (this->ki != 0) {
+                // Q30 error × Q24 s × Q16 gain → Q24 rad/s, Q16 would round the steps away
+                int32_t step = (int32_t) (((int64_t) e[i] * dt) >> 30);
+                this->integral[i] += (int32_t) (((int64_t) step * this->ki) >> 16);
+                rate[i] += this->integral[i] >> 8;
+            }
+
+            rate[i] += (int32_t) (((int64_t) e[i] * this->kp) >> 30);
+        }
+    }
+
+    // Half rotation angle over dt: Q16 rad/s × Q24 s → Q40, halved into Q30
+    int32_t hx = (int32_t) (((int64_t) rate[0] * dt) >> 11);
+    int32_t hy = (int32_t) (((int64_t) rate[1] * dt) >> 11);
+    int32_t hz = (int32_t) (((int64_t) rate[2] * dt) >> 11);
+
+    Quaternion p = this->q;
+    this->q.w += -mulQ30(p.x, hx) - mulQ30(p.y, hy) - mulQ30(p.z, hz);
+    this->q.x += mulQ30(p.w, hx) + mulQ30(p.y, hz) - mulQ30(p.z, hy);
+    this->q.y += mulQ30(p.w, hy) - mulQ30(p.x, hz) + mulQ30(p.z, hx);
+    this->q.z += mulQ30(p.w, hz) + mulQ30(p.x, hy) - mulQ30(p.y, hx);
+
+    // Renormalize with one reciprocal and four multiplications
+    uint64_t norm = MahonyFilter::isqrt64((uint64_t) ((int64_t) this->q.w * this->q.w + (int64_t) this->q.x * this->q.x +
+                                                      (int64_t) this->q.y * this->q.y + (int64_t) this->q.z * this->q.z));
+    if (norm == 0) {
+        this->reset();
+        return;
+    }
+
+    int32_t inverse = (int32_t) ((1ULL << 60) / norm);
+    this->q.w = mulQ30(this->q.w, inverse);
+    this->q.x = mulQ30(this->q.x, inverse);
+    this->q.y = mulQ30(this->q.y, inverse);
+    this->q.z = mulQ30(this->q.z, inverse);
+}
+
+int32_t MahonyFilter::mulQ30(int32_t a, int32_t b) {
+    return (int32_t) (((int64_t) a * b) >> 30);
+}
+
+uint32_t MahonyFilter::isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t) root;
+}
@@ -0,0 +1,205 @@
+#include "MemoryTelemetry.h"
+
+
+#ifdef ARDUINO_ARCH_SAMD
+#include <malloc.h>
+
+// newlib-nano free list entry, the size includes the header
+struct MemoryChunk {
+    long size;
+    MemoryChunk* next;
+};
+
+extern "C" {
+    extern char end;                                // first byte after .bss, where the heap starts
+    extern char __StackTop;
+    extern MemoryChunk* __malloc_free_list __attribute__((weak));
+
+    char* sbrk(int increment);
+
+    void* __real_malloc(size_t size);
+    void* __real_realloc(void* pointer, size_t size);
+    void __real_free(void* pointer);
+}
+#endif
+
+
+volatile int memorySubsystem = MEMORY_SUBSYSTEM_CORE;
+
+uint32_t memoryHeapUsed = 0;
+uint32_t memoryHeapPeak = 0;
+uint32_t memoryAllocations[MEMORY_SUBSYSTEM_COUNT];
+uint32_t memoryFrees = 0;
+uint32_t memoryFailures = 0;
+
+
+// ---------------
+// STATIC METHODS
+// ---------------
+
+// Fills the free space between the heap and the current stack frame, call it first thing in
+// setup(): whatever the stack later overwrites marks its deepest point
+void MemoryTelemetry::paintStack() {
+#ifdef ARDUINO_ARCH_SAMD
+    char frame;
+    char* low = sbrk(0);
+    char* high = &frame - MEMORY_STACK_PAINT_MARGIN;
+
+    for (char* p = low; p < high; p++) {
+        *p = MEMORY_STACK_PAINT;
+    }
+#endif
+}
+
+void MemoryTelemetry::read(Snapshot& snapshot) {
+    memset(&snapshot, 0, sizeof(snapshot));
+
+#ifdef ARDUINO_ARCH_SAMD
+    struct mallinfo info = mallinfo();
+
+    snapshot.heapUsed = memoryHeapUsed;
+    snapshot.heapPeak = memoryHeapPeak;
+    snapshot.heapFree = info.fordblks;
+    snapshot.heapArena = info.arena;
+
+    if (&__malloc_free_list != NULL) {
+        for (MemoryChunk* chunk = __malloc_free_list; chunk != NULL; chunk = chunk->next) {
+            if ((uint32_t) chunk->size > snapshot.heapLargestFree) {
+                snapshot.heapLargestFree = chunk->size;
+            }
+        }
+    }
+
+    // Heap growth overwrites the paint from below, so the scan starts at the current heap end
+    char frame;
+    char* heapEnd = sbrk(0);
+    char* deepest = heapEnd;
+
+    while (deepest < &frame && *deepest == MEMORY_STACK_PAINT) {
+        deepest++;
+    }
+
+    snapshot.gap = deepest - heapEnd;
+    snapshot.stackUsed = &__StackTop - deepest;
+#endif
+
+    memcpy(snapshot.allocations, memoryAllocations, sizeof(snapshot.allocations));
+    snapshot.frees = memoryFrees;
+    snapshot.failures = memoryFailures;
+}
+
+// One line per call, for the optional periodic serial dump
+void MemoryTelemetry::dump(Print& output) {
+    Snapshot snapshot;
+    MemoryTelemetry::read(snapshot);
+
+    output.print("mem heap=");
+    output.print(snapshot.heapUsed);
+    output.print(" peak=");
+    output.print(snapshot.heapPeak);
+    output.print(" free=");
+    output.print(snapshot.heapFree);
+    output.print(" largest=");
+    output.print(snapshot.heapLargestFree);
+    output.print(" arena=");
+    output.print(snapshot.heapArena);
+    output.print(" gap=");
+    output.print(snapshot.gap);
+    output.print(" stack=");
+    output.print(snapshot.stackUsed);
+
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; subsystem++) {
+        output.print(' ');
+        output.print(MemoryTelemetry::SUBSYSTEM_NAMES[subsystem]);
+        output.print('=');
+        output.print(snapshot.allocations[subsystem]);
+    }
+
+    output.print(" frees=");
+    output.print(snapshot.frees);
+    output.print(" failures=");
+    output.println(snapshot.failures);
+}
+
+int MemoryTelemetry::enter(int subsystem) {
+    int previous = memorySubsystem;
+    memorySubsystem = subsystem;
+
+    return previous;
+}
+
+void MemoryTelemetry::leave(int previous) {
+    memorySubsystem = previous;
+}
+
+// ---------------
+// PUBLIC STATIC ATTRIBUTES
+// ---------------
+
+const char* const MemoryTelemetry::SUBSYSTEM_NAMES[MEMORY_SUBSYSTEM_COUNT] = {
+    "core", "sensors", "gfx", "wifi", "coap"
+};
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+MemoryScope::MemoryScope(int subsystem) {
+    this->previous = MemoryTelemetry::enter(subsystem);
+}
+
+MemoryScope::~MemoryScope() {
+    MemoryTelemetry::leave(this->previous);
+}
+
+
+// ---------------
+// ALLOCATOR WRAPPERS
+// ---------------
+
+#ifdef ARDUINO_ARCH_SAMD
+void memoryAllocated(void* pointer) {
+    if (pointer == NULL) {
+        memoryFailures++;
+        return;
+    }
+
+    memoryAllocations[memorySubsystem]++;
+    memoryHeapUsed += malloc_usable_size(pointer);
+
+    if (memoryHeapUsed > memoryHeapPeak) {
+        memoryHeapPeak = memoryHeapUsed;
+    }
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    void* pointer = __real_malloc(size);
+
+    memoryAllocated(pointer);
+    return pointer;
+}
+
+// String growth goes through realloc, counted as an allocation of the current subsystem
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+    size_t previous = (pointer != NULL ? malloc_usable_size(pointer) : 0);
+    void* reallocated = __real_realloc(pointer, size);
+
+    if (reallocated != NULL || size == 0) {
+        memoryHeapUsed -= previous;
+    }
+    if (size != 0) {
+        memoryAllocated(reallocated);
+    }
+    return reallocated;
+}
+
+extern "C" void __wrap_free(void* pointer) {
+    if (pointer != NULL) {
+        memoryHeapUsed -= malloc_usable_size(pointer);
+        memoryFrees++;
+    }
+
+    __real_free(pointer);
+}
+#endif
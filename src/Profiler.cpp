@@ -0,0 +1,118 @@
+#include "Profiler.h"
+
+
+#ifdef PROFILE_ENABLED
+Profiler profiler;
+#endif
+
+
+// Cycle counter: the M0+ has no DWT, so the SysTick down-counter (one 1 ms period per
+// reload) is combined with millis(). Wraps every 2^32 cycles, ~89 s at 48 MHz, which is
+// fine for durations. The host has neither, it falls back on micros().
+uint32_t profilerCycles() {
+#ifdef ARDUINO_ARCH_SAMD
+    uint32_t ms, ticks;
+
+    // Retry when the SysTick interrupt ran in between the two reads
+    do {
+        ms = millis();
+        ticks = SysTick->VAL;
+    } while (ms != millis());
+
+    return ms * (SysTick->LOAD + 1) + (SysTick->LOAD - ticks);
+#else
+    return micros() * PROFILER_CYCLES_PER_US;
+#endif
+}
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+Profiler::Profiler() {
+    this->reset();
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void Profiler::record(int phase, uint32_t cycles) {
+    Histogram& histogram = this->histograms[phase];
+
+    uint8_t bucket = 0;
+    for (uint32_t value = cycles; value != 0 && bucket < PROFILER_BUCKETS - 1; value >>= 1) {
+        bucket++;
+    }
+
+    histogram.buckets[bucket]++;
+    histogram.count++;
+
+    if (cycles < histogram.min) {
+        histogram.min = cycles;
+    }
+    if (cycles > histogram.max) {
+        histogram.max = cycles;
+    }
+}
+
+void Profiler::reset() {
+    for (int phase = 0; phase < PROFILE_PHASE_COUNT; phase++) {
+        Histogram& histogram = this->histograms[phase];
+
+        memset(histogram.buckets, 0, sizeof(histogram.buckets));
+        histogram.count = 0;
+        histogram.min = UINT32_MAX;
+        histogram.max = 0;
+    }
+}
+
+const Profiler::Histogram& Profiler::getHistogram(int phase) {
+    return this->histograms[phase];
+}
+
+// Upper bound of the bucket holding the percentile, capped to the largest duration seen
+uint32_t Profiler::percentile(const Histogram& histogram, uint8_t percent) {
+    if (histogram.count == 0) {
+        return 0;
+    }
+
+    uint32_t rank = (uint32_t) (((uint64_t) histogram.count * percent + 99) / 100);
+    uint32_t seen = 0;
+
+    for (int bucket = 0; bucket < PROFILER_BUCKETS; bucket++) {
+        seen += histogram.buckets[bucket];
+
+        if (seen >= rank) {
+            uint32_t upper = (uint32_t) ((1ULL << bucket) - 1);
+            return (upper < histogram.max ? upper : histogram.max);
+        }
+    }
+
+    return histogram.max;
+}
+
+// ---------------
+// PUBLIC STATIC ATTRIBUTES
+// ---------------
+
+const char* const Profiler::PHASE_NAMES[PROFILE_PHASE_COUNT] = {
+    "sensors", "buttons", "leds", "gfx", "wifi", "coap", "log"
+};
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+ProfilerScope::ProfilerScope(int phase) {
+    this->phase = phase;
+    this->start = profilerCycles();
+}
+
+ProfilerScope::~ProfilerScope() {
+#ifdef PROFILE_ENABLED
+    profiler.record(this->phase, profilerCycles() - this->start);
+#endif
+}
@@ -0,0 +1,85 @@
+#include "SdFileBlockDevice.h"
+
+
+// Not FILE_WRITE, which appends every write to the end of the file
+#define SD_FILE_BLOCK_DEVICE_MODE (O_READ | O_WRITE | O_CREAT)
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SdFileBlockDevice::SdFileBlockDevice(const char* path, uint32_t blocks, uint8_t chipSelect) {
+    this->path = path;
+    this->blocks = blocks;
+    this->chipSelect = chipSelect;
+    this->ready = false;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+bool SdFileBlockDevice::begin() {
+    if (this->ready) {
+        return true;
+    }
+
+    if (!SD.begin(this->chipSelect)) {
+        return false;
+    }
+
+    this->file = SD.open(this->path, SD_FILE_BLOCK_DEVICE_MODE);
+    this->ready = (bool) this->file;
+
+    return this->ready;
+}
+
+uint32_t SdFileBlockDevice::getBlockCount() {
+    return this->blocks;
+}
+
+bool SdFileBlockDevice::read(uint32_t block, size_t offset, void* data, size_t length) {
+    uint32_t position = block * BLOCK_DEVICE_BLOCK_SIZE + offset;
+
+    if (!this->ready || block >= this->blocks || offset + length > BLOCK_DEVICE_BLOCK_SIZE ||
+            position + length > this->file.size()) {
+        return false;
+    }
+
+    return this->file.seek(position) && this->file.read(data, length) == (int) length;
+}
+
+// A block past the end of the file first grows it with zeroed blocks, and the directory
+// entry is only flushed when the size changed: an overwrite costs a single card write
+bool SdFileBlockDevice::write(uint32_t block, const void* data) {
+    static const uint8_t ZEROS[BLOCK_DEVICE_BLOCK_SIZE] = { 0 };
+
+    if (!this->ready || block >= this->blocks) {
+        return false;
+    }
+
+    uint32_t size = this->file.size();
+    uint32_t position = block * BLOCK_DEVICE_BLOCK_SIZE;
+
+    if (!this->file.seek(size < position ? size - size % BLOCK_DEVICE_BLOCK_SIZE : position)) {
+        return false;
+    }
+
+    while (this->file.position() < position) {
+        if (this->file.write(ZEROS, BLOCK_DEVICE_BLOCK_SIZE) != BLOCK_DEVICE_BLOCK_SIZE) {
+            return false;
+        }
+    }
+
+    if (this->file.write((const uint8_t*) data, BLOCK_DEVICE_BLOCK_SIZE) != BLOCK_DEVICE_BLOCK_SIZE) {
+        return false;
+    }
+
+    if (this->file.size() != size) {
+        this->file.flush();
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#include "SenMLCache.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SenMLCache::SenMLCache(Encoder encoder) {
+    this->encoder = encoder;
+
+    this->json.buffer = this->jsonBuffer;
+    this->json.size = SENML_CACHE_JSON_BUFFER_SIZE;
+    this->cbor.buffer = this->cborBuffer;
+    this->cbor.size = SENML_CACHE_CBOR_BUFFER_SIZE;
+
+    this->invalidate();
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// Each format is encoded lazily, at most once per generation of the sensor group, which the
+// caller reads from CarrierManager::getSensorGeneration(). NULL when the pack does not fit its
+// buffer: the same values would not fit again, so the failure is kept until the next refresh
+// and counted once.
+const char* SenMLCache::get(CarrierManager& carrier, unsigned long generation, SenMLFormat format, size_t& length) {
+    Entry& entry = (format == SENML_FORMAT_CBOR ? this->cbor : this->json);
+
+    if (!entry.valid || entry.generation != generation) {
+        entry.length = this->encoder(carrier, format, entry.buffer, entry.size);
+        entry.generation = generation;
+        entry.valid = true;
+
+        if (entry.length == 0) {
+            SenMLCache::FAILURES++;
+        }
+    }
+
+    length = entry.length;
+    return entry.length > 0 ? entry.buffer : NULL;
+}
+
+void SenMLCache::invalidate() {
+    this->json.length = 0;
+    this->json.valid = false;
+    this->cbor.length = 0;
+    this->cbor.valid = false;
+}
+
+// Packs that did not fit their buffer, over all caches
+unsigned long SenMLCache::getFailures() {
+    return SenMLCache::FAILURES;
+}
+
+
+unsigned long SenMLCache::FAILURES = 0;
@@ -0,0 +1,236 @@
+#include "SenMLWriter.h"
+
+
+#define SENML_BVER_DECIMALS 3
+
+// SenML-CBOR labels (RFC 8428 §6)
+#define SENML_CBOR_BVER -1
+#define SENML_CBOR_BN -2
+#define SENML_CBOR_BT -3
+#define SENML_CBOR_N 0
+#define SENML_CBOR_U 1
+#define SENML_CBOR_V 2
+#define SENML_CBOR_T 6
+
+#define CBOR_MAJOR_UNSIGNED 0
+#define CBOR_MAJOR_NEGATIVE 1
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_FLOAT32 0xFA
+
+
+static void cborWriteHead(BufferWriter& writer, uint8_t major, unsigned long value);
+static void cborWriteInt(BufferWriter& writer, long value);
+static void cborWriteText(BufferWriter& writer, const char* str);
+static void cborWriteFloat(BufferWriter& writer, float value);
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SenMLPackWriter::SenMLPackWriter(BufferWriter& writer, SenMLFormat format) : writer(writer) {
+    this->format = format;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// count is the number of records that will follow, CBOR packs are definite-length arrays
+void SenMLPackWriter::begin(const char* baseName, unsigned long baseTime, float baseVersion, size_t count) {
+    if (this->format == SENML_FORMAT_CBOR) {
+        cborWriteHead(this->writer, CBOR_MAJOR_ARRAY, count + 1);
+
+        cborWriteHead(this->writer, CBOR_MAJOR_MAP, 3);
+        cborWriteInt(this->writer, SENML_CBOR_BN);
+        cborWriteText(this->writer, baseName);
+        cborWriteInt(this->writer, SENML_CBOR_BT);
+        cborWriteHead(this->writer, CBOR_MAJOR_UNSIGNED, baseTime);
+        cborWriteInt(this->writer, SENML_CBOR_BVER);
+        cborWriteHead(this->writer, CBOR_MAJOR_UNSIGNED, (unsigned long) baseVersion);
+    } else {
+        this->writer.write("[{\"bn\":\"");
+        this->writer.write(baseName);
+        this->writer.write("\",\"bt\":");
+        this->writer.writeUnsigned(baseTime);
+        this->writer.write(",\"bver\":");
+        this->writer.writeFixed(baseVersion, SENML_BVER_DECIMALS);
+        this->writer.write('}');
+    }
+}
+
+void SenMLPackWriter::record(const SenMLRecord& record, float value) {
+    this->writeRecord(record, value, false, 0);
+}
+
+// time is relative to the base time
+void SenMLPackWriter::record(const SenMLRecord& record, float value, long time) {
+    this->writeRecord(record, value, true, time);
+}
+
+// value carries scale decimals; JSON is formatted from the integer, CBOR still carries a float
+void SenMLPackWriter::recordFixed(const SenMLRecord& record, int32_t value, uint8_t scale) {
+    this->writeRecordFixed(record, value, scale, false, 0);
+}
+
+void SenMLPackWriter::recordFixed(const SenMLRecord& record, int32_t value, uint8_t scale, long time) {
+    this->writeRecordFixed(record, value, scale, true, time);
+}
+
+void SenMLPackWriter::end() {
+    if (this->format == SENML_FORMAT_JSON) {
+        this->writer.write(']');
+    }
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+void SenMLPackWriter::writeRecord(const SenMLRecord& record, float value, bool timed, long time) {
+    this->writeRecordHead(record, timed);
+
+    if (this->format == SENML_FORMAT_CBOR) {
+        cborWriteFloat(this->writer, value);
+    } else {
+        this->writer.writeFixed(value, record.decimals);
+    }
+
+    this->writeRecordTail(record, timed, time);
+}
+
+void SenMLPackWriter::writeRecordFixed(const SenMLRecord& record, int32_t value, uint8_t scale, bool timed, long time) {
+    this->writeRecordHead(record, timed);
+
+    if (this->format == SENML_FORMAT_CBOR) {
+        float divisor = 1;
+        for (uint8_t i = 0; i < scale; i++) {
+            divisor *= 10;
+        }
+
+        cborWriteFloat(this->writer, value == INT32_MIN ? NAN : value / divisor);
+    } else {
+        this->writer.writeScaled(value, scale, record.decimals);
+    }
+
+    this->writeRecordTail(record, timed, time);
+}
+
+// Everything up to the value, which is the same for both value types
+void SenMLPackWriter::writeRecordHead(const SenMLRecord& record, bool timed) {
+    if (this->format == SENML_FORMAT_CBOR) {
+        cborWriteHead(this->writer, CBOR_MAJOR_MAP, 2 + (record.unit != NULL ? 1 : 0) + (timed ? 1 : 0));
+
+        cborWriteInt(this->writer, SENML_CBOR_N);
+        cborWriteText(this->writer, record.name);
+
+        if (record.unit != NULL) {
+            cborWriteInt(this->writer, SENML_CBOR_U);
+            cborWriteText(this->writer, record.unit);
+        }
+
+        cborWriteInt(this->writer, SENML_CBOR_V);
+    } else {
+        this->writer.write(",{\"n\":\"");
+        this->writer.write(record.name);
+        this->writer.write("\",\"v\":");
+    }
+}
+
+void SenMLPackWriter::writeRecordTail(const SenMLRecord& record, bool timed, long time) {
+    if (this->format == SENML_FORMAT_CBOR) {
+        if (timed) {
+            cborWriteInt(this->writer, SENML_CBOR_T);
+            cborWriteInt(this->writer, time);
+        }
+    } else {
+        if (record.unit != NULL) {
+            this->writer.write(",\"u\":\"");
+            this->writer.write(record.unit);
+            this->writer.write('"');
+        }
+
+        if (timed) {
+            this->writer.write(",\"t\":");
+            this->writer.writeSigned(time);
+        }
+
+        this->writer.write('}');
+    }
+}
+
+
+// ---------------
+// BUFFER ENCODERS
+// ---------------
+
+// Returns the number of bytes written, 0 if the pack does not fit in the buffer
+size_t senmlWriteFixed(SenMLFormat format, char* buffer, size_t size,
+        const char* baseName, unsigned long baseTime, float baseVersion,
+        const SenMLRecord* records, const int32_t* values, size_t count, uint8_t scale) {
+    BufferWriter writer(buffer, size);
+    SenMLPackWriter pack(writer, format);
+
+    pack.begin(baseName, baseTime, baseVersion, count);
+    for (size_t i = 0; i < count; i++) {
+        pack.recordFixed(records[i], values[i], scale);
+    }
+    pack.end();
+
+    return writer.overflow() ? 0 : writer.length();
+}
+
+
+// ---------------
+// CBOR
+// ---------------
+
+static void cborWriteHead(BufferWriter& writer, uint8_t major, unsigned long value) {
+    major <<= 5;
+
+    if (value < 24) {
+        writer.write((char) (major | value));
+    } else if (value <= 0xFF) {
+        writer.write((char) (major | 24));
+        writer.write((char) value);
+    } else if (value <= 0xFFFF) {
+        writer.write((char) (major | 25));
+        writer.write((char) (value >> 8));
+        writer.write((char) value);
+    } else {
+        writer.write((char) (major | 26));
+        writer.write((char) (value >> 24));
+        writer.write((char) (value >> 16));
+        writer.write((char) (value >> 8));
+        writer.write((char) value);
+    }
+}
+
+static void cborWriteInt(BufferWriter& writer, long value) {
+    if (value < 0) {
+        cborWriteHead(writer, CBOR_MAJOR_NEGATIVE, (unsigned long) (-1 - value));
+    } else {
+        cborWriteHead(writer, CBOR_MAJOR_UNSIGNED, (unsigned long) value);
+    }
+}
+
+static void cborWriteText(BufferWriter& writer, const char* str) {
+    size_t length = strlen(str);
+
+    cborWriteHead(writer, CBOR_MAJOR_TEXT, length);
+    writer.write(str);
+}
+
+static void cborWriteFloat(BufferWriter& writer, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    writer.write((char) CBOR_FLOAT32);
+    writer.write((char) (bits >> 24));
+    writer.write((char) (bits >> 16));
+    writer.write((char) (bits >> 8));
+    writer.write((char) bits);
+}
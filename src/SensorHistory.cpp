@@ -0,0 +1,143 @@
+#include "SensorHistory.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SensorHistory::SensorHistory() {
+    this->clear();
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void SensorHistory::append(unsigned long time, const float* values) {
+    long fixed[SENSOR_HISTORY_CHANNELS];
+    for (int c = 0; c < SENSOR_HISTORY_CHANNELS; c++) {
+        fixed[c] = lroundf(values[c] * SensorHistory::SCALES[c]);
+    }
+
+    this->appends++;
+
+    if (this->used == 0) {
+        this->openBlock(time, fixed);
+        return;
+    }
+
+    Block& block = this->blocks[(this->first + this->used - 1) % SENSOR_HISTORY_BLOCKS];
+    unsigned long ticks = (time - this->lastTime) / SENSOR_HISTORY_TICK_MS;
+    bool fits = block.count < SENSOR_HISTORY_BLOCK_SAMPLES && ticks <= 0xFF;
+
+    for (int c = 0; fits && c < SENSOR_HISTORY_CHANNELS; c++) {
+        long delta = fixed[c] - this->lastFixed[c];
+        fits = delta >= -128 && delta <= 127;
+    }
+
+    if (!fits) {
+        this->openBlock(time, fixed);
+        return;
+    }
+
+    Delta& delta = block.deltas[block.count - 1];
+    delta.time = ticks;
+    for (int c = 0; c < SENSOR_HISTORY_CHANNELS; c++) {
+        delta.values[c] = fixed[c] - this->lastFixed[c];
+        this->lastFixed[c] = fixed[c];
+    }
+
+    // Keep the quantized time so that decoding accumulates exactly the same value
+    this->lastTime += ticks * SENSOR_HISTORY_TICK_MS;
+    block.count++;
+    this->samples++;
+}
+
+void SensorHistory::clear() {
+    this->first = 0;
+    this->used = 0;
+    this->samples = 0;
+    this->appends = 0;
+}
+
+size_t SensorHistory::size() {
+    return this->samples;
+}
+
+size_t SensorHistory::capacity() {
+    return SENSOR_HISTORY_BLOCKS * SENSOR_HISTORY_BLOCK_SAMPLES;
+}
+
+// Samples appended since the last clear(), dropped ones included
+unsigned long SensorHistory::appended() {
+    return this->appends;
+}
+
+// Iterates from the oldest sample to the newest
+void SensorHistory::begin(Cursor& cursor) {
+    cursor.block = 0;
+    cursor.sample = 0;
+}
+
+bool SensorHistory::next(Cursor& cursor, Sample& sample) {
+    if (cursor.block >= this->used) {
+        return false;
+    }
+
+    const Block& block = this->blocks[(this->first + cursor.block) % SENSOR_HISTORY_BLOCKS];
+
+    if (cursor.sample == 0) {
+        cursor.time = block.time;
+        memcpy(cursor.fixed, block.base, sizeof(cursor.fixed));
+    } else {
+        const Delta& delta = block.deltas[cursor.sample - 1];
+
+        cursor.time += delta.time * SENSOR_HISTORY_TICK_MS;
+        for (int c = 0; c < SENSOR_HISTORY_CHANNELS; c++) {
+            cursor.fixed[c] += delta.values[c];
+        }
+    }
+
+    sample.time = cursor.time;
+    for (int c = 0; c < SENSOR_HISTORY_CHANNELS; c++) {
+        sample.values[c] = (float) cursor.fixed[c] / SensorHistory::SCALES[c];
+    }
+
+    if (++cursor.sample >= block.count) {
+        cursor.block++;
+        cursor.sample = 0;
+    }
+
+    return true;
+}
+
+// ---------------
+// PRIVATE STATIC ATTRIBUTES
+// ---------------
+
+// centi-°C, centi-%RH, Pa: samples are read back in the units they were appended in
+const long SensorHistory::SCALES[SENSOR_HISTORY_CHANNELS] = { 100, 100, 1 };
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+void SensorHistory::openBlock(unsigned long time, const long* fixed) {
+    if (this->used == SENSOR_HISTORY_BLOCKS) {
+        this->samples -= this->blocks[this->first].count;
+        this->first = (this->first + 1) % SENSOR_HISTORY_BLOCKS;
+        this->used--;
+    }
+
+    Block& block = this->blocks[(this->first + this->used) % SENSOR_HISTORY_BLOCKS];
+    block.time = time;
+    memcpy(block.base, fixed, sizeof(block.base));
+    block.count = 1;
+
+    this->used++;
+    this->samples++;
+
+    this->lastTime = time;
+    memcpy(this->lastFixed, fixed, sizeof(this->lastFixed));
+}
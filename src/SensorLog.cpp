@@ -0,0 +1,357 @@
+#include "SensorLog.h"
+
+
+#define SENSOR_LOG_INDEX_EMPTY 0xFFFFFFFF
+
+
+// CRC-32 (IEEE 802.3) with a 16 entry table, a nibble at a time
+static uint32_t crc32(uint32_t crc, const void* data, size_t length);
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SensorLog::SensorLog(BlockDevice& device) : device(device) {
+    this->ready = false;
+    this->blocks = 0;
+    this->stride = 1;
+    this->count = 0;
+    this->started = false;
+    this->dirty = false;
+    this->dirtyMs = 0;
+    this->errors = 0;
+    this->clock = 0;
+    this->clockMs = 0;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// Mounts the ring: samples one header per stride into the index, follows the newest sampled
+// block forward to the last block written, and reloads it up to its last valid record
+bool SensorLog::begin(unsigned long ms) {
+    this->ready = false;
+
+    if (!this->device.begin()) {
+        return false;
+    }
+
+    uint32_t deviceBlocks = this->device.getBlockCount();
+
+    this->stride = (deviceBlocks + SENSOR_LOG_INDEX_SIZE - 1) / SENSOR_LOG_INDEX_SIZE;
+    this->blocks = this->stride > 0 ? deviceBlocks / this->stride * this->stride : 0;
+    if (this->blocks < 2) {
+        return false;
+    }
+
+    for (size_t i = 0; i < SENSOR_LOG_INDEX_SIZE; i++) {
+        this->index[i].sequence = SENSOR_LOG_INDEX_EMPTY;
+    }
+
+    Header header;
+    uint32_t newest = 0;
+    bool found = false;
+
+    for (uint32_t position = 0; position < this->blocks; position += this->stride) {
+        if (!this->readHeader(position, header) || header.sequence % this->blocks != position) {
+            continue;
+        }
+
+        this->indexBlock(header.sequence, header.time);
+        if (!found || header.sequence > newest) {
+            newest = header.sequence;
+            found = true;
+        }
+    }
+
+    this->started = found;
+    this->count = 0;
+    this->dirty = false;
+    this->clock = 0;
+    this->clockMs = ms;
+
+    if (found) {
+        for (uint32_t sequence = newest + 1; sequence < newest + this->stride; sequence++) {
+            if (!this->readHeader(sequence % this->blocks, header) || header.sequence != sequence) {
+                break;
+            }
+            newest = sequence;
+        }
+
+        if (!this->device.read(newest % this->blocks, 0, &this->head, sizeof(this->head))) {
+            return false;
+        }
+
+        // A torn tail is dropped from RAM, the next flush() overwrites it on the device
+        this->count = this->countRecords(this->head);
+        memset(&this->head.records[this->count], 0, (SENSOR_LOG_BLOCK_RECORDS - this->count) * sizeof(SensorLogRecord));
+        memset(this->head.padding, 0, sizeof(this->head.padding));
+
+        this->clock = (this->count > 0 ? this->head.records[this->count - 1].time : this->head.header.time) + 1;
+    }
+
+    this->ready = true;
+    return true;
+}
+
+bool SensorLog::isReady() const {
+    return this->ready;
+}
+
+// Whole seconds only, the remainder stays in clockMs so the clock does not drift
+uint32_t SensorLog::now(unsigned long ms) {
+    unsigned long seconds = (ms - this->clockMs) / 1000;
+
+    this->clock += seconds;
+    this->clockMs += seconds * 1000;
+
+    return this->clock;
+}
+
+// Moves the clock forward to an external time, e.g. from NTP; never back, so records stay ordered
+void SensorLog::setTime(uint32_t time, unsigned long ms) {
+    if (time > this->now(ms)) {
+        this->clock = time;
+    }
+}
+
+// Refused while a full block still waits for flush()
+bool SensorLog::append(const SensorSnapshot& snapshot, unsigned long ms) {
+    if (!this->ready) {
+        return false;
+    }
+
+    uint32_t time = this->now(ms);
+
+    if (!this->started) {
+        this->openBlock(0, time);
+    } else if (this->count == SENSOR_LOG_BLOCK_RECORDS) {
+        if (this->dirty) {
+            this->errors++;
+            return false;
+        }
+        this->openBlock(this->head.header.sequence + 1, time);
+    }
+
+    uint32_t sequence = this->head.header.sequence;
+    SensorLogRecord& record = this->head.records[this->count];
+
+    record.time = time;
+    memcpy(record.channels, snapshot.channels, sizeof(record.channels));
+    record.crc = SensorLog::recordCrc(sequence, record);
+
+    // A block recovered without records gets the time of its new first record
+    if (this->count == 0 && this->head.header.time != time) {
+        this->head.header.time = time;
+        this->head.header.crc = SensorLog::headerCrc(this->head.header);
+        this->indexBlock(sequence, time);
+    }
+
+    this->count++;
+    if (!this->dirty) {
+        this->dirty = true;
+        this->dirtyMs = ms;
+    }
+
+    return true;
+}
+
+// A full block, or records that have waited delayMs in RAM
+bool SensorLog::isFlushDue(unsigned long ms, unsigned long delayMs) const {
+    return this->dirty && (this->count == SENSOR_LOG_BLOCK_RECORDS || ms - this->dirtyMs >= delayMs);
+}
+
+// Writes the RAM block in place; a partial block is written again as it fills
+bool SensorLog::flush() {
+    if (!this->dirty) {
+        return true;
+    }
+
+    if (!this->device.write(this->head.header.sequence % this->blocks, &this->head)) {
+        this->errors++;
+        return false;
+    }
+
+    this->dirty = false;
+    return true;
+}
+
+// Places the cursor at the start of the block holding the first record at or after time:
+// the nearest indexed block at or before it, then at most a stride of header reads
+void SensorLog::seek(Cursor& cursor, uint32_t time) {
+    cursor.sequence = this->oldest();
+    cursor.record = 0;
+
+    if (!this->ready || !this->started) {
+        return;
+    }
+
+    uint32_t newest = this->head.header.sequence;
+
+    for (size_t i = 0; i < SENSOR_LOG_INDEX_SIZE; i++) {
+        const IndexEntry& entry = this->index[i];
+
+        if (entry.sequence != SENSOR_LOG_INDEX_EMPTY && entry.sequence > cursor.sequence &&
+                entry.sequence <= newest && entry.time <= time) {
+            cursor.sequence = entry.sequence;
+        }
+    }
+
+    Header header;
+    while (cursor.sequence < newest) {
+        if (cursor.sequence + 1 == newest) {
+            header = this->head.header;
+        } else if (!this->readHeader((cursor.sequence + 1) % this->blocks, header) || header.sequence != cursor.sequence + 1) {
+            break;
+        }
+
+        if (header.time > time) {
+            break;
+        }
+        cursor.sequence++;
+    }
+}
+
+// Oldest first. Records that fail their CRC end their block, and a cursor overtaken by the
+// writer continues from the oldest block still in the ring.
+bool SensorLog::next(Cursor& cursor, SensorLogRecord& record) {
+    if (!this->ready || !this->started) {
+        return false;
+    }
+
+    uint32_t newest = this->head.header.sequence;
+
+    if (cursor.sequence < this->oldest()) {
+        cursor.sequence = this->oldest();
+        cursor.record = 0;
+    }
+
+    while (cursor.sequence < newest) {
+        if (cursor.record < SENSOR_LOG_BLOCK_RECORDS &&
+                this->device.read(cursor.sequence % this->blocks, sizeof(Header) + cursor.record * sizeof(SensorLogRecord),
+                    &record, sizeof(record)) &&
+                record.crc == SensorLog::recordCrc(cursor.sequence, record)) {
+            cursor.record++;
+            return true;
+        }
+
+        cursor.sequence++;
+        cursor.record = 0;
+    }
+
+    if (cursor.sequence == newest && cursor.record < this->count) {
+        record = this->head.records[cursor.record++];
+        return true;
+    }
+
+    return false;
+}
+
+// Every block but the newest is full
+uint32_t SensorLog::size() const {
+    if (!this->started) {
+        return 0;
+    }
+
+    return (this->head.header.sequence - this->oldest()) * SENSOR_LOG_BLOCK_RECORDS + this->count;
+}
+
+uint32_t SensorLog::capacity() const {
+    return this->blocks * SENSOR_LOG_BLOCK_RECORDS;
+}
+
+// Record slots used since the log was created, it changes with every append
+uint32_t SensorLog::getPosition() const {
+    return this->started ? this->head.header.sequence * SENSOR_LOG_BLOCK_RECORDS + this->count : 0;
+}
+
+// Failed block writes and records refused because the RAM block was still waiting for a flush
+unsigned long SensorLog::getErrors() const {
+    return this->errors;
+}
+
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// The block at the position the newest one takes over is only dropped once it is overwritten,
+// but it is already left out here so that readers never see it change under them
+uint32_t SensorLog::oldest() const {
+    if (!this->started || this->head.header.sequence < this->blocks - 1) {
+        return 0;
+    }
+
+    return this->head.header.sequence - (this->blocks - 1);
+}
+
+bool SensorLog::readHeader(uint32_t position, Header& header) {
+    return this->device.read(position, 0, &header, sizeof(header)) &&
+        header.magic == SENSOR_LOG_MAGIC && header.crc == SensorLog::headerCrc(header);
+}
+
+uint8_t SensorLog::countRecords(const Block& block) {
+    uint8_t valid = 0;
+
+    while (valid < SENSOR_LOG_BLOCK_RECORDS &&
+            block.records[valid].crc == SensorLog::recordCrc(block.header.sequence, block.records[valid])) {
+        valid++;
+    }
+
+    return valid;
+}
+
+void SensorLog::openBlock(uint32_t sequence, uint32_t time) {
+    memset(&this->head, 0, sizeof(this->head));
+
+    this->head.header.magic = SENSOR_LOG_MAGIC;
+    this->head.header.sequence = sequence;
+    this->head.header.time = time;
+    this->head.header.crc = SensorLog::headerCrc(this->head.header);
+
+    this->count = 0;
+    this->started = true;
+
+    this->indexBlock(sequence, time);
+}
+
+void SensorLog::indexBlock(uint32_t sequence, uint32_t time) {
+    if (sequence % this->stride != 0) {
+        return;
+    }
+
+    IndexEntry& entry = this->index[(sequence / this->stride) % SENSOR_LOG_INDEX_SIZE];
+    entry.sequence = sequence;
+    entry.time = time;
+}
+
+// Fields in the SAMD21 byte order, little-endian, the CRC is the last field of both structures
+uint32_t SensorLog::headerCrc(const Header& header) {
+    return ~crc32(0xFFFFFFFF, &header, sizeof(Header) - sizeof(uint32_t));
+}
+
+uint32_t SensorLog::recordCrc(uint32_t sequence, const SensorLogRecord& record) {
+    uint32_t crc = crc32(0xFFFFFFFF, &sequence, sizeof(sequence));
+
+    return ~crc32(crc, &record, sizeof(SensorLogRecord) - sizeof(uint32_t));
+}
+
+
+static uint32_t crc32(uint32_t crc, const void* data, size_t length) {
+    static const uint32_t TABLE[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t* bytes = (const uint8_t*) data;
+
+    for (size_t i = 0; i < length; i++) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ TABLE[crc & 0x0F];
+    }
+
+    return crc;
+}
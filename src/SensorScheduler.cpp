@@ -0,0 +1,73 @@
+#include "SensorScheduler.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SensorScheduler::SensorScheduler() {
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        this->periods[group] = 0;
+        this->deadlines[group] = 0;
+    }
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// A period of 0 disables the group
+void SensorScheduler::setPeriod(int group, unsigned long period) {
+    this->periods[group] = period;
+}
+
+unsigned long SensorScheduler::getPeriod(int group) {
+    return this->periods[group];
+}
+
+// Every group has just been read, the first deadlines are one period away
+void SensorScheduler::start(unsigned long now) {
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        this->deadlines[group] = now + this->periods[group];
+    }
+}
+
+// Returns the most overdue group and schedules its next deadline, or -1 if nothing is due.
+// Only one group is returned per call so that reads are spread across loop iterations.
+int SensorScheduler::next(unsigned long now) {
+    int due = -1;
+    long dueLateness = -1;
+
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        if (this->periods[group] == 0) {
+            continue;
+        }
+
+        long lateness = (long) (now - this->deadlines[group]);
+
+        if (lateness >= 0 && lateness > dueLateness) {
+            due = group;
+            dueLateness = lateness;
+        }
+    }
+
+    if (due < 0) {
+        return -1;
+    }
+
+    // Stay on the original grid, unless a whole period was missed: then restart from now
+    // rather than catching up with a burst of back-to-back reads
+    this->deadlines[due] += this->periods[due];
+    if ((long) (now - this->deadlines[due]) >= 0) {
+        this->deadlines[due] = now + this->periods[due];
+    }
+
+    return due;
+}
+
+unsigned long SensorScheduler::timeUntil(int group, unsigned long now) {
+    long remaining = (long) (this->deadlines[group] - now);
+
+    return remaining > 0 ? (unsigned long) remaining : 0;
+}
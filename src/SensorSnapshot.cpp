@@ -0,0 +1,66 @@
+#include "SensorSnapshot.h"
+
+
+// Orders the slot accesses against the sequence updates; a single core needs no more
+#define SENSOR_SNAPSHOT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+
+// Rounds to the nearest thousandth, readings outside the int32_t range become invalid
+int32_t sensorFixed(float value) {
+    if (isnan(value)) {
+        return SENSOR_SNAPSHOT_INVALID;
+    }
+
+    float scaled = value * SENSOR_SNAPSHOT_SCALE;
+    if (scaled >= 2147483520.0f || scaled <= -2147483520.0f) {
+        return SENSOR_SNAPSHOT_INVALID;
+    }
+
+    return (int32_t) (scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+SensorSnapshotBuffer::SensorSnapshotBuffer() {
+    memset(this->slots, 0, sizeof(this->slots));
+    this->sequence = 0;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// The back slot starts as a copy of the front, so a refresh only sets the channels it read
+SensorSnapshot& SensorSnapshotBuffer::edit() {
+    uint32_t front = (this->sequence >> 1) & 1;
+
+    this->sequence = this->sequence + 1;
+    SENSOR_SNAPSHOT_BARRIER();
+
+    this->slots[front ^ 1] = this->slots[front];
+    return this->slots[front ^ 1];
+}
+
+void SensorSnapshotBuffer::publish() {
+    SENSOR_SNAPSHOT_BARRIER();
+    this->sequence = this->sequence + 1;
+}
+
+const SensorSnapshot& SensorSnapshotBuffer::read(uint32_t& sequence) const {
+    sequence = this->sequence & ~1UL;
+    SENSOR_SNAPSHOT_BARRIER();
+
+    return this->slots[(sequence >> 1) & 1];
+}
+
+// The front slot read at sequence s is only written again by the edit() that moves the
+// counter to s + 3, the publication after the next one
+bool SensorSnapshotBuffer::valid(uint32_t sequence) const {
+    SENSOR_SNAPSHOT_BARRIER();
+
+    return this->sequence - sequence < 3;
+}
@@ -0,0 +1,153 @@
+#include "TaskScheduler.h"
+
+
+#define TASK_WHEEL_SLOT(time) (((time) / TASK_WHEEL_TICK_MS) % TASK_WHEEL_SLOTS)
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+TaskScheduler::TaskScheduler() {
+    this->taskCount = 0;
+    this->wheelTick = 0;
+
+    for (size_t slot = 0; slot < TASK_WHEEL_SLOTS; slot++) {
+        this->wheel[slot] = NULL;
+    }
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+// Returns the task index, or -1 when the table is full
+int TaskScheduler::add(const char* name, TaskFunction function, unsigned long period, uint8_t priority) {
+    if (this->taskCount == TASK_SCHEDULER_MAX) {
+        return -1;
+    }
+
+    Task& task = this->tasks[this->taskCount];
+    task.name = name;
+    task.function = function;
+    task.period = (period == 0 ? 1 : period);
+    task.priority = priority;
+    task.deadline = 0;
+    task.runs = 0;
+    task.overruns = 0;
+    task.maxRunUs = 0;
+    task.next = NULL;
+
+    return (int) this->taskCount++;
+}
+
+// Every task is due right away
+void TaskScheduler::start(unsigned long now) {
+    for (size_t slot = 0; slot < TASK_WHEEL_SLOTS; slot++) {
+        this->wheel[slot] = NULL;
+    }
+
+    this->wheelTick = now / TASK_WHEEL_TICK_MS;
+
+    for (size_t i = 0; i < this->taskCount; i++) {
+        this->tasks[i].deadline = now;
+        this->schedule(&this->tasks[i]);
+    }
+}
+
+// Collects the due tasks from the slots elapsed since the last pass, then runs them by
+// priority. Returns false when nothing was due.
+bool TaskScheduler::run(unsigned long now) {
+    Task* ready = NULL;
+
+    unsigned long nowTick = now / TASK_WHEEL_TICK_MS;
+    unsigned long ticks = nowTick - this->wheelTick;
+    if (ticks >= TASK_WHEEL_SLOTS) {
+        ticks = TASK_WHEEL_SLOTS - 1;
+    }
+
+    // The current slot is walked again on the next pass: it may hold later deadlines
+    for (unsigned long tick = nowTick - ticks; ; tick++) {
+        Task** link = &this->wheel[tick % TASK_WHEEL_SLOTS];
+
+        while (*link != NULL) {
+            Task* task = *link;
+
+            if ((long) (now - task->deadline) < 0) {
+                link = &task->next;
+                continue;
+            }
+
+            *link = task->next;
+
+            Task** position = &ready;
+            while (*position != NULL && (*position)->priority <= task->priority) {
+                position = &(*position)->next;
+            }
+            task->next = *position;
+            *position = task;
+        }
+
+        if (tick == nowTick) {
+            break;
+        }
+    }
+    this->wheelTick = nowTick;
+
+    if (ready == NULL) {
+        return false;
+    }
+
+    while (ready != NULL) {
+        Task* task = ready;
+        ready = task->next;
+
+        unsigned long start = micros();
+        task->function();
+        unsigned long duration = micros() - start;
+
+        task->runs++;
+        if (duration > task->maxRunUs) {
+            task->maxRunUs = duration;
+        }
+
+        // Same grid policy as SensorScheduler: restart from now after a missed period
+        unsigned long finished = millis();
+        task->deadline += task->period;
+        if ((long) (finished - task->deadline) >= 0) {
+            task->overruns++;
+            task->deadline = finished + task->period;
+        }
+
+        this->schedule(task);
+    }
+
+    return true;
+}
+
+// Sleeps until the next interrupt, at the latest the 1 ms SysTick
+void TaskScheduler::idle() {
+#ifdef ARDUINO_ARCH_SAMD
+    __WFI();
+#endif
+}
+
+size_t TaskScheduler::count() {
+    return this->taskCount;
+}
+
+const TaskScheduler::Task& TaskScheduler::get(size_t i) {
+    return this->tasks[i];
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+void TaskScheduler::schedule(Task* task) {
+    Task** slot = &this->wheel[TASK_WHEEL_SLOT(task->deadline)];
+
+    task->next = *slot;
+    *slot = task;
+}
@@ -0,0 +1,101 @@
+#include <utility/wifi_drv.h>
+
+#include "WiFiConnection.h"
+
+
+// ---------------
+// CONSTRUCTORS & DESTRUCTORS
+// ---------------
+
+WiFiConnection::WiFiConnection(const char* ssid, const char* passphrase) {
+    this->ssid = ssid;
+    this->passphrase = passphrase;
+
+    this->state = WIFI_STATE_IDLE;
+    this->status = WL_IDLE_STATUS;
+    this->lastPollMs = 0;
+    this->stateSinceMs = 0;
+    this->backoffMs = WIFI_BACKOFF_MIN_MS;
+    this->retryDelayMs = 0;
+}
+
+
+// ---------------
+// PUBLIC METHODS
+// ---------------
+
+void WiFiConnection::begin(unsigned long now) {
+    this->connect(now);
+}
+
+// Returns true when the cached status changed
+bool WiFiConnection::loop(unsigned long now) {
+    if (this->state == WIFI_STATE_IDLE) {
+        return false;
+    }
+
+    if (this->state == WIFI_STATE_BACKOFF) {
+        if (now - this->stateSinceMs >= this->retryDelayMs) {
+            this->connect(now);
+        }
+        return false;
+    }
+
+    if (now - this->lastPollMs < WIFI_STATUS_POLL_MS) {
+        return false;
+    }
+    this->lastPollMs = now;
+
+    uint8_t previous = this->status;
+    this->status = WiFiDrv::getConnectionStatus();
+
+    if (this->status == WL_CONNECTED) {
+        if (this->state != WIFI_STATE_CONNECTED) {
+            this->localIP = WiFi.localIP();
+            this->state = WIFI_STATE_CONNECTED;
+            this->stateSinceMs = now;
+            this->backoffMs = WIFI_BACKOFF_MIN_MS;
+        }
+    } else if (this->state == WIFI_STATE_CONNECTED) {
+        this->retry(now);
+    } else if (this->status == WL_CONNECT_FAILED || this->status == WL_NO_SSID_AVAIL ||
+               now - this->stateSinceMs >= WIFI_CONNECT_TIMEOUT_MS) {
+        this->retry(now);
+    }
+
+    return this->status != previous;
+}
+
+bool WiFiConnection::connected() {
+    return this->state == WIFI_STATE_CONNECTED;
+}
+
+// Read once when the link comes up
+IPAddress WiFiConnection::getLocalIP() {
+    return this->localIP;
+}
+
+// ---------------
+// PRIVATE METHODS
+// ---------------
+
+// Same as WiFi.begin(), minus the wait: the NINA firmware keeps connecting on its own
+void WiFiConnection::connect(unsigned long now) {
+    WiFiDrv::wifiSetPassphrase(this->ssid, strlen(this->ssid), this->passphrase, strlen(this->passphrase));
+
+    this->state = WIFI_STATE_CONNECTING;
+    this->stateSinceMs = now;
+    this->lastPollMs = now;
+}
+
+// Waits the current backoff, plus a random quarter of it to spread the reconnects of
+// carriers that lost the same access point, then doubles it up to WIFI_BACKOFF_MAX_MS
+void WiFiConnection::retry(unsigned long now) {
+    WiFiDrv::disconnect();
+
+    this->state = WIFI_STATE_BACKOFF;
+    this->stateSinceMs = now;
+    this->retryDelayMs = this->backoffMs + random(this->backoffMs / 4 + 1);
+
+    this->backoffMs = (this->backoffMs >= WIFI_BACKOFF_MAX_MS / 2 ? WIFI_BACKOFF_MAX_MS : this->backoffMs * 2);
+}
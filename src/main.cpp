@@ -1,10 +1,21 @@
 #include <Arduino.h>
+#include <limits.h>
 
 #include <WiFiNINA.h>
 #include <coap-simple.h>
-#include <ArduinoJson.h>
 
 #include "CarrierManager.h"
+#include "CoapBlockwise.h"
+#include "CoapMessage.h"
+#include "CoapObservers.h"
+#include "CoapOptions.h"
+#include "CoapServer.h"
+#include "MemoryTelemetry.h"
+#include "Profiler.h"
+#include "SenMLCache.h"
+#include "SenMLWriter.h"
+#include "TaskScheduler.h"
+#include "WiFiConnection.h"
 #include "arduino_secrets.h"
 
 
@@ -13,43 +24,142 @@
 #define SETUP_DELAY_MS 5000
 
 #define LOOP_CARRIER_UPDATE_MS 10000
+#define LOOP_IMU_UPDATE_MS 500
+#define LOOP_ORIENTATION_UPDATE_MS 20
+
+#define TASK_COAP_PERIOD_MS 5
+#define TASK_WIFI_PERIOD_MS 100
+#define TASK_SENSORS_PERIOD_MS 5
+#define TASK_INPUTS_PERIOD_MS 20
+#define TASK_GFX_PERIOD_MS 10          // frames stream out in slices, see CarrierManager::gfxLoop()
+#define TASK_LOG_PERIOD_MS 100
+#define TASK_COAP_MAX_PACKETS 4         // per activation, a burst from several collectors drains in one go
+#define TASK_COAP_BUDGET_US 3000        // leaves the other tasks most of the 5 ms period
+// #define TASK_MEMORY_DUMP_PERIOD_MS 60000     // periodic memory line on the serial port
+
+// Lower runs first when several tasks are due together
+#define TASK_COAP_PRIORITY 0
+#define TASK_WIFI_PRIORITY 1
+#define TASK_SENSORS_PRIORITY 2
+#define TASK_INPUTS_PRIORITY 3
+#define TASK_GFX_PRIORITY 4
+#define TASK_LOG_PRIORITY 5
+#define TASK_MEMORY_DUMP_PRIORITY 6
+
+#define LOG_CLOCK_SYNC_RETRY_MS 60000   // until the NINA has the network time
 
 #define WIFI_DELAY_FIRMWARE_NOT_UPDATED 500
 #define WIFI_RETRY_LOOPS_LIMIT 5
-#define WIFI_RETRY_DELAY_MS 1000
-#define WIFI_RETRY_LOOP_TIMEOUT_MS 60000
 #define UDP_COAP_PORT 5683
 
+// Content-Format numbers are spelled out so they can be pasted into the link-format string
+#define CORE_CT_LINK_FORMAT 40
+#define CORE_CT_JSON 50
+
+#define COAP_DISCOVERY_RESOURCE_NAME ".well-known/core"
+#define CORE_DISCOVERY_CT CORE_CT_LINK_FORMAT
+
 #define COAP_TEMP_RESOURCE_NAME "temperature"
 #define COAP_HMDT_RESOURCE_NAME "humidity"
 #define COAP_PRSS_RESOURCE_NAME "pressure"
 #define COAP_ACCL_RESOURCE_NAME "accelerometer"
 #define COAP_GYRO_RESOURCE_NAME "gyroscope"
+#define COAP_SNSR_RESOURCE_NAME "sensors"
+#define COAP_HIST_RESOURCE_NAME "history"
+#define COAP_SLOG_RESOURCE_NAME "log"
+#define COAP_VIBR_RESOURCE_NAME "vibration"
+#define COAP_ORNT_RESOURCE_NAME "orientation"
+#define COAP_TASK_RESOURCE_NAME "diag/tasks"
+#define COAP_TIME_RESOURCE_NAME "diag/timing"
+#define COAP_MEMR_RESOURCE_NAME "diag/memory"
+#define COAP_GEST_RESOURCE_NAME "events/gesture"
+#define COAP_MOTN_RESOURCE_NAME "events/motion"
 
 #define CORE_TEMP_TITLE "temperature-sensor"
 #define CORE_TEMP_RT "iot.mkriotcarrier.sensor.env.temperature"
 #define CORE_TEMP_IF "core.s"
-#define CORE_TEMP_CT COAP_APPLICATION_JSON
+#define CORE_TEMP_CT CORE_CT_JSON
 
 #define CORE_HMDT_TITLE "humidity-sensor"
 #define CORE_HMDT_RT "iot.mkriotcarrier.sensor.env.humidity"
 #define CORE_HMDT_IF "core.s"
-#define CORE_HMDT_CT COAP_APPLICATION_JSON
+#define CORE_HMDT_CT CORE_CT_JSON
 
 #define CORE_PRSS_TITLE "pressure-sensor"
 #define CORE_PRSS_RT "iot.mkriotcarrier.sensor.pressure"
 #define CORE_PRSS_IF "core.s"
-#define CORE_PRSS_CT COAP_APPLICATION_JSON
+#define CORE_PRSS_CT CORE_CT_JSON
 
 #define CORE_ACCL_TITLE "accel-sensor"
 #define CORE_ACCL_RT "iot.mkriotcarrier.sensor.accelerometer"
 #define CORE_ACCL_IF "core.s"
-#define CORE_ACCL_CT COAP_APPLICATION_JSON
+#define CORE_ACCL_CT CORE_CT_JSON
 
 #define CORE_GYRO_TITLE "gyro-sensor"
 #define CORE_GYRO_RT "iot.mkriotcarrier.sensor.gyroscope"
 #define CORE_GYRO_IF "core.s"
-#define CORE_GYRO_CT COAP_APPLICATION_JSON
+#define CORE_GYRO_CT CORE_CT_JSON
+
+#define CORE_SNSR_TITLE "sensors-batch"
+#define CORE_SNSR_RT "iot.mkriotcarrier.sensors"
+#define CORE_SNSR_IF "core.b"
+#define CORE_SNSR_CT CORE_CT_JSON
+
+#define CORE_HIST_TITLE "sensor-history"
+#define CORE_HIST_RT "iot.mkriotcarrier.sensor.history"
+#define CORE_HIST_IF "core.s"
+#define CORE_HIST_CT CORE_CT_JSON
+
+#define CORE_SLOG_TITLE "sensor-log"
+#define CORE_SLOG_RT "iot.mkriotcarrier.sensor.log"
+#define CORE_SLOG_IF "core.s"
+#define CORE_SLOG_CT CORE_CT_JSON
+
+#define CORE_VIBR_TITLE "imu-statistics"
+#define CORE_VIBR_RT "iot.mkriotcarrier.sensor.imu.statistics"
+#define CORE_VIBR_IF "core.s"
+#define CORE_VIBR_CT CORE_CT_JSON
+
+#define CORE_ORNT_TITLE "orientation"
+#define CORE_ORNT_RT "iot.mkriotcarrier.sensor.imu.orientation"
+#define CORE_ORNT_IF "core.s"
+#define CORE_ORNT_CT CORE_CT_JSON
+
+#define CORE_TASK_TITLE "task-statistics"
+#define CORE_TASK_RT "iot.mkriotcarrier.diag.tasks"
+#define CORE_TASK_IF "core.rp"
+#define CORE_TASK_CT CORE_CT_JSON
+
+#define CORE_TIME_TITLE "loop-timing"
+#define CORE_TIME_RT "iot.mkriotcarrier.diag.timing"
+#define CORE_TIME_IF "core.rp"
+#define CORE_TIME_CT CORE_CT_JSON
+
+#define CORE_MEMR_TITLE "memory"
+#define CORE_MEMR_RT "iot.mkriotcarrier.diag.memory"
+#define CORE_MEMR_IF "core.rp"
+#define CORE_MEMR_CT CORE_CT_JSON
+
+#define CORE_GEST_TITLE "gesture-events"
+#define CORE_GEST_RT "iot.mkriotcarrier.events.gesture"
+#define CORE_GEST_IF "core.s"
+#define CORE_GEST_CT CORE_CT_JSON
+
+#define CORE_MOTN_TITLE "motion-events"
+#define CORE_MOTN_RT "iot.mkriotcarrier.events.motion"
+#define CORE_MOTN_IF "core.s"
+#define CORE_MOTN_CT CORE_CT_JSON
+
+#define HISTORY_QUERY_SINCE "since="
+#define HISTORY_QUERY_LIMIT "limit="
+
+#define LOG_QUERY_FROM "from="
+#define LOG_QUERY_TO "to="
+#define LOG_QUERY_LIMIT "limit="
+#define LOG_QUERY_LIMIT_DEFAULT 8       // records, each block of the response replays the query
+#define LOG_QUERY_LIMIT_MAX 32
+#define TIMING_QUERY_PHASE "phase="
+#define TIMING_PERCENTILE 99
 
 #define SENML_BN "mkriotcarrier:rack:env"
 #define SENML_BVER 1.0
@@ -71,235 +181,1763 @@
 #define SENML_N_GYROSCOPE_Y "gyro:y"
 #define SENML_N_GYROSCOPE_Z "gyro:z"
 
+#define SENML_N_STATISTICS_MEAN ":mean"
+#define SENML_N_STATISTICS_MIN ":min"
+#define SENML_N_STATISTICS_MAX ":max"
+#define SENML_N_STATISTICS_RMS ":rms"
+#define SENML_N_STATISTICS_SAMPLES "imu:samples"
+
+#define SENML_N_ORIENTATION_QW "orientation:qw"
+#define SENML_N_ORIENTATION_QX "orientation:qx"
+#define SENML_N_ORIENTATION_QY "orientation:qy"
+#define SENML_N_ORIENTATION_QZ "orientation:qz"
+#define SENML_N_ORIENTATION_ROLL "orientation:roll"
+#define SENML_N_ORIENTATION_PITCH "orientation:pitch"
+#define SENML_N_ORIENTATION_YAW "orientation:yaw"
+#define SENML_U_ORIENTATION_ANGLE "rad"
+
+#define SENML_N_TASK_PREFIX "task:"
+#define SENML_N_TASK_RUNS ":runs"
+#define SENML_N_TASK_OVERRUNS ":overruns"
+#define SENML_N_TASK_MAX_RUN ":max"
+#define SENML_U_TASK_MAX_RUN "s"
+#define SENML_N_TIMING_PREFIX "timing:"
+#define SENML_N_TIMING_COUNT ":count"
+#define SENML_N_TIMING_MIN ":min"
+#define SENML_N_TIMING_MAX ":max"
+#define SENML_N_TIMING_P99 ":p99"
+#define SENML_N_TIMING_BUCKET ":b"
+#define SENML_U_TIMING "s"
+#define SENML_N_MEMORY_HEAP_USED "memory:heap:used"
+#define SENML_N_MEMORY_HEAP_PEAK "memory:heap:peak"
+#define SENML_N_MEMORY_HEAP_FREE "memory:heap:free"
+#define SENML_N_MEMORY_HEAP_LARGEST "memory:heap:largest"
+#define SENML_N_MEMORY_HEAP_ARENA "memory:heap:arena"
+#define SENML_N_MEMORY_GAP "memory:gap"
+#define SENML_N_MEMORY_STACK_USED "memory:stack:used"
+#define SENML_N_MEMORY_FREES "memory:frees"
+#define SENML_N_MEMORY_FAILURES "memory:failures"
+#define SENML_N_MEMORY_ENCODE_FAILURES "memory:encode-failures"
+#define SENML_N_MEMORY_ALLOCATIONS_PREFIX "memory:alloc:"
+#define SENML_U_MEMORY "B"
+#define SENML_N_GESTURE "gesture"
+#define SENML_N_MOTION "motion"
+#define SENML_N_EVENTS_DROPPED "events:dropped"
+#define SENML_NAME_MAX 32
+
+#define SENML_D_TEMPERATURE 2
+#define SENML_D_HUMIDITY 2
+#define SENML_D_PRESSURE 0
+#define SENML_D_ACCELEROMETER 4
+#define SENML_D_GYROSCOPE 3
+#define SENML_D_ORIENTATION 4
+#define SENML_D_TASK_MAX_RUN 6
+#define SENML_D_TIMING 6
+
+#define SENSOR_VALUES_MAX 3
+#define VIBRATION_STATISTICS 4
+#define VIBRATION_VALUES (6 * VIBRATION_STATISTICS)
+
+#define EVENT_LOG_SIZE 8
+
+// In thousandths, as the snapshot channels
+#define OBSERVE_DEADBAND_TEMPERATURE 100
+#define OBSERVE_DEADBAND_HUMIDITY 500
+#define OBSERVE_DEADBAND_PRESSURE 10000
+#define OBSERVE_DEADBAND_ACCELEROMETER 20
+#define OBSERVE_DEADBAND_GYROSCOPE 1000
+
 #define CORE_IF "core.s"
 
+// FNV-1a over the state a representation was built from
+#define ETAG_HASH_BASIS 2166136261u
+#define ETAG_HASH_PRIME 16777619u
+
+// Snapshots of state that moves on every read, not worth caching anywhere
+#define SNAPSHOT_MAX_AGE 0
+
+// Seed picked so every path in the tables below lands in its own slot; a collision
+// shows up as a duplicate case value when dispatch() is compiled
+#define COAP_DISPATCH_SLOTS 64
+#define COAP_DISPATCH_SEED 2
+#define COAP_DISPATCH_SLOT(path) (coapPathHash(path, COAP_PATH_HASH_BASIS + COAP_DISPATCH_SEED) & (COAP_DISPATCH_SLOTS - 1))
+
+
+// Observable sensors, one row each: the SensorResource enum, the SenML encoders and caches,
+// the Observe state, the dispatch cases and the link-format entries are generated from it.
+//  X(id,  path,                    title,           rt,           if,           ct,           group,                      channel,                         enabled,      records,            deadband)
+#define SENSOR_RESOURCES(X) \
+    X(TEMP, COAP_TEMP_RESOURCE_NAME, CORE_TEMP_TITLE, CORE_TEMP_RT, CORE_TEMP_IF, CORE_TEMP_CT, SENSOR_GROUP_ENVIRONMENT,   SENSOR_CHANNEL_TEMPERATURE,      enabled_env,  SENML_TEMP_RECORDS, OBSERVE_DEADBAND_TEMPERATURE) \
+    X(HMDT, COAP_HMDT_RESOURCE_NAME, CORE_HMDT_TITLE, CORE_HMDT_RT, CORE_HMDT_IF, CORE_HMDT_CT, SENSOR_GROUP_ENVIRONMENT,   SENSOR_CHANNEL_HUMIDITY,         enabled_env,  SENML_HMDT_RECORDS, OBSERVE_DEADBAND_HUMIDITY) \
+    X(PRSS, COAP_PRSS_RESOURCE_NAME, CORE_PRSS_TITLE, CORE_PRSS_RT, CORE_PRSS_IF, CORE_PRSS_CT, SENSOR_GROUP_PRESSURE,      SENSOR_CHANNEL_PRESSURE,         enabled_prss, SENML_PRSS_RECORDS, OBSERVE_DEADBAND_PRESSURE) \
+    X(ACCL, COAP_ACCL_RESOURCE_NAME, CORE_ACCL_TITLE, CORE_ACCL_RT, CORE_ACCL_IF, CORE_ACCL_CT, SENSOR_GROUP_ACCELEROMETER, SENSOR_CHANNEL_ACCELEROMETER_X,  enabled_accl, SENML_ACCL_RECORDS, OBSERVE_DEADBAND_ACCELEROMETER) \
+    X(GYRO, COAP_GYRO_RESOURCE_NAME, CORE_GYRO_TITLE, CORE_GYRO_RT, CORE_GYRO_IF, CORE_GYRO_CT, SENSOR_GROUP_GYROSCOPE,     SENSOR_CHANNEL_GYROSCOPE_X,      enabled_gyro, SENML_GYRO_RECORDS, OBSERVE_DEADBAND_GYROSCOPE)
+
+#ifdef PROFILE_ENABLED
+#define SERVICE_RESOURCES_TIMING(X) \
+    X(TIME, COAP_TIME_RESOURCE_NAME, CORE_TIME_TITLE, CORE_TIME_RT, CORE_TIME_IF, CORE_TIME_CT, callback_time)
+#else
+#define SERVICE_RESOURCES_TIMING(X)
+#endif
+
+// Resources with their own handler
+//  X(id,  path,                    title,           rt,           if,           ct,           handler)
+#define SERVICE_RESOURCES(X) \
+    X(SNSR, COAP_SNSR_RESOURCE_NAME, CORE_SNSR_TITLE, CORE_SNSR_RT, CORE_SNSR_IF, CORE_SNSR_CT, callback_snsr) \
+    X(HIST, COAP_HIST_RESOURCE_NAME, CORE_HIST_TITLE, CORE_HIST_RT, CORE_HIST_IF, CORE_HIST_CT, callback_hist) \
+    X(SLOG, COAP_SLOG_RESOURCE_NAME, CORE_SLOG_TITLE, CORE_SLOG_RT, CORE_SLOG_IF, CORE_SLOG_CT, callback_slog) \
+    X(VIBR, COAP_VIBR_RESOURCE_NAME, CORE_VIBR_TITLE, CORE_VIBR_RT, CORE_VIBR_IF, CORE_VIBR_CT, callback_vibr) \
+    X(ORNT, COAP_ORNT_RESOURCE_NAME, CORE_ORNT_TITLE, CORE_ORNT_RT, CORE_ORNT_IF, CORE_ORNT_CT, callback_ornt) \
+    X(TASK, COAP_TASK_RESOURCE_NAME, CORE_TASK_TITLE, CORE_TASK_RT, CORE_TASK_IF, CORE_TASK_CT, callback_task) \
+    SERVICE_RESOURCES_TIMING(X) \
+    X(MEMR, COAP_MEMR_RESOURCE_NAME, CORE_MEMR_TITLE, CORE_MEMR_RT, CORE_MEMR_IF, CORE_MEMR_CT, callback_memr)
+
+// Input events, one log per type; observers are notified on every event, Observe registrations
+// use the resource numbers after the sensors
+//  X(id,  path,                    title,           rt,           if,           ct,           type,                record)
+#define EVENT_RESOURCES(X) \
+    X(GEST, COAP_GEST_RESOURCE_NAME, CORE_GEST_TITLE, CORE_GEST_RT, CORE_GEST_IF, CORE_GEST_CT, INPUT_EVENT_GESTURE, SENML_GEST_RECORD) \
+    X(MOTN, COAP_MOTN_RESOURCE_NAME, CORE_MOTN_TITLE, CORE_MOTN_RT, CORE_MOTN_IF, CORE_MOTN_CT, INPUT_EVENT_MOTION,  SENML_MOTN_RECORD)
+
+#define CORE_STRINGIFY_(value) #value
+#define CORE_STRINGIFY(value) CORE_STRINGIFY_(value)
+#define CORE_LINK(path, title, rt, iface, ct, attributes) \
+    ",</" path ">;ct=" CORE_STRINGIFY(ct) ";if=\"" iface "\";rt=\"" rt "\";title=\"" title "\"" attributes
+
+#define SENSOR_ENUM(id, ...) RESOURCE_##id,
+#define SENSOR_LINK(id, path, title, rt, iface, ct, ...) CORE_LINK(path, title, rt, iface, ct, ";obs")
+#define SERVICE_ENUM(id, ...) SERVICE_RESOURCE_##id,
+#define SERVICE_LINK(id, path, title, rt, iface, ct, handler) CORE_LINK(path, title, rt, iface, ct, "")
+#define EVENT_ENUM(id, ...) EVENT_RESOURCE_##id,
+#define EVENT_LINK(id, path, title, rt, iface, ct, ...) CORE_LINK(path, title, rt, iface, ct, ";obs")
+
+
+enum SensorResource {
+    SENSOR_RESOURCES(SENSOR_ENUM)
+    RESOURCE_COUNT
+};
+
+enum EventResource {
+    EVENT_RESOURCES(EVENT_ENUM)
+    EVENT_RESOURCE_COUNT
+};
+
+enum ServiceResource {
+    SERVICE_RESOURCES(SERVICE_ENUM)
+    SERVICE_RESOURCE_COUNT
+};
+
+#define EVENT_OBSERVER(resource) (RESOURCE_COUNT + (resource))
+
+struct ObservableResource {
+    const char* name;
+    const SenMLRecord* records;
+    SenMLCache* cache;
+    COAP_CONTENT_TYPE jsonType;
+    int group;
+    int channel;                // first of its consecutive snapshot channels
+    size_t channels;
+    bool (*enabled)(CarrierManager& carrier);
+    int32_t deadband;
+
+    int32_t notified[SENSOR_VALUES_MAX];
+    uint32_t sequence;
+};
+
+// The latest events of one type in a ring, the newest at (count - 1) % EVENT_LOG_SIZE
+struct EventLog {
+    const char* name;
+    const SenMLRecord* record;
+    COAP_CONTENT_TYPE jsonType;
+    uint8_t type;               // InputEventType
+
+    InputEvent events[EVENT_LOG_SIZE];
+    unsigned long count;        // every event logged since boot
+    uint32_t sequence;
+};
+
+struct EventPack {
+    SenMLFormat format;
+    const EventLog* log;
+};
+
+struct LogQuery {
+    SenMLFormat format;
+    unsigned long from;         // log clock, seconds
+    unsigned long to;
+    size_t limit;
+};
+
+struct HistoryQuery {
+    SenMLFormat format;
+    unsigned long since;
+    bool filtered;
+    size_t limit;
+};
+
+// Validator and lifetime of a representation (RFC 7252 §5.10.5, §5.10.6)
+struct Freshness {
+    uint32_t etag;
+    unsigned long maxAge;       // seconds
+    unsigned long time;         // latest update of the groups it covers
+};
+
+// The endpoint a block-wise snapshot was taken for; its ETag changes with every snapshot
+struct SnapshotOwner {
+    uint32_t generation;        // snapshots taken since boot
+    IPAddress ip;
+    int port;
+};
+
+struct VibrationPack {
+    SenMLFormat format;
+    unsigned long time;
+};
+
+struct OrientationPack {
+    SenMLFormat format;
+    SnapshotOwner owner;
+    CarrierManager::LSM6DS3_Orientation state;
+    unsigned long time;
+};
+
+struct TaskStatisticsPack {
+    SenMLFormat format;
+    SnapshotOwner owner;
+    unsigned long time;
+    size_t count;
+
+    unsigned long runs[TASK_SCHEDULER_MAX];
+    unsigned long overruns[TASK_SCHEDULER_MAX];
+    unsigned long maxRunUs[TASK_SCHEDULER_MAX];
+};
+
+#ifdef PROFILE_ENABLED
+struct TimingPack {
+    SenMLFormat format;
+    SnapshotOwner owner;
+    unsigned long time;
+    int phase;                  // -1 for the summary of every phase
+
+    uint32_t count[PROFILE_PHASE_COUNT];
+    uint32_t min[PROFILE_PHASE_COUNT];
+    uint32_t max[PROFILE_PHASE_COUNT];
+    uint32_t p99[PROFILE_PHASE_COUNT];
+    Profiler::Histogram histogram;
+};
+#endif
+
+struct MemoryPack {
+    SenMLFormat format;
+    SnapshotOwner owner;
+    unsigned long time;
+    MemoryTelemetry::Snapshot snapshot;
+    unsigned long encodeFailures;   // SenML packs that outgrew their cache buffer
+};
+
+struct SensorBatch {
+    SenMLFormat format;
+    unsigned int selection;     // bit per SensorResource
+    unsigned long time;
+};
+
 
 CarrierManager carrier;
 
+WiFiConnection wifi(SECRET_SSID, SECRET_PASS);
 WiFiUDP udp;
-Coap coap(udp);
+CoapServer server(udp);
+
+CoapObservers observers;
+
+TaskScheduler tasks;
+TaskStatisticsPack taskSnapshot;
+#ifdef PROFILE_ENABLED
+TimingPack timingSnapshot;
+#endif
+MemoryPack memorySnapshot;
+
+OrientationPack orientationSnapshot;
+
+bool logClockSynced = false;        // the sensor log clock runs on the network time
+unsigned long logClockSyncMs = 0;
+
+
+
+
+void dispatch(CoapPacket &packet, const char *resourcePath, IPAddress ip, int port);
+void handleReset(IPAddress ip, int port, uint16_t messageId);
+void handleAck(IPAddress ip, int port, uint16_t messageId);
+
+void callback_wkc(CoapPacket &packet, IPAddress ip, int port);
+void callback_snsr(CoapPacket &packet, IPAddress ip, int port);
+void callback_hist(CoapPacket &packet, IPAddress ip, int port);
+void callback_slog(CoapPacket &packet, IPAddress ip, int port);
+void callback_vibr(CoapPacket &packet, IPAddress ip, int port);
+void callback_ornt(CoapPacket &packet, IPAddress ip, int port);
+void callback_task(CoapPacket &packet, IPAddress ip, int port);
+#ifdef PROFILE_ENABLED
+void callback_time(CoapPacket &packet, IPAddress ip, int port);
+#endif
+void callback_memr(CoapPacket &packet, IPAddress ip, int port);
+
+void task_coap();
+void task_wifi();
+void task_sensors();
+void task_inputs();
+void task_gfx();
+void task_log();
+void task_memory_dump();
+
+bool enabled_env(CarrierManager& carrier);
+bool enabled_prss(CarrierManager& carrier);
+bool enabled_accl(CarrierManager& carrier);
+bool enabled_gyro(CarrierManager& carrier);
+
+bool negotiateSenMLFormat(CoapPacket &packet, SenMLFormat &format);
+void handleSensor(SensorResource resource, CoapPacket &packet, IPAddress ip, int port);
+bool sendSenML(ObservableResource &resource, SenMLFormat format, uint8_t type, uint16_t messageId,
+    const uint8_t *token, uint8_t tokenLength, bool observe, CoapBlock block, IPAddress ip, int port);
+void sendEmptyResponse(CoapPacket &packet, uint8_t code, IPAddress ip, int port);
+void sendServiceResponse(ServiceResource resource, CoapPacket &packet, SenMLFormat format, const Freshness &freshness,
+    CoapBlockGenerator generator, const void *context, IPAddress ip, int port);
+Freshness sensorFreshness(unsigned int groups, SenMLFormat format);
+void takeSnapshot(SnapshotOwner &owner, IPAddress ip, int port);
+bool ownsSnapshot(const SnapshotOwner &owner, IPAddress ip, int port);
+Freshness snapshotFreshness(const SnapshotOwner &owner, SenMLFormat format);
+bool sendValidIfMatched(CoapPacket &packet, const Freshness &freshness, const uint32_t *sequence, IPAddress ip, int port);
+
+void writeSensorBatch(BufferWriter &writer, const void *context);
+bool parseSensorSelection(CoapPacket &packet, unsigned int &selection);
+void writeHistory(BufferWriter &writer, const void *context);
+bool parseHistoryQuery(CoapPacket &packet, HistoryQuery &query);
+void writeLog(BufferWriter &writer, const void *context);
+bool parseLogQuery(CoapPacket &packet, LogQuery &query);
+bool parseQueryUint(const CoapOption &option, const char *key, unsigned long &value);
+void writeVibration(BufferWriter &writer, const void *context);
+size_t readAxisStatistics(const CarrierManager::LSM6DS3_WindowStatistics &statistics, float *values);
+void writeOrientation(BufferWriter &writer, const void *context);
+void writeTaskStatistics(BufferWriter &writer, const void *context);
+void writeMemory(BufferWriter &writer, const void *context);
+#ifdef PROFILE_ENABLED
+void writeTiming(BufferWriter &writer, const void *context);
+bool parseTimingQuery(CoapPacket &packet, int &phase);
+#endif
+
+void handleEvents(EventResource resource, CoapPacket &packet, IPAddress ip, int port);
+bool sendEvents(const EventPack &pack, uint8_t type, uint16_t messageId,
+    const uint8_t *token, uint8_t tokenLength, bool observe, CoapBlock block, IPAddress ip, int port);
+Freshness eventFreshness(const EventLog &log, SenMLFormat format);
+void writeEvents(BufferWriter &writer, const void *context);
+
+void notifyObservers();
+void logInputEvent(const InputEvent &event);
+void sendNotification(CoapObservers::Observer &observer, bool retransmission);
+void retransmitNotifications();
+bool exceedsDeadband(ObservableResource &resource, const int32_t *values, size_t count);
+size_t readChannels(int channel, size_t count, int32_t *values);
+
+
+const SenMLRecord SENML_TEMP_RECORDS[] = {
+    { SENML_N_TEMPERATURE, SENML_U_TEMPERATURE, SENML_D_TEMPERATURE }
+};
+const SenMLRecord SENML_HMDT_RECORDS[] = {
+    { SENML_N_HUMIDITY, SENML_U_HUMIDITY, SENML_D_HUMIDITY }
+};
+const SenMLRecord SENML_PRSS_RECORDS[] = {
+    { SENML_N_PRESSURE, SENML_U_PRESSURE, SENML_D_PRESSURE }
+};
+const SenMLRecord SENML_ACCL_RECORDS[] = {
+    { SENML_N_ACCELEROMETER_X, NULL, SENML_D_ACCELEROMETER },
+    { SENML_N_ACCELEROMETER_Y, NULL, SENML_D_ACCELEROMETER },
+    { SENML_N_ACCELEROMETER_Z, NULL, SENML_D_ACCELEROMETER }
+};
+const SenMLRecord SENML_GYRO_RECORDS[] = {
+    { SENML_N_GYROSCOPE_X, NULL, SENML_D_GYROSCOPE },
+    { SENML_N_GYROSCOPE_Y, NULL, SENML_D_GYROSCOPE },
+    { SENML_N_GYROSCOPE_Z, NULL, SENML_D_GYROSCOPE }
+};
+
+#define SENML_STATISTICS_RECORDS(name, decimals) \
+    { name SENML_N_STATISTICS_MEAN, NULL, decimals }, \
+    { name SENML_N_STATISTICS_MIN, NULL, decimals }, \
+    { name SENML_N_STATISTICS_MAX, NULL, decimals }, \
+    { name SENML_N_STATISTICS_RMS, NULL, decimals }
+
+// Same axis order as readAxisStatistics(), accelerometer first
+const SenMLRecord SENML_VIBR_RECORDS[] = {
+    SENML_STATISTICS_RECORDS(SENML_N_ACCELEROMETER_X, SENML_D_ACCELEROMETER),
+    SENML_STATISTICS_RECORDS(SENML_N_ACCELEROMETER_Y, SENML_D_ACCELEROMETER),
+    SENML_STATISTICS_RECORDS(SENML_N_ACCELEROMETER_Z, SENML_D_ACCELEROMETER),
+    SENML_STATISTICS_RECORDS(SENML_N_GYROSCOPE_X, SENML_D_GYROSCOPE),
+    SENML_STATISTICS_RECORDS(SENML_N_GYROSCOPE_Y, SENML_D_GYROSCOPE),
+    SENML_STATISTICS_RECORDS(SENML_N_GYROSCOPE_Z, SENML_D_GYROSCOPE)
+};
+const SenMLRecord SENML_ORNT_RECORDS[] = {
+    { SENML_N_ORIENTATION_QW, NULL, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_QX, NULL, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_QY, NULL, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_QZ, NULL, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_ROLL, SENML_U_ORIENTATION_ANGLE, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_PITCH, SENML_U_ORIENTATION_ANGLE, SENML_D_ORIENTATION },
+    { SENML_N_ORIENTATION_YAW, SENML_U_ORIENTATION_ANGLE, SENML_D_ORIENTATION }
+};
+const SenMLRecord SENML_VIBR_SAMPLES_RECORD = { SENML_N_STATISTICS_SAMPLES, NULL, 0 };
+const SenMLRecord SENML_GEST_RECORD = { SENML_N_GESTURE, NULL, 0 };
+const SenMLRecord SENML_MOTN_RECORD = { SENML_N_MOTION, NULL, 0 };
+const SenMLRecord SENML_EVENTS_DROPPED_RECORD = { SENML_N_EVENTS_DROPPED, NULL, 0 };
+
+// Encoders run once per sensor refresh, dispatch() serves the cached bytes
+#define SENSOR_ENCODER(id, path, title, rt, iface, ct, group, channel, enabled, records, deadband) \
+    size_t encode_##id(CarrierManager& carrier, SenMLFormat format, char* buffer, size_t size) { \
+        int32_t values[sizeof(records) / sizeof(records[0])]; \
+        readChannels(channel, sizeof(records) / sizeof(records[0]), values); \
+        return senmlWrite(format, buffer, size, SENML_BN, carrier.getSensorUpdateMs(group), SENML_BVER, records, values, \
+            SENSOR_SNAPSHOT_DECIMALS); \
+    }
+#define SENSOR_CACHE(id, ...) SenMLCache cache_##id(encode_##id);
+#define SENSOR_OBSERVABLE(id, path, title, rt, iface, ct, group, channel, enabled, records, deadband) \
+    { path, records, &cache_##id, COAP_CONTENT_TYPE(ct), group, channel, sizeof(records) / sizeof(records[0]), enabled, deadband },
+
+SENSOR_RESOURCES(SENSOR_ENCODER)
+SENSOR_RESOURCES(SENSOR_CACHE)
 
+// Indexed by SensorResource
+ObservableResource resources[RESOURCE_COUNT] = {
+    SENSOR_RESOURCES(SENSOR_OBSERVABLE)
+};
 
-int wifiOldStatus;
-unsigned long wifiStatusUpdateTime;
+#define EVENT_LOG(id, path, title, rt, iface, ct, type, record) \
+    { path, &record, COAP_CONTENT_TYPE(ct), type },
 
+// Indexed by EventResource
+EventLog eventLogs[EVENT_RESOURCE_COUNT] = {
+    EVENT_RESOURCES(EVENT_LOG)
+};
 
-// void callback_wkc(CoapPacket &packet, IPAddress ip, int port);
-void callback_temp(CoapPacket &packet, IPAddress ip, int port);
-void callback_hmdt(CoapPacket &packet, IPAddress ip, int port);
-void callback_accl(CoapPacket &packet, IPAddress ip, int port);
-void callback_gyro(CoapPacket &packet, IPAddress ip, int port);
-void callback_prss(CoapPacket &packet, IPAddress ip, int port);
+#define SERVICE_JSON_TYPE(id, path, title, rt, iface, ct, handler) COAP_CONTENT_TYPE(ct),
+
+// Indexed by ServiceResource, the Content-Format of the JSON representation
+const COAP_CONTENT_TYPE serviceJsonTypes[SERVICE_RESOURCE_COUNT] = {
+    SERVICE_RESOURCES(SERVICE_JSON_TYPE)
+};
+
+// Every entry starts with a separator, the first one is skipped when serving
+const char CORE_LINK_FORMAT[] = SENSOR_RESOURCES(SENSOR_LINK) EVENT_RESOURCES(EVENT_LINK) SERVICE_RESOURCES(SERVICE_LINK);
 
 
 void setup() {
+    MemoryTelemetry::paintStack();
+
     delay(SETUP_DELAY_MS);
 
+#ifdef TASK_MEMORY_DUMP_PERIOD_MS
+    Serial.begin(SERIAL_BAUD_RATE);
+#endif
+
     carrier.enableEnvironmentSensorUpdates();
     carrier.enableAccelerometerSensorUpdates();
     carrier.enableGyroscopeSensorUpdates();
     carrier.enablePressureSensorUpdates();
+    carrier.enableOrientationUpdates();
+    carrier.enableGestureSensorUpdates();
     carrier.setSensorsUpdateTimeout(LOOP_CARRIER_UPDATE_MS);
+    carrier.setSensorPeriod(SENSOR_GROUP_ACCELEROMETER, LOOP_IMU_UPDATE_MS);
+    carrier.setSensorPeriod(SENSOR_GROUP_GYROSCOPE, LOOP_IMU_UPDATE_MS);
+    carrier.setSensorPeriod(SENSOR_GROUP_ORIENTATION, LOOP_ORIENTATION_UPDATE_MS);
     carrier.setCase(false);
+    carrier.setIMUFifo(true);
+    carrier.setPIR(true);
+    carrier.setSensorLog(true);
+    carrier.setSensorsUpdateHook(notifyObservers);
+    carrier.setInputEventHook(logInputEvent);
 
     carrier.begin();
 
     carrier.setMessage("Connecting...");
 
-    WiFi.begin(SECRET_SSID, SECRET_PASS);
+    wifi.begin(millis());
 
     udp.begin(UDP_COAP_PORT);
     
-    // coap.server(callback_wkc, COAP_DISCOVERY_RESOURCE_NAME); // Does not work, message gets too long
-    coap.server(callback_temp, COAP_TEMP_RESOURCE_NAME);
-    coap.server(callback_hmdt, COAP_HMDT_RESOURCE_NAME);
-    coap.server(callback_prss, COAP_PRSS_RESOURCE_NAME);
-    coap.server(callback_accl, COAP_ACCL_RESOURCE_NAME);
-    coap.server(callback_gyro, COAP_GYRO_RESOURCE_NAME);
-
-    coap.start();
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        carrier.setMessage(WiFi.localIP().toString());
+    server.setDispatcher(dispatch);
+    server.setResetHandler(handleReset);
+    server.setAckHandler(handleAck);
+
+    tasks.add("coap", task_coap, TASK_COAP_PERIOD_MS, TASK_COAP_PRIORITY);
+    tasks.add("wifi", task_wifi, TASK_WIFI_PERIOD_MS, TASK_WIFI_PRIORITY);
+    tasks.add("sensors", task_sensors, TASK_SENSORS_PERIOD_MS, TASK_SENSORS_PRIORITY);
+    tasks.add("inputs", task_inputs, TASK_INPUTS_PERIOD_MS, TASK_INPUTS_PRIORITY);
+    tasks.add("gfx", task_gfx, TASK_GFX_PERIOD_MS, TASK_GFX_PRIORITY);
+    tasks.add("log", task_log, TASK_LOG_PERIOD_MS, TASK_LOG_PRIORITY);
+#ifdef TASK_MEMORY_DUMP_PERIOD_MS
+    tasks.add("memory", task_memory_dump, TASK_MEMORY_DUMP_PERIOD_MS, TASK_MEMORY_DUMP_PRIORITY);
+#endif
+    tasks.start(millis());
+}
+
+void loop() {
+    if (!tasks.run(millis())) {
+        tasks.idle();
     }
+}
 
-    wifiStatusUpdateTime = millis();
+
+void task_coap() {
+    PROFILE_SCOPE(PROFILE_PHASE_COAP);
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_COAP);
+
+    if (wifi.connected()) {
+        server.loop(TASK_COAP_MAX_PACKETS, TASK_COAP_BUDGET_US);
+        retransmitNotifications();
+    }
 }
 
-void loop() {
-    carrier.loop();
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        coap.loop();
-    } else if ((WiFi.status() == WL_DISCONNECTED || WiFi.status() == WL_CONNECTION_LOST || WiFi.status() == WL_CONNECT_FAILED) &&
-                millis() > wifiStatusUpdateTime + WIFI_RETRY_LOOP_TIMEOUT_MS) {
-        WiFi.begin(SECRET_SSID, SECRET_PASS);
-        wifiStatusUpdateTime = millis();
+void task_wifi() {
+    PROFILE_SCOPE(PROFILE_PHASE_WIFI);
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_WIFI);
+
+    if (wifi.loop(millis())) {
+        carrier.setMessage(wifi.connected() ? wifi.getLocalIP().toString() + " : " + UDP_COAP_PORT : "Connecting...");
     }
 
-    if (WiFi.status() != wifiOldStatus) {
-        wifiOldStatus = WiFi.status();
+    // Until then the log clock carries on from the last record written before the reset
+    if (wifi.connected() && !logClockSynced && millis() - logClockSyncMs >= LOG_CLOCK_SYNC_RETRY_MS) {
+        unsigned long time = WiFi.getTime();
 
-        carrier.setMessage(wifiOldStatus == WL_CONNECTED ? WiFi.localIP().toString() + " : " + UDP_COAP_PORT : "Connecting...");
+        logClockSyncMs = millis();
+        if (time != 0) {
+            carrier.setSensorLogTime(time);
+            logClockSynced = true;
+        }
     }
 }
 
+void task_sensors() {
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_SENSORS);
 
-/*
-void callback_wkc(CoapPacket &packet, IPAddress ip, int port) {
-    String temperatureLinkFormat = "</" + String(COAP_TEMP_RESOURCE_NAME) + 
-        ">;ct=\"" + CORE_TEMP_CT + 
-        "\";if=\"" + CORE_TEMP_IF + 
-        "\";rt=\"" + CORE_TEMP_RT +
-        "\";title=\"" + CORE_TEMP_TITLE + "\"";
-    
-    String humidityLinkFormat = "</" + String(COAP_HMDT_RESOURCE_NAME) + 
-        ">;ct=\"" + CORE_HMDT_CT + 
-        "\";if=\"" + CORE_HMDT_IF + 
-        "\";rt=\"" + CORE_HMDT_RT +
-        "\";title=\"" + CORE_HMDT_TITLE + "\"";
+    carrier.sensorsLoop();
+}
 
-    String message = temperatureLinkFormat + "," + humidityLinkFormat;
+void task_inputs() {
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_SENSORS);
 
-    coap.sendResponse(ip, port, packet.messageid,
-        message.c_str(), message.length(),
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_DISCOVERY_CT),
-        packet.token, packet.tokenlen);
+    carrier.inputsLoop();
 }
-*/
 
-void callback_temp(CoapPacket &packet, IPAddress ip, int port) {
-    JsonDocument doc;
-    
-    JsonObject jsonBase = doc.add<JsonObject>();
-    jsonBase["bn"] = SENML_BN;
-    jsonBase["bt"] = millis();
-    jsonBase["bver"] = SENML_BVER;
+void task_gfx() {
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_GFX);
+
+    carrier.gfxLoop();
+}
+
+void task_log() {
+    MEMORY_SCOPE(MEMORY_SUBSYSTEM_SENSORS);
+
+    carrier.logLoop();
+}
+
+void task_memory_dump() {
+    MemoryTelemetry::dump(Serial);
+}
 
-    JsonObject jsonTemp = doc.add<JsonObject>();
-    jsonTemp["n"] = SENML_N_TEMPERATURE;
-    jsonTemp["v"] = carrier.getEnvironmentSensor().temperature;
-    jsonTemp["u"] = SENML_U_TEMPERATURE;
 
-    doc.shrinkToFit();
+#define SENSOR_DISPATCH(id, path, ...) \
+    case COAP_DISPATCH_SLOT(path): \
+        if (strcmp(resourcePath, path) != 0) break; \
+        handleSensor(RESOURCE_##id, packet, ip, port); \
+        return;
+#define SERVICE_DISPATCH(id, path, title, rt, iface, ct, handler) \
+    case COAP_DISPATCH_SLOT(path): \
+        if (strcmp(resourcePath, path) != 0) break; \
+        handler(packet, ip, port); \
+        return;
+#define EVENT_DISPATCH(id, path, ...) \
+    case COAP_DISPATCH_SLOT(path): \
+        if (strcmp(resourcePath, path) != 0) break; \
+        handleEvents(EVENT_RESOURCE_##id, packet, ip, port); \
+        return;
+
+// One hash of the path and one string compare, whatever the number of resources
+void dispatch(CoapPacket &packet, const char *resourcePath, IPAddress ip, int port) {
+    if (packet.code != COAP_GET) {
+        sendEmptyResponse(packet, COAP_CODE_METHOD_NOT_ALLOWED, ip, port);
+        return;
+    }
 
-    String message;
-    serializeJson(doc, message);
+    if (!coapBlockValid(packet)) {
+        sendEmptyResponse(packet, COAP_BAD_REQUEST, ip, port);
+        return;
+    }
 
-    coap.sendResponse(ip, port, packet.messageid, 
-        message.c_str(), message.length(), 
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_TEMP_CT), 
+    switch (COAP_DISPATCH_SLOT(resourcePath)) {
+        case COAP_DISPATCH_SLOT(COAP_DISCOVERY_RESOURCE_NAME):
+            if (strcmp(resourcePath, COAP_DISCOVERY_RESOURCE_NAME) != 0) break;
+            callback_wkc(packet, ip, port);
+            return;
+        SENSOR_RESOURCES(SENSOR_DISPATCH)
+        EVENT_RESOURCES(EVENT_DISPATCH)
+        SERVICE_RESOURCES(SERVICE_DISPATCH)
+    }
+
+    sendEmptyResponse(packet, COAP_CODE_NOT_FOUND, ip, port);
+}
+
+void handleReset(IPAddress ip, int port, uint16_t messageId) {
+    observers.removeRejected(ip, port, messageId);
+}
+
+void handleAck(IPAddress ip, int port, uint16_t messageId) {
+    observers.acknowledged(ip, port, messageId, millis());
+}
+
+// Served block-wise from the link-format string built at compile time
+void callback_wkc(CoapPacket &packet, IPAddress ip, int port) {
+    bool confirmable = packet.type == COAP_CON;
+
+    CoapMessage message(confirmable ? COAP_ACK : COAP_NONCON, COAP_CONTENT,
+        confirmable ? packet.messageid : CoapMessage::nextMessageId(),
         packet.token, packet.tokenlen);
+    message.addUintOption(COAP_OPTION_CONTENT_FORMAT, CORE_DISCOVERY_CT);
+
+    CoapBytes links = { CORE_LINK_FORMAT + 1, sizeof(CORE_LINK_FORMAT) - 2 };
+
+    if (!coapWriteBlock(message, coapRequestedBlock(packet), coapWriteBytes, &links)) {
+        sendEmptyResponse(packet, COAP_BAD_OPTION, ip, port);
+        return;
+    }
 
-    //coap.sendResponse(ip, port, packet.messageid, message.c_str());
+    message.send(udp, ip, port);
 }
 
-void callback_hmdt(CoapPacket &packet, IPAddress ip, int port) {
-    JsonDocument doc;
+// One pack for every enabled sensor, optionally narrowed with Uri-Query
+// options naming the single resources, e.g. /sensors?temperature&gyroscope
+void callback_snsr(CoapPacket &packet, IPAddress ip, int port) {
+    SensorBatch batch;
 
-    JsonObject jsonBase = doc.add<JsonObject>();
-    jsonBase["bn"] = SENML_BN;
-    jsonBase["bt"] = millis();
-    jsonBase["bver"] = SENML_BVER;
+    if (!negotiateSenMLFormat(packet, batch.format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
 
-    JsonObject jsonHmdt = doc.add<JsonObject>();
-    jsonHmdt["n"] = SENML_N_HUMIDITY;
-    jsonHmdt["v"] = carrier.getEnvironmentSensor().humidity;
-    jsonHmdt["u"] = SENML_U_HUMIDITY;
+    if (!parseSensorSelection(packet, batch.selection)) {
+        sendEmptyResponse(packet, COAP_BAD_REQUEST, ip, port);
+        return;
+    }
 
-    doc.shrinkToFit();
+    unsigned int groups = 0;
+    for (int r = 0; r < RESOURCE_COUNT; r++) {
+        if (batch.selection & (1 << r)) {
+            groups |= (1 << resources[r].group);
+        }
+    }
 
-    String message;
-    serializeJson(doc, message);
+    Freshness freshness = sensorFreshness(groups, batch.format);
+    batch.time = freshness.time;
 
-    coap.sendResponse(ip, port, packet.messageid, 
-        message.c_str(), message.length(), 
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_HMDT_CT), 
-        packet.token, packet.tokenlen);
+    if (sendValidIfMatched(packet, freshness, NULL, ip, port)) {
+        return;
+    }
+
+    sendServiceResponse(SERVICE_RESOURCE_SNSR, packet, batch.format, freshness, writeSensorBatch, &batch, ip, port);
 }
 
-void callback_accl(CoapPacket &packet, IPAddress ip, int port) {
-    JsonDocument doc;
+void writeSensorBatch(BufferWriter &writer, const void *context) {
+    const SensorBatch *batch = (const SensorBatch*) context;
+
+    int32_t values[SENSOR_CHANNEL_COUNT];
+    size_t total = 0;
 
-    JsonObject jsonBase = doc.add<JsonObject>();
-    jsonBase["bn"] = SENML_BN;
-    jsonBase["bt"] = millis();
-    jsonBase["bver"] = SENML_BVER;
+    // One snapshot for every resource in the batch
+    readChannels(0, SENSOR_CHANNEL_COUNT, values);
 
-    JsonObject jsonAcclX = doc.add<JsonObject>();
-    jsonAcclX["n"] = SENML_N_GYROSCOPE_X;
-    jsonAcclX["v"] = carrier.getIMUSensor().gyroscope.x;
+    for (int r = 0; r < RESOURCE_COUNT; r++) {
+        total += (batch->selection & (1 << r)) ? resources[r].channels : 0;
+    }
 
-    JsonObject jsonAcclY = doc.add<JsonObject>();
-    jsonAcclY["n"] = SENML_N_GYROSCOPE_Y;
-    jsonAcclY["v"] = carrier.getIMUSensor().gyroscope.y;
+    SenMLPackWriter pack(writer, batch->format);
 
-    JsonObject jsonAcclZ = doc.add<JsonObject>();
-    jsonAcclZ["n"] = SENML_N_GYROSCOPE_Z;
-    jsonAcclZ["v"] = carrier.getIMUSensor().gyroscope.z;
+    pack.begin(SENML_BN, batch->time, SENML_BVER, total);
+    for (int r = 0; r < RESOURCE_COUNT; r++) {
+        for (size_t i = 0; (batch->selection & (1 << r)) && i < resources[r].channels; i++) {
+            pack.recordFixed(resources[r].records[i], values[resources[r].channel + i], SENSOR_SNAPSHOT_DECIMALS);
+        }
+    }
+    pack.end();
+}
 
-    doc.shrinkToFit();
+bool parseSensorSelection(CoapPacket &packet, unsigned int &selection) {
+    bool filtered = false;
 
-    String message;
-    serializeJson(doc, message);
+    selection = 0;
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption &option = packet.options[i];
 
-    coap.sendResponse(ip, port, packet.messageid, 
-        message.c_str(), message.length(), 
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_ACCL_CT), 
-        packet.token, packet.tokenlen);
+        if (option.number != COAP_OPTION_URI_QUERY) {
+            continue;
+        }
+
+        int r;
+        for (r = 0; r < RESOURCE_COUNT; r++) {
+            const char *name = resources[r].name;
+
+            if (strlen(name) == option.length && strncmp(name, (const char*) option.buffer, option.length) == 0) {
+                break;
+            }
+        }
+
+        if (r == RESOURCE_COUNT) {
+            return false;
+        }
+
+        selection |= (1 << r);
+        filtered = true;
+    }
+
+    if (!filtered) {
+        selection = (1 << RESOURCE_COUNT) - 1;
+    }
+
+    for (int r = 0; r < RESOURCE_COUNT; r++) {
+        if (!resources[r].enabled(carrier)) {
+            selection &= ~(1 << r);
+        }
+    }
+
+    return true;
 }
 
-void callback_gyro(CoapPacket &packet, IPAddress ip, int port) {
-    JsonDocument doc;
+// Samples kept by CarrierManager, oldest first, filtered with ?since=<bt ms>&limit=<samples>.
+// Records carry t relative to the bt of the first returned sample.
+void callback_hist(CoapPacket &packet, IPAddress ip, int port) {
+    HistoryQuery query;
 
-    JsonObject jsonBase = doc.add<JsonObject>();
-    jsonBase["bn"] = SENML_BN;
-    jsonBase["bt"] = millis();
-    jsonBase["bver"] = SENML_BVER;
+    if (!negotiateSenMLFormat(packet, query.format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
 
-    JsonObject jsonGyroX = doc.add<JsonObject>();
-    jsonGyroX["n"] = SENML_N_GYROSCOPE_X;
-    jsonGyroX["v"] = carrier.getIMUSensor().gyroscope.x;
+    if (!parseHistoryQuery(packet, query)) {
+        sendEmptyResponse(packet, COAP_BAD_REQUEST, ip, port);
+        return;
+    }
 
-    JsonObject jsonGyroY = doc.add<JsonObject>();
-    jsonGyroY["n"] = SENML_N_GYROSCOPE_Y;
-    jsonGyroY["v"] = carrier.getIMUSensor().gyroscope.y;
+    // Samples are appended on a timer of their own, not on the reads of a group
+    Freshness freshness = { (ETAG_HASH_BASIS ^ query.format) * ETAG_HASH_PRIME, SNAPSHOT_MAX_AGE, 0 };
+    freshness.etag = (freshness.etag ^ carrier.getHistory().appended()) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ (query.filtered ? query.since : 0)) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ query.limit) * ETAG_HASH_PRIME;
 
-    JsonObject jsonGyroZ = doc.add<JsonObject>();
-    jsonGyroZ["n"] = SENML_N_GYROSCOPE_Z;
-    jsonGyroZ["v"] = carrier.getIMUSensor().gyroscope.z;
+    if (sendValidIfMatched(packet, freshness, NULL, ip, port)) {
+        return;
+    }
+
+    sendServiceResponse(SERVICE_RESOURCE_HIST, packet, query.format, freshness, writeHistory, &query, ip, port);
+}
+
+void writeHistory(BufferWriter &writer, const void *context) {
+    const HistoryQuery *query = (const HistoryQuery*) context;
+    const SenMLRecord *records[SENSOR_HISTORY_CHANNELS] = {
+        &SENML_TEMP_RECORDS[0], &SENML_HMDT_RECORDS[0], &SENML_PRSS_RECORDS[0]
+    };
+
+    SensorHistory &history = carrier.getHistory();
+    SensorHistory::Cursor cursor;
+    SensorHistory::Sample sample;
+
+    // First pass finds the base time and the record count, CBOR needs it up front
+    unsigned long baseTime = 0;
+    size_t count = 0;
+
+    history.begin(cursor);
+    while (count < query->limit && history.next(cursor, sample)) {
+        if (query->filtered && (long) (sample.time - query->since) < 0) {
+            continue;
+        }
+
+        if (count++ == 0) {
+            baseTime = sample.time;
+        }
+    }
+
+    SenMLPackWriter pack(writer, query->format);
+    pack.begin(SENML_BN, baseTime, SENML_BVER, count * SENSOR_HISTORY_CHANNELS);
+
+    history.begin(cursor);
+    for (size_t written = 0; written < count && history.next(cursor, sample); ) {
+        if (query->filtered && (long) (sample.time - query->since) < 0) {
+            continue;
+        }
+
+        for (int c = 0; c < SENSOR_HISTORY_CHANNELS; c++) {
+            pack.record(*records[c], sample.values[c], (long) (sample.time - baseTime));
+        }
+        written++;
+    }
+
+    pack.end();
+}
+
+// Records logged on the SD card between two times of the log clock, e.g. /log?from=1700000000&to=1700003600.
+// The clock is the Unix time once the network provided it. Longer ranges are paged with
+// from= set past the last record received.
+void callback_slog(CoapPacket &packet, IPAddress ip, int port) {
+    LogQuery query;
 
-    doc.shrinkToFit();
+    if (!negotiateSenMLFormat(packet, query.format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    if (!parseLogQuery(packet, query)) {
+        sendEmptyResponse(packet, COAP_BAD_REQUEST, ip, port);
+        return;
+    }
+
+    const SensorLog &log = carrier.getSensorLog();
+
+    if (!log.isReady()) {
+        sendEmptyResponse(packet, COAP_CODE_SERVICE_UNAVAILABLE, ip, port);
+        return;
+    }
+
+    // Changes with every append, which is also when a range can gain or lose records
+    Freshness freshness = { (ETAG_HASH_BASIS ^ query.format) * ETAG_HASH_PRIME, SNAPSHOT_MAX_AGE, 0 };
+    freshness.etag = (freshness.etag ^ log.getPosition()) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ query.from) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ query.to) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ query.limit) * ETAG_HASH_PRIME;
+
+    if (sendValidIfMatched(packet, freshness, NULL, ip, port)) {
+        return;
+    }
+
+    sendServiceResponse(SERVICE_RESOURCE_SLOG, packet, query.format, freshness, writeLog, &query, ip, port);
+}
 
-    String message;
-    serializeJson(doc, message);
+// Channels in snapshot order, named after the sensor resources; times relative to the first record
+void writeLog(BufferWriter &writer, const void *context) {
+    const LogQuery *query = (const LogQuery*) context;
 
-    coap.sendResponse(ip, port, packet.messageid, 
-        message.c_str(), message.length(), 
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_GYRO_CT), 
+    SensorLog::Cursor cursor;
+    SensorLogRecord record;
+
+    // First pass finds the base time and the record count, CBOR needs it up front
+    uint32_t baseTime = 0;
+    size_t count = 0;
+
+    carrier.seekSensorLog(cursor, query->from);
+    while (count < query->limit && carrier.nextSensorLog(cursor, record) && record.time <= query->to) {
+        if (record.time < query->from) {
+            continue;
+        }
+
+        if (count++ == 0) {
+            baseTime = record.time;
+        }
+    }
+
+    SenMLPackWriter pack(writer, query->format);
+    pack.begin(SENML_BN, baseTime, SENML_BVER, count * SENSOR_CHANNEL_COUNT);
+
+    carrier.seekSensorLog(cursor, query->from);
+    for (size_t written = 0; written < count && carrier.nextSensorLog(cursor, record); ) {
+        if (record.time < query->from) {
+            continue;
+        }
+
+        for (int r = 0; r < RESOURCE_COUNT; r++) {
+            for (size_t i = 0; i < resources[r].channels; i++) {
+                pack.recordFixed(resources[r].records[i], record.channels[resources[r].channel + i],
+                    SENSOR_SNAPSHOT_DECIMALS, (long) (record.time - baseTime));
+            }
+        }
+        written++;
+    }
+
+    pack.end();
+}
+
+bool parseLogQuery(CoapPacket &packet, LogQuery &query) {
+    unsigned long limit = LOG_QUERY_LIMIT_DEFAULT;
+
+    query.from = 0;
+    query.to = 0xFFFFFFFF;
+
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption &option = packet.options[i];
+
+        if (option.number != COAP_OPTION_URI_QUERY) {
+            continue;
+        }
+
+        if (!parseQueryUint(option, LOG_QUERY_FROM, query.from) &&
+                !parseQueryUint(option, LOG_QUERY_TO, query.to) &&
+                !parseQueryUint(option, LOG_QUERY_LIMIT, limit)) {
+            return false;
+        }
+    }
+
+    if (limit == 0 || limit > LOG_QUERY_LIMIT_MAX || query.from > query.to) {
+        return false;
+    }
+
+    query.limit = limit;
+    return true;
+}
+
+bool parseHistoryQuery(CoapPacket &packet, HistoryQuery &query) {
+    unsigned long limit = SENSOR_HISTORY_BLOCKS * SENSOR_HISTORY_BLOCK_SAMPLES;
+
+    query.since = 0;
+    query.filtered = false;
+
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption &option = packet.options[i];
+
+        if (option.number != COAP_OPTION_URI_QUERY) {
+            continue;
+        }
+
+        if (parseQueryUint(option, HISTORY_QUERY_SINCE, query.since)) {
+            query.filtered = true;
+        } else if (!parseQueryUint(option, HISTORY_QUERY_LIMIT, limit)) {
+            return false;
+        }
+    }
+
+    query.limit = limit;
+    return true;
+}
+
+// Matches a "key=<decimal>" query option. Non-digits or a value past ULONG_MAX do not
+// match, which the query parsers answer with 4.00.
+bool parseQueryUint(const CoapOption &option, const char *key, unsigned long &value) {
+    size_t keyLength = strlen(key);
+
+    if (option.length <= keyLength || strncmp((const char*) option.buffer, key, keyLength) != 0) {
+        return false;
+    }
+
+    unsigned long parsed = 0;
+    for (size_t i = keyLength; i < option.length; i++) {
+        char c = option.buffer[i];
+
+        if (c < '0' || c > '9') {
+            return false;
+        }
+
+        unsigned long digit = c - '0';
+        if (parsed > (ULONG_MAX - digit) / 10) {
+            return false;
+        }
+        parsed = parsed * 10 + digit;
+    }
+
+    value = parsed;
+    return true;
+}
+
+// Per-axis mean, min, max and RMS over the last IMU window. With the LSM6DS3 FIFO the
+// window covers IMU_FIFO_WINDOW_MS of 104 Hz samples, otherwise the single last reading.
+void callback_vibr(CoapPacket &packet, IPAddress ip, int port) {
+    VibrationPack pack;
+
+    if (!negotiateSenMLFormat(packet, pack.format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    Freshness freshness = sensorFreshness((1 << SENSOR_GROUP_ACCELEROMETER) | (1 << SENSOR_GROUP_GYROSCOPE), pack.format);
+    pack.time = freshness.time;
+
+    if (sendValidIfMatched(packet, freshness, NULL, ip, port)) {
+        return;
+    }
+
+    sendServiceResponse(SERVICE_RESOURCE_VIBR, packet, pack.format, freshness, writeVibration, &pack, ip, port);
+}
+
+void writeVibration(BufferWriter &writer, const void *context) {
+    const VibrationPack *vibration = (const VibrationPack*) context;
+    CarrierManager::LSM6DS3_IMUSensor imu = carrier.getIMUSensor();
+
+    float values[VIBRATION_VALUES];
+    size_t count = 0;
+
+    if (imu.accelerometer.enabled) {
+        count += readAxisStatistics(imu.accelerometer.statistics, &values[count]);
+    }
+    if (imu.gyroscope.enabled) {
+        count += readAxisStatistics(imu.gyroscope.statistics, &values[count]);
+    }
+
+    // Records of a disabled accelerometer are skipped, the gyroscope ones start halfway
+    const SenMLRecord *records = imu.accelerometer.enabled ? SENML_VIBR_RECORDS : &SENML_VIBR_RECORDS[VIBRATION_VALUES / 2];
+
+    SenMLPackWriter pack(writer, vibration->format);
+
+    pack.begin(SENML_BN, vibration->time, SENML_BVER, count + 1);
+    for (size_t i = 0; i < count; i++) {
+        pack.record(records[i], values[i]);
+    }
+    pack.record(SENML_VIBR_SAMPLES_RECORD, imu.windowSamples);
+    pack.end();
+}
+
+size_t readAxisStatistics(const CarrierManager::LSM6DS3_WindowStatistics &statistics, float *values) {
+    const CarrierManager::LSM6DS3_AxisStatistics *axes[3] = { &statistics.x, &statistics.y, &statistics.z };
+
+    for (int a = 0; a < 3; a++) {
+        values[a * VIBRATION_STATISTICS + 0] = axes[a]->mean;
+        values[a * VIBRATION_STATISTICS + 1] = axes[a]->min;
+        values[a * VIBRATION_STATISTICS + 2] = axes[a]->max;
+        values[a * VIBRATION_STATISTICS + 3] = axes[a]->rms;
+    }
+
+    return 3 * VIBRATION_STATISTICS;
+}
+
+// Quaternion and Euler angles from the fixed-point Mahony filter. The filter moves at
+// LOOP_ORIENTATION_UPDATE_MS, so block 0 takes a snapshot and the later blocks serve it.
+void callback_ornt(CoapPacket &packet, IPAddress ip, int port) {
+    OrientationPack &pack = orientationSnapshot;
+    CoapBlock block = coapRequestedBlock(packet);
+    SenMLFormat format;
+
+    if (!negotiateSenMLFormat(packet, format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    if (block.num == 0) {
+        takeSnapshot(pack.owner, ip, port);
+        pack.format = format;
+        pack.state = carrier.getOrientation();
+        pack.time = millis();
+    } else if (!ownsSnapshot(pack.owner, ip, port) || format != pack.format) {
+        sendEmptyResponse(packet, COAP_CODE_REQUEST_ENTITY_INCOMPLETE, ip, port);
+        return;
+    }
+
+    Freshness freshness = snapshotFreshness(pack.owner, pack.format);
+
+    sendServiceResponse(SERVICE_RESOURCE_ORNT, packet, pack.format, freshness, writeOrientation, &pack, ip, port);
+}
+
+void writeOrientation(BufferWriter &writer, const void *context) {
+    const OrientationPack *orientation = (const OrientationPack*) context;
+    const CarrierManager::LSM6DS3_Orientation &state = orientation->state;
+
+    const float values[] = { state.qw, state.qx, state.qy, state.qz, state.roll, state.pitch, state.yaw };
+    size_t count = state.enabled ? sizeof(values) / sizeof(values[0]) : 0;
+
+    SenMLPackWriter pack(writer, orientation->format);
+
+    pack.begin(SENML_BN, orientation->time, SENML_BVER, count);
+    for (size_t i = 0; i < count; i++) {
+        pack.record(SENML_ORNT_RECORDS[i], values[i]);
+    }
+    pack.end();
+}
+
+// Run counts, skipped activations and the longest run of every scheduler task, snapshotted
+// by block 0 like /orientation
+void callback_task(CoapPacket &packet, IPAddress ip, int port) {
+    TaskStatisticsPack &pack = taskSnapshot;
+    CoapBlock block = coapRequestedBlock(packet);
+    SenMLFormat format;
+
+    if (!negotiateSenMLFormat(packet, format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    if (block.num == 0) {
+        takeSnapshot(pack.owner, ip, port);
+        pack.format = format;
+        pack.time = millis();
+        pack.count = tasks.count();
+
+        for (size_t i = 0; i < pack.count; i++) {
+            const TaskScheduler::Task &task = tasks.get(i);
+
+            pack.runs[i] = task.runs;
+            pack.overruns[i] = task.overruns;
+            pack.maxRunUs[i] = task.maxRunUs;
+        }
+    } else if (!ownsSnapshot(pack.owner, ip, port) || format != pack.format) {
+        sendEmptyResponse(packet, COAP_CODE_REQUEST_ENTITY_INCOMPLETE, ip, port);
+        return;
+    }
+
+    Freshness freshness = snapshotFreshness(pack.owner, pack.format);
+
+    sendServiceResponse(SERVICE_RESOURCE_TASK, packet, pack.format, freshness, writeTaskStatistics, &pack, ip, port);
+}
+
+void writeTaskStatistics(BufferWriter &writer, const void *context) {
+    const TaskStatisticsPack *statistics = (const TaskStatisticsPack*) context;
+
+    SenMLPackWriter pack(writer, statistics->format);
+    pack.begin(SENML_BN, statistics->time, SENML_BVER, statistics->count * 3);
+
+    for (size_t i = 0; i < statistics->count; i++) {
+        const TaskScheduler::Task &task = tasks.get(i);
+
+        char name[SENML_NAME_MAX];
+        SenMLRecord runs = { name, NULL, 0 };
+        SenMLRecord overruns = { name, NULL, 0 };
+        SenMLRecord maxRun = { name, SENML_U_TASK_MAX_RUN, SENML_D_TASK_MAX_RUN };
+
+        snprintf(name, sizeof(name), SENML_N_TASK_PREFIX "%s" SENML_N_TASK_RUNS, task.name);
+        pack.record(runs, statistics->runs[i]);
+        snprintf(name, sizeof(name), SENML_N_TASK_PREFIX "%s" SENML_N_TASK_OVERRUNS, task.name);
+        pack.record(overruns, statistics->overruns[i]);
+        snprintf(name, sizeof(name), SENML_N_TASK_PREFIX "%s" SENML_N_TASK_MAX_RUN, task.name);
+        pack.record(maxRun, statistics->maxRunUs[i] / 1000000.0);
+    }
+
+    pack.end();
+}
+
+// Heap, free list, stack high-water mark and per-subsystem allocation counts, in bytes
+void callback_memr(CoapPacket &packet, IPAddress ip, int port) {
+    MemoryPack &pack = memorySnapshot;
+    CoapBlock block = coapRequestedBlock(packet);
+    SenMLFormat format;
+
+    if (!negotiateSenMLFormat(packet, format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    if (block.num == 0) {
+        takeSnapshot(pack.owner, ip, port);
+        pack.format = format;
+        pack.time = millis();
+        MemoryTelemetry::read(pack.snapshot);
+        pack.encodeFailures = SenMLCache::getFailures();
+    } else if (!ownsSnapshot(pack.owner, ip, port) || format != pack.format) {
+        sendEmptyResponse(packet, COAP_CODE_REQUEST_ENTITY_INCOMPLETE, ip, port);
+        return;
+    }
+
+    Freshness freshness = snapshotFreshness(pack.owner, pack.format);
+
+    sendServiceResponse(SERVICE_RESOURCE_MEMR, packet, pack.format, freshness, writeMemory, &pack, ip, port);
+}
+
+void writeMemory(BufferWriter &writer, const void *context) {
+    const MemoryPack *memory = (const MemoryPack*) context;
+    const MemoryTelemetry::Snapshot &snapshot = memory->snapshot;
+
+    const SenMLRecord bytes[] = {
+        { SENML_N_MEMORY_HEAP_USED, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_HEAP_PEAK, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_HEAP_FREE, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_HEAP_LARGEST, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_HEAP_ARENA, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_GAP, SENML_U_MEMORY, 0 },
+        { SENML_N_MEMORY_STACK_USED, SENML_U_MEMORY, 0 }
+    };
+    const uint32_t values[] = {
+        snapshot.heapUsed, snapshot.heapPeak, snapshot.heapFree, snapshot.heapLargestFree,
+        snapshot.heapArena, snapshot.gap, snapshot.stackUsed
+    };
+    const SenMLRecord frees = { SENML_N_MEMORY_FREES, NULL, 0 };
+    const SenMLRecord failures = { SENML_N_MEMORY_FAILURES, NULL, 0 };
+    const SenMLRecord encodeFailures = { SENML_N_MEMORY_ENCODE_FAILURES, NULL, 0 };
+
+    SenMLPackWriter pack(writer, memory->format);
+    pack.begin(SENML_BN, memory->time, SENML_BVER, sizeof(values) / sizeof(values[0]) + MEMORY_SUBSYSTEM_COUNT + 3);
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        pack.record(bytes[i], values[i]);
+    }
+
+    for (int subsystem = 0; subsystem < MEMORY_SUBSYSTEM_COUNT; subsystem++) {
+        char name[SENML_NAME_MAX];
+        SenMLRecord allocations = { name, NULL, 0 };
+
+        snprintf(name, sizeof(name), SENML_N_MEMORY_ALLOCATIONS_PREFIX "%s", MemoryTelemetry::SUBSYSTEM_NAMES[subsystem]);
+        pack.record(allocations, snapshot.allocations[subsystem]);
+    }
+
+    pack.record(frees, snapshot.frees);
+    pack.record(failures, snapshot.failures);
+    pack.record(encodeFailures, memory->encodeFailures);
+    pack.end();
+}
+
+#ifdef PROFILE_ENABLED
+// Count, min, max and p99 of every profiled phase, or with ?phase=<name> the non-empty
+// log2 buckets of that phase as well. Times in seconds, snapshotted by block 0.
+void callback_time(CoapPacket &packet, IPAddress ip, int port) {
+    TimingPack &pack = timingSnapshot;
+    CoapBlock block = coapRequestedBlock(packet);
+    SenMLFormat format;
+    int phase;
+
+    if (!negotiateSenMLFormat(packet, format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    if (!parseTimingQuery(packet, phase)) {
+        sendEmptyResponse(packet, COAP_BAD_REQUEST, ip, port);
+        return;
+    }
+
+    if (block.num == 0) {
+        takeSnapshot(pack.owner, ip, port);
+        pack.format = format;
+        pack.time = millis();
+        pack.phase = phase;
+
+        for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+            const Profiler::Histogram &histogram = profiler.getHistogram(p);
+
+            pack.count[p] = histogram.count;
+            pack.min[p] = histogram.count > 0 ? histogram.min : 0;
+            pack.max[p] = histogram.max;
+            pack.p99[p] = Profiler::percentile(histogram, TIMING_PERCENTILE);
+        }
+
+        if (phase >= 0) {
+            pack.histogram = profiler.getHistogram(phase);
+        }
+    } else if (!ownsSnapshot(pack.owner, ip, port) || format != pack.format || phase != pack.phase) {
+        sendEmptyResponse(packet, COAP_CODE_REQUEST_ENTITY_INCOMPLETE, ip, port);
+        return;
+    }
+
+    Freshness freshness = snapshotFreshness(pack.owner, pack.format);
+
+    sendServiceResponse(SERVICE_RESOURCE_TIME, packet, pack.format, freshness, writeTiming, &pack, ip, port);
+}
+
+void writeTiming(BufferWriter &writer, const void *context) {
+    const TimingPack *timing = (const TimingPack*) context;
+
+    int first = (timing->phase < 0 ? 0 : timing->phase);
+    int last = (timing->phase < 0 ? PROFILE_PHASE_COUNT - 1 : timing->phase);
+
+    size_t buckets = 0;
+    if (timing->phase >= 0) {
+        for (int b = 0; b < PROFILER_BUCKETS; b++) {
+            buckets += (timing->histogram.buckets[b] != 0);
+        }
+    }
+
+    SenMLPackWriter pack(writer, timing->format);
+    pack.begin(SENML_BN, timing->time, SENML_BVER, (last - first + 1) * 4 + buckets);
+
+    for (int p = first; p <= last; p++) {
+        const char *phase = Profiler::PHASE_NAMES[p];
+
+        char name[SENML_NAME_MAX];
+        SenMLRecord count = { name, NULL, 0 };
+        SenMLRecord time = { name, SENML_U_TIMING, SENML_D_TIMING };
+
+        snprintf(name, sizeof(name), SENML_N_TIMING_PREFIX "%s" SENML_N_TIMING_COUNT, phase);
+        pack.record(count, timing->count[p]);
+        snprintf(name, sizeof(name), SENML_N_TIMING_PREFIX "%s" SENML_N_TIMING_MIN, phase);
+        pack.record(time, timing->min[p] / (PROFILER_CYCLES_PER_US * 1000000.0));
+        snprintf(name, sizeof(name), SENML_N_TIMING_PREFIX "%s" SENML_N_TIMING_MAX, phase);
+        pack.record(time, timing->max[p] / (PROFILER_CYCLES_PER_US * 1000000.0));
+        snprintf(name, sizeof(name), SENML_N_TIMING_PREFIX "%s" SENML_N_TIMING_P99, phase);
+        pack.record(time, timing->p99[p] / (PROFILER_CYCLES_PER_US * 1000000.0));
+    }
+
+    // Bucket b counts the durations of [2^(b-1), 2^b) cycles
+    for (int b = 0; timing->phase >= 0 && b < PROFILER_BUCKETS; b++) {
+        if (timing->histogram.buckets[b] == 0) {
+            continue;
+        }
+
+        char name[SENML_NAME_MAX];
+        SenMLRecord bucket = { name, NULL, 0 };
+
+        snprintf(name, sizeof(name), SENML_N_TIMING_PREFIX "%s" SENML_N_TIMING_BUCKET "%d", Profiler::PHASE_NAMES[timing->phase], b);
+        pack.record(bucket, timing->histogram.buckets[b]);
+    }
+
+    pack.end();
+}
+
+bool parseTimingQuery(CoapPacket &packet, int &phase) {
+    size_t keyLength = strlen(TIMING_QUERY_PHASE);
+
+    phase = -1;
+    for (int i = 0; i < packet.optionnum; i++) {
+        const CoapOption &option = packet.options[i];
+
+        if (option.number != COAP_OPTION_URI_QUERY) {
+            continue;
+        }
+
+        if (option.length <= keyLength || strncmp((const char*) option.buffer, TIMING_QUERY_PHASE, keyLength) != 0) {
+            return false;
+        }
+
+        for (phase = PROFILE_PHASE_COUNT - 1; phase >= 0; phase--) {
+            const char *name = Profiler::PHASE_NAMES[phase];
+
+            if (strlen(name) == option.length - keyLength &&
+                    strncmp(name, (const char*) option.buffer + keyLength, option.length - keyLength) == 0) {
+                break;
+            }
+        }
+
+        if (phase < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+
+// Serves the cached pack in the format requested by the Accept option, JSON by default,
+// and handles Observe registration (RFC 7641 §3.1)
+void handleSensor(SensorResource resource, CoapPacket &packet, IPAddress ip, int port) {
+    SenMLFormat format;
+
+    if (!negotiateSenMLFormat(packet, format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    ObservableResource &observable = resources[resource];
+    const CoapOption* observe = coapFindOption(packet, COAP_OPTION_OBSERVE);
+    bool observing = false;
+
+    if (observe != NULL && coapOptionUint(*observe) == COAP_OBSERVE_REGISTER) {
+        if (!observers.observed(resource)) {
+            readChannels(observable.channel, observable.channels, observable.notified);
+        }
+
+        observing = observers.add(resource, ip, port, packet.token, packet.tokenlen, format, millis());
+    } else if (observe != NULL) {
+        observers.remove(resource, ip, port);
+    }
+
+    Freshness freshness = sensorFreshness(1 << observable.group, format);
+
+    if (sendValidIfMatched(packet, freshness, observing ? &observable.sequence : NULL, ip, port)) {
+        return;
+    }
+
+    bool confirmable = packet.type == COAP_CON;
+
+    if (!sendSenML(observable, format,
+            confirmable ? COAP_ACK : COAP_NONCON, confirmable ? packet.messageid : CoapMessage::nextMessageId(),
+            packet.token, packet.tokenlen, observing, coapRequestedBlock(packet), ip, port)) {
+        sendEmptyResponse(packet, COAP_BAD_OPTION, ip, port);
+    }
+}
+
+// Packs larger than one block go out block-wise (RFC 7959), notifications carry the first block.
+// A pack that could not be encoded is answered with 5.00.
+bool sendSenML(ObservableResource &resource, SenMLFormat format, uint8_t type, uint16_t messageId,
+        const uint8_t *token, uint8_t tokenLength, bool observe, CoapBlock block, IPAddress ip, int port) {
+    CoapBytes payload;
+    payload.data = resource.cache->get(carrier, carrier.getSensorGeneration(resource.group), format, payload.length);
+
+    if (payload.data == NULL) {
+        CoapMessage message(type, COAP_INTERNAL_SERVER_ERROR, messageId, token, tokenLength);
+        return message.send(udp, ip, port);
+    }
+
+    Freshness freshness = sensorFreshness(1 << resource.group, format);
+
+    CoapMessage message(type, COAP_CONTENT, messageId, token, tokenLength);
+
+    message.addETagOption(freshness.etag);
+    if (observe) {
+        message.addUintOption(COAP_OPTION_OBSERVE, resource.sequence);
+    }
+    message.addUintOption(COAP_OPTION_CONTENT_FORMAT,
+        format == SENML_FORMAT_CBOR ? COAP_CONTENT_FORMAT_SENML_CBOR : resource.jsonType);
+    message.addUintOption(COAP_OPTION_MAX_AGE, freshness.maxAge);
+
+    if (!coapWriteBlock(message, block, coapWriteBytes, &payload)) {
+        return false;
+    }
+
+    return message.send(udp, ip, port);
+}
+
+// Same Observe handling as the sensors, without a deadband: every event is a notification
+void handleEvents(EventResource resource, CoapPacket &packet, IPAddress ip, int port) {
+    EventPack pack = { SENML_FORMAT_JSON, &eventLogs[resource] };
+
+    if (!negotiateSenMLFormat(packet, pack.format)) {
+        sendEmptyResponse(packet, COAP_NOT_ACCEPTABLE, ip, port);
+        return;
+    }
+
+    const CoapOption* observe = coapFindOption(packet, COAP_OPTION_OBSERVE);
+    bool observing = false;
+
+    if (observe != NULL && coapOptionUint(*observe) == COAP_OBSERVE_REGISTER) {
+        observing = observers.add(EVENT_OBSERVER(resource), ip, port, packet.token, packet.tokenlen, pack.format, millis());
+    } else if (observe != NULL) {
+        observers.remove(EVENT_OBSERVER(resource), ip, port);
+    }
+
+    Freshness freshness = eventFreshness(*pack.log, pack.format);
+
+    if (sendValidIfMatched(packet, freshness, observing ? &eventLogs[resource].sequence : NULL, ip, port)) {
+        return;
+    }
+
+    bool confirmable = packet.type == COAP_CON;
+
+    if (!sendEvents(pack,
+            confirmable ? COAP_ACK : COAP_NONCON, confirmable ? packet.messageid : CoapMessage::nextMessageId(),
+            packet.token, packet.tokenlen, observing, coapRequestedBlock(packet), ip, port)) {
+        sendEmptyResponse(packet, COAP_BAD_OPTION, ip, port);
+    }
+}
+
+bool sendEvents(const EventPack &pack, uint8_t type, uint16_t messageId,
+        const uint8_t *token, uint8_t tokenLength, bool observe, CoapBlock block, IPAddress ip, int port) {
+    Freshness freshness = eventFreshness(*pack.log, pack.format);
+
+    CoapMessage message(type, COAP_CONTENT, messageId, token, tokenLength);
+
+    message.addETagOption(freshness.etag);
+    if (observe) {
+        message.addUintOption(COAP_OPTION_OBSERVE, pack.log->sequence);
+    }
+    message.addUintOption(COAP_OPTION_CONTENT_FORMAT,
+        pack.format == SENML_FORMAT_CBOR ? COAP_CONTENT_FORMAT_SENML_CBOR : pack.log->jsonType);
+    message.addUintOption(COAP_OPTION_MAX_AGE, freshness.maxAge);
+
+    if (!coapWriteBlock(message, block, writeEvents, &pack)) {
+        return false;
+    }
+
+    return message.send(udp, ip, port);
+}
+
+// A log only grows, so its count and the dropped interrupt events tell its representations apart.
+// The next event may come at any time, hence no Max-Age.
+Freshness eventFreshness(const EventLog &log, SenMLFormat format) {
+    Freshness freshness = { (ETAG_HASH_BASIS ^ format) * ETAG_HASH_PRIME, SNAPSHOT_MAX_AGE, 0 };
+
+    freshness.etag = (freshness.etag ^ log.count) * ETAG_HASH_PRIME;
+    freshness.etag = (freshness.etag ^ carrier.getDroppedInputEvents()) * ETAG_HASH_PRIME;
+
+    if (log.count > 0) {
+        freshness.time = log.events[(log.count - 1) % EVENT_LOG_SIZE].time;
+    }
+
+    return freshness;
+}
+
+// Oldest first, timed relative to the newest event; the dropped count covers every interrupt event
+void writeEvents(BufferWriter &writer, const void *context) {
+    const EventPack *events = (const EventPack*) context;
+    const EventLog &log = *events->log;
+
+    size_t count = log.count < EVENT_LOG_SIZE ? log.count : EVENT_LOG_SIZE;
+    unsigned long baseTime = count > 0 ? log.events[(log.count - 1) % EVENT_LOG_SIZE].time : millis();
+
+    SenMLPackWriter pack(writer, events->format);
+
+    pack.begin(SENML_BN, baseTime, SENML_BVER, count + 1);
+    for (unsigned long i = log.count - count; i != log.count; i++) {
+        const InputEvent &event = log.events[i % EVENT_LOG_SIZE];
+        pack.record(*log.record, event.value, (long) (event.time - baseTime));
+    }
+    pack.record(SENML_EVENTS_DROPPED_RECORD, carrier.getDroppedInputEvents());
+    pack.end();
+}
+
+void sendEmptyResponse(CoapPacket &packet, uint8_t code, IPAddress ip, int port) {
+    bool confirmable = packet.type == COAP_CON;
+
+    CoapMessage message(confirmable ? COAP_ACK : COAP_NONCON, code,
+        confirmable ? packet.messageid : CoapMessage::nextMessageId(),
         packet.token, packet.tokenlen);
+
+    message.send(udp, ip, port);
+}
+
+// The block asked for of a service resource's representation, written by its generator.
+// JSON goes out with the Content-Format of the resource's table row.
+void sendServiceResponse(ServiceResource resource, CoapPacket &packet, SenMLFormat format, const Freshness &freshness,
+        CoapBlockGenerator generator, const void *context, IPAddress ip, int port) {
+    bool confirmable = packet.type == COAP_CON;
+
+    CoapMessage message(confirmable ? COAP_ACK : COAP_NONCON, COAP_CONTENT,
+        confirmable ? packet.messageid : CoapMessage::nextMessageId(),
+        packet.token, packet.tokenlen);
+    message.addETagOption(freshness.etag);
+    message.addUintOption(COAP_OPTION_CONTENT_FORMAT,
+        format == SENML_FORMAT_CBOR ? COAP_CONTENT_FORMAT_SENML_CBOR : serviceJsonTypes[resource]);
+    message.addUintOption(COAP_OPTION_MAX_AGE, freshness.maxAge);
+
+    if (!coapWriteBlock(message, coapRequestedBlock(packet), generator, context)) {
+        sendEmptyResponse(packet, COAP_BAD_OPTION, ip, port);
+        return;
+    }
+
+    message.send(udp, ip, port);
 }
 
-void callback_prss(CoapPacket &packet, IPAddress ip, int port) {
-    JsonDocument doc;
+// The ETag hashes the generation and the update time of every group the representation
+// reads, so it changes with any of them and a tag from before a reset is unlikely to match.
+// Max-Age runs until the first of those groups is read again.
+Freshness sensorFreshness(unsigned int groups, SenMLFormat format) {
+    Freshness freshness = { (ETAG_HASH_BASIS ^ format) * ETAG_HASH_PRIME, 0, 0 };
+    bool first = true;
+
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        if (!(groups & (1 << group))) {
+            continue;
+        }
+
+        unsigned long time = carrier.getSensorUpdateMs(group);
+        unsigned long maxAge = carrier.getSensorTimeUntilUpdate(group) / 1000;
+
+        freshness.etag = (freshness.etag ^ carrier.getSensorGeneration(group)) * ETAG_HASH_PRIME;
+        freshness.etag = (freshness.etag ^ time) * ETAG_HASH_PRIME;
+
+        if (first || maxAge < freshness.maxAge) {
+            freshness.maxAge = maxAge;
+        }
+        if (first || (long) (time - freshness.time) > 0) {
+            freshness.time = time;
+        }
+        first = false;
+    }
+
+    return freshness;
+}
 
-    JsonObject jsonBase = doc.add<JsonObject>();
-    jsonBase["bn"] = SENML_BN;
-    jsonBase["bt"] = millis();
-    jsonBase["bver"] = SENML_BVER;
+// Block 0 of a snapshot resource takes a new snapshot for the endpoint asking for it
+void takeSnapshot(SnapshotOwner &owner, IPAddress ip, int port) {
+    owner.generation++;
+    owner.ip = ip;
+    owner.port = port;
+}
 
-    JsonObject jsonPrss = doc.add<JsonObject>();
-    jsonPrss["n"] = SENML_N_PRESSURE;
-    jsonPrss["v"] = carrier.getEnvironmentSensor().humidity;
-    jsonPrss["u"] = SENML_U_PRESSURE;
+// A later block is served from the snapshot only to the endpoint that took it. Anyone else
+// lost theirs to a newer block 0 and gets 4.08 to start over (RFC 7959 §2.9.2).
+bool ownsSnapshot(const SnapshotOwner &owner, IPAddress ip, int port) {
+    return owner.generation != 0 && owner.ip == ip && owner.port == port;
+}
 
-    doc.shrinkToFit();
+// A new tag for every snapshot, so a client reassembling blocks can tell two snapshots apart
+Freshness snapshotFreshness(const SnapshotOwner &owner, SenMLFormat format) {
+    Freshness freshness = { (ETAG_HASH_BASIS ^ format) * ETAG_HASH_PRIME, SNAPSHOT_MAX_AGE, 0 };
 
-    String message;
-    serializeJson(doc, message);
+    freshness.etag = (freshness.etag ^ owner.generation) * ETAG_HASH_PRIME;
 
-    coap.sendResponse(ip, port, packet.messageid, 
-        message.c_str(), message.length(), 
-        COAP_RESPONSE_CODE(COAP_CONTENT), COAP_CONTENT_TYPE(CORE_PRSS_CT), 
+    return freshness;
+}
+
+// 2.03 Valid without payload when the client already holds the current representation,
+// observers keep their registration and get the sequence number (RFC 7641 §3.2)
+bool sendValidIfMatched(CoapPacket &packet, const Freshness &freshness, const uint32_t *sequence, IPAddress ip, int port) {
+    if (!coapETagMatches(packet, freshness.etag)) {
+        return false;
+    }
+
+    bool confirmable = packet.type == COAP_CON;
+
+    CoapMessage message(confirmable ? COAP_ACK : COAP_NONCON, COAP_VALID,
+        confirmable ? packet.messageid : CoapMessage::nextMessageId(),
         packet.token, packet.tokenlen);
+
+    message.addETagOption(freshness.etag);
+    if (sequence != NULL) {
+        message.addUintOption(COAP_OPTION_OBSERVE, *sequence);
+    }
+    message.addUintOption(COAP_OPTION_MAX_AGE, freshness.maxAge);
+
+    message.send(udp, ip, port);
+    return true;
+}
+
+bool negotiateSenMLFormat(CoapPacket &packet, SenMLFormat &format) {
+    const CoapOption* accept = coapFindOption(packet, COAP_OPTION_ACCEPT);
+
+    format = SENML_FORMAT_JSON;
+    if (accept == NULL) {
+        return true;
+    }
+
+    switch (coapOptionUint(*accept)) {
+        case COAP_APPLICATION_JSON:
+        case COAP_CONTENT_FORMAT_SENML_JSON:
+            return true;
+        case COAP_CONTENT_FORMAT_SENML_CBOR:
+            format = SENML_FORMAT_CBOR;
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// Called by CarrierManager after every sensor refresh: one push per observer
+// instead of one poll per client, skipping changes inside the deadband
+void notifyObservers() {
+    if (!wifi.connected()) {
+        return;
+    }
+
+    for (int r = 0; r < RESOURCE_COUNT; r++) {
+        ObservableResource &resource = resources[r];
+
+        if (!observers.observed(r)) {
+            continue;
+        }
+
+        int32_t values[SENSOR_VALUES_MAX];
+        size_t count = readChannels(resource.channel, resource.channels, values);
+
+        if (!exceedsDeadband(resource, values, count)) {
+            continue;
+        }
+
+        memcpy(resource.notified, values, count * sizeof(int32_t));
+        resource.sequence = (resource.sequence + 1) & COAP_OBSERVE_SEQUENCE_MASK;
+
+        for (size_t i = 0; i < observers.capacity(); i++) {
+            CoapObservers::Observer &observer = observers.get(i);
+
+            if (observer.active && observer.resource == r) {
+                sendNotification(observer, false);
+            }
+        }
+    }
+}
+
+// Called by CarrierManager for every input event. Motion and gestures are logged and pushed
+// to their observers right away, touches only change the page on the display.
+void logInputEvent(const InputEvent &event) {
+    for (int e = 0; e < EVENT_RESOURCE_COUNT; e++) {
+        EventLog &log = eventLogs[e];
+
+        if (log.type != event.type) {
+            continue;
+        }
+
+        log.events[log.count % EVENT_LOG_SIZE] = event;
+        log.count++;
+        log.sequence = (log.sequence + 1) & COAP_OBSERVE_SEQUENCE_MASK;
+
+        if (!wifi.connected() || !observers.observed(EVENT_OBSERVER(e))) {
+            continue;
+        }
+
+        for (size_t i = 0; i < observers.capacity(); i++) {
+            CoapObservers::Observer &observer = observers.get(i);
+
+            if (observer.active && observer.resource == EVENT_OBSERVER(e)) {
+                sendNotification(observer, false);
+            }
+        }
+    }
+}
+
+// Pushes the current representation of the observed sensor or event resource. A retransmission
+// keeps the message ID of the pending CON, anything else is a new message.
+void sendNotification(CoapObservers::Observer &observer, bool retransmission) {
+    unsigned long now = millis();
+    uint8_t type = observers.notificationType(observer, now);
+    CoapBlock block = { 0, COAP_BLOCK_SZX_MAX, false };
+
+    if (!retransmission) {
+        observer.messageId = CoapMessage::nextMessageId();
+    }
+
+    if (observer.resource < RESOURCE_COUNT) {
+        ObservableResource &resource = resources[observer.resource];
+        size_t length;
+
+        sendSenML(resource, observer.format, type, observer.messageId,
+            observer.token, observer.tokenLength, true, block, observer.ip, observer.port);
+
+        // The notification was a 5.00, which ends the observation (RFC 7641 §3.2)
+        if (resource.cache->get(carrier, carrier.getSensorGeneration(resource.group), observer.format, length) == NULL) {
+            observer.active = false;
+            return;
+        }
+    } else {
+        EventPack pack = { observer.format, &eventLogs[observer.resource - RESOURCE_COUNT] };
+
+        sendEvents(pack, type, observer.messageId,
+            observer.token, observer.tokenLength, true, block, observer.ip, observer.port);
+    }
+
+    if (retransmission) {
+        observers.retransmitted(observer, now);
+    } else {
+        observers.notified(observer, type, now);
+    }
+}
+
+// Resends the CON notifications whose ACK timed out, retransmissionDue() drops the
+// observers that never answered
+void retransmitNotifications() {
+    unsigned long now = millis();
+
+    for (size_t i = 0; i < observers.capacity(); i++) {
+        CoapObservers::Observer &observer = observers.get(i);
+
+        if (observers.retransmissionDue(observer, now)) {
+            sendNotification(observer, true);
+        }
+    }
+}
+
+bool exceedsDeadband(ObservableResource &resource, const int32_t *values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int64_t change = (int64_t) values[i] - resource.notified[i];
+
+        if (change >= resource.deadband || -change >= resource.deadband) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Copies consecutive channels out of one consistent snapshot, for the encoders and the Observe deadband
+size_t readChannels(int channel, size_t count, int32_t *values) {
+    const SensorSnapshotBuffer &snapshots = carrier.getSnapshots();
+    uint32_t sequence;
+
+    do {
+        const SensorSnapshot &snapshot = snapshots.read(sequence);
+        memcpy(values, &snapshot.channels[channel], count * sizeof(int32_t));
+    } while (!snapshots.valid(sequence));
+
+    return count;
+}
+
+
+bool enabled_env(CarrierManager& carrier) {
+    return carrier.getEnvironmentSensor().enabled;
+}
+
+bool enabled_prss(CarrierManager& carrier) {
+    return carrier.getPressureSensor().enabled;
+}
+
+bool enabled_accl(CarrierManager& carrier) {
+    return carrier.getIMUSensor().accelerometer.enabled;
+}
+
+bool enabled_gyro(CarrierManager& carrier) {
+    return carrier.getIMUSensor().gyroscope.enabled;
 }
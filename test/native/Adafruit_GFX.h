@@ -0,0 +1,178 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+typedef struct {
+    uint16_t bitmapOffset;
+    uint8_t width;
+    uint8_t height;
+    uint8_t xAdvance;
+    int8_t xOffset;
+    int8_t yOffset;
+} GFXglyph;
+
+typedef struct {
+    uint8_t *bitmap;
+    GFXglyph *glyph;
+    uint16_t first;
+    uint16_t last;
+    uint8_t yAdvance;
+} GFXfont;
+
+
+// Pixel-level primitives only, text goes through the band renderer in the tests. The filled
+// shapes are Adafruit_GFX's own integer algorithms, the icon tests compare sprites with them.
+class Adafruit_GFX {
+public:
+    Adafruit_GFX(int16_t width, int16_t height) : screenWidth(width), screenHeight(height) {}
+    virtual ~Adafruit_GFX() {}
+
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    virtual void fillRect(int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color) {
+        for (int16_t row = y; row < y + height; row++) {
+            for (int16_t column = x; column < x + width; column++) {
+                this->drawPixel(column, row, color);
+            }
+        }
+    }
+
+    void fillScreen(uint16_t color) {
+        this->fillRect(0, 0, this->screenWidth, this->screenHeight, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t height, uint16_t color) {
+        this->fillRect(x, y, 1, height, color);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t width, uint16_t color) {
+        this->fillRect(x, y, width, 1, color);
+    }
+
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+        this->drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+        this->fillCircleHelper(x0, y0, r, 3, 0, color);
+    }
+
+    void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color) {
+        int16_t f = 1 - r;
+        int16_t ddFx = 1;
+        int16_t ddFy = -2 * r;
+        int16_t x = 0;
+        int16_t y = r;
+        int16_t px = x;
+        int16_t py = y;
+
+        delta++;
+
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddFy += 2;
+                f += ddFy;
+            }
+            x++;
+            ddFx += 2;
+            f += ddFx;
+
+            if (x < y + 1) {
+                if (corners & 1) this->drawFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+                if (corners & 2) this->drawFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+            }
+            if (y != py) {
+                if (corners & 1) this->drawFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+                if (corners & 2) this->drawFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+                py = y;
+            }
+            px = x;
+        }
+    }
+
+    void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color) {
+        int16_t a, b, y, last;
+
+        // Sorted by y, y0 <= y1 <= y2
+        if (y0 > y1) {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+        if (y1 > y2) {
+            swap(y2, y1);
+            swap(x2, x1);
+        }
+        if (y0 > y1) {
+            swap(y0, y1);
+            swap(x0, x1);
+        }
+
+        if (y0 == y2) {
+            a = b = x0;
+            if (x1 < a) a = x1;
+            else if (x1 > b) b = x1;
+            if (x2 < a) a = x2;
+            else if (x2 > b) b = x2;
+            this->drawFastHLine(a, y0, b - a + 1, color);
+            return;
+        }
+
+        int16_t dx01 = x1 - x0, dy01 = y1 - y0;
+        int16_t dx02 = x2 - x0, dy02 = y2 - y0;
+        int16_t dx12 = x2 - x1, dy12 = y2 - y1;
+        int32_t sa = 0, sb = 0;
+
+        // The scanline of y1 belongs to the upper half unless the lower one is flat
+        last = (y1 == y2) ? y1 : y1 - 1;
+
+        for (y = y0; y <= last; y++) {
+            a = x0 + sa / dy01;
+            b = x0 + sb / dy02;
+            sa += dx01;
+            sb += dx02;
+            if (a > b) swap(a, b);
+            this->drawFastHLine(a, y, b - a + 1, color);
+        }
+
+        sa = (int32_t) dx12 * (y - y1);
+        sb = (int32_t) dx02 * (y - y0);
+        for (; y <= y2; y++) {
+            a = x1 + sa / dy12;
+            b = x0 + sb / dy02;
+            sa += dx12;
+            sb += dx02;
+            if (a > b) swap(a, b);
+            this->drawFastHLine(a, y, b - a + 1, color);
+        }
+    }
+
+    void setFont(const GFXfont* font) {}
+    void setTextColor(uint16_t color) {}
+    void setCursor(int16_t x, int16_t y) {}
+    size_t print(const String& text) { return 0; }
+
+    void getTextBounds(const char* text, int16_t x, int16_t y, int16_t* boundsX, int16_t* boundsY, uint16_t* width, uint16_t* height) {
+        *boundsX = x;
+        *boundsY = y;
+        *width = 0;
+        *height = 0;
+    }
+
+    int16_t width() const {
+        return this->screenWidth;
+    }
+
+    int16_t height() const {
+        return this->screenHeight;
+    }
+protected:
+    int16_t screenWidth;
+    int16_t screenHeight;
+private:
+    static void swap(int16_t& a, int16_t& b) {
+        int16_t t = a;
+        a = b;
+        b = t;
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+
+#include <Adafruit_GFX.h>
+
+
+#define NATIVE_DISPLAY_WIDTH 240
+#define NATIVE_DISPLAY_HEIGHT 240
+#define NATIVE_DISPLAY_DMA_POLLS 3      // dmaBusy() calls a transfer started without blocking lasts
+
+
+// Fake panel: everything drawn lands in a framebuffer the tests compare. A non-blocking
+// writePixels() stands for a DMA transfer: the pixels are only read from the caller's buffer
+// when it completes, after a few dmaBusy() polls or in dmaWait(), as the hardware would.
+class Adafruit_ST7789 : public Adafruit_GFX {
+public:
+    uint16_t framebuffer[NATIVE_DISPLAY_WIDTH * NATIVE_DISPLAY_HEIGHT];
+    unsigned long pixelsWritten;
+    int dmaPolls;
+
+
+    Adafruit_ST7789() : Adafruit_GFX(NATIVE_DISPLAY_WIDTH, NATIVE_DISPLAY_HEIGHT) {
+        memset(this->framebuffer, 0, sizeof(this->framebuffer));
+        this->pixelsWritten = 0;
+        this->dmaPolls = 0;
+        this->pendingColors = NULL;
+        this->pendingLength = 0;
+        this->setAddrWindow(0, 0, 0, 0);
+    }
+
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x >= 0 && y >= 0 && x < this->screenWidth && y < this->screenHeight) {
+            this->framebuffer[y * this->screenWidth + x] = color;
+            this->pixelsWritten++;
+        }
+    }
+
+    void startWrite() {}
+    void endWrite() {}
+
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+        this->windowX = x;
+        this->windowY = y;
+        this->windowWidth = width;
+        this->windowHeight = height;
+        this->windowPosition = 0;
+    }
+
+    void writePixels(uint16_t* colors, uint32_t length, bool block = true, bool bigEndian = false) {
+        this->dmaWait();
+
+        this->pendingColors = colors;
+        this->pendingLength = length;
+        this->dmaPolls = NATIVE_DISPLAY_DMA_POLLS;
+
+        if (block) {
+            this->dmaWait();
+        }
+    }
+
+    bool dmaBusy() {
+        if (this->dmaPolls > 0 && --this->dmaPolls > 0) {
+            return true;
+        }
+
+        this->completeTransfer();
+        return false;
+    }
+
+    void dmaWait() {
+        this->dmaPolls = 0;
+        this->completeTransfer();
+    }
+private:
+    uint16_t windowX, windowY;
+    uint16_t windowWidth, windowHeight;
+    uint32_t windowPosition;
+
+    const uint16_t* pendingColors;
+    uint32_t pendingLength;
+
+
+    void completeTransfer() {
+        for (uint32_t i = 0; i < this->pendingLength && this->windowWidth > 0; i++, this->windowPosition++) {
+            this->drawPixel(this->windowX + this->windowPosition % this->windowWidth,
+                this->windowY + this->windowPosition / this->windowWidth, this->pendingColors[i]);
+        }
+
+        this->pendingLength = 0;
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+
+// Stand-in for the Arduino core in the native test env: the types and calls the portable
+// modules use, with a clock the tests set instead of a hardware timer.
+
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*) (address))
+
+#define __WFI()
+
+
+inline unsigned long& nativeMillis() {
+    static unsigned long ms = 0;
+    return ms;
+}
+
+inline unsigned long millis() {
+    return nativeMillis();
+}
+
+inline unsigned long micros() {
+    return nativeMillis() * 1000;
+}
+
+inline long random(long max) {
+    return max > 0 ? rand() % max : 0;
+}
+
+inline long random(long min, long max) {
+    return min + rand() % (max - min);
+}
+
+
+class String {
+public:
+    String() {}
+    String(const char* str) : value(str) {}
+
+
+    const char* c_str() const {
+        return this->value.c_str();
+    }
+
+    size_t length() const {
+        return this->value.size();
+    }
+private:
+    std::string value;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+
+#include <Arduino.h>
+
+
+class IPAddress {
+public:
+    IPAddress() {
+        memset(this->bytes, 0, sizeof(this->bytes));
+    }
+
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        this->bytes[0] = a;
+        this->bytes[1] = b;
+        this->bytes[2] = c;
+        this->bytes[3] = d;
+    }
+
+
+    bool operator==(const IPAddress& other) const {
+        return memcmp(this->bytes, other.bytes, sizeof(this->bytes)) == 0;
+    }
+
+    bool operator!=(const IPAddress& other) const {
+        return !(*this == other);
+    }
+
+    uint8_t operator[](int index) const {
+        return this->bytes[index];
+    }
+private:
+    uint8_t bytes[4];
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+#include "utility/wifi_drv.h"
+
+
+class WiFiClass {
+public:
+    IPAddress localIP() {
+        nativeNina().spiCalls++;
+        return IPAddress(192, 168, 1, 20);
+    }
+};
+
+static WiFiClass WiFi __attribute__((unused));
@@ -0,0 +1,54 @@
+#pragma once
+
+
+// The message types of coap-simple, without its UDP server, which the tests do not use
+
+
+#include <Arduino.h>
+
+
+#define COAP_MAX_OPTION_NUM 10
+#define RESPONSE_CODE(class, detail) ((class << 5) | (detail))
+
+
+typedef enum {
+    COAP_CON = 0,
+    COAP_NONCON = 1,
+    COAP_ACK = 2,
+    COAP_RESET = 3
+} COAP_TYPE;
+
+typedef enum {
+    COAP_GET = 1,
+    COAP_POST = 2,
+    COAP_PUT = 3,
+    COAP_DELETE = 4
+} COAP_METHOD;
+
+typedef enum {
+    COAP_CONTENT = RESPONSE_CODE(2, 5),
+    COAP_BAD_REQUEST = RESPONSE_CODE(4, 0),
+    COAP_BAD_OPTION = RESPONSE_CODE(4, 2),
+    COAP_NOT_ACCEPTABLE = RESPONSE_CODE(4, 6),
+    COAP_INTERNAL_SERVER_ERROR = RESPONSE_CODE(5, 0)
+} COAP_RESPONSE_CODE;
+
+class CoapOption {
+public:
+    uint8_t number;
+    uint8_t length;
+    uint8_t *buffer;
+};
+
+class CoapPacket {
+public:
+    uint8_t type = 0;
+    uint8_t code = 0;
+    const uint8_t *token = NULL;
+    uint8_t tokenlen = 0;
+    const uint8_t *payload = NULL;
+    size_t payloadlen = 0;
+    uint16_t messageid = 0;
+    uint8_t optionnum = 0;
+    CoapOption options[COAP_MAX_OPTION_NUM];
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+
+#define NATIVE_NINA_SPI_US 250          // one command and its reply, at 8 MHz with the NINA's turnaround
+
+
+enum wl_status_t {
+    WL_NO_SHIELD = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+};
+
+
+// Fake NINA coprocessor: once handed a passphrase it joins on its own, as the firmware does,
+// and answers after joinMs with the outcome. The tests switch the access point on and off and
+// count the SPI round trips the sketch makes.
+struct NativeNina {
+    bool accessPoint;
+    unsigned long joinMs;
+
+    unsigned long spiCalls;
+    unsigned long joins;
+    unsigned long lastJoinMs;
+    unsigned long lastDisconnectMs;
+
+    uint8_t status;
+    bool joining;
+};
+
+inline NativeNina& nativeNina() {
+    static NativeNina nina;
+    return nina;
+}
+
+
+class WiFiDrv {
+public:
+    static int8_t wifiSetPassphrase(const char* ssid, uint8_t ssidLength, const char* passphrase, const uint8_t length) {
+        NativeNina& nina = nativeNina();
+
+        nina.spiCalls++;
+        nina.joins++;
+        nina.lastJoinMs = millis();
+        nina.status = WL_IDLE_STATUS;
+        nina.joining = true;
+        return 1;
+    }
+
+    static uint8_t getConnectionStatus() {
+        NativeNina& nina = nativeNina();
+
+        nina.spiCalls++;
+        if (nina.joining && millis() - nina.lastJoinMs >= nina.joinMs) {
+            nina.status = nina.accessPoint ? WL_CONNECTED : WL_NO_SSID_AVAIL;
+            nina.joining = false;
+        } else if (nina.status == WL_CONNECTED && !nina.accessPoint) {
+            nina.status = WL_CONNECTION_LOST;
+        }
+
+        return nina.status;
+    }
+
+    static int8_t disconnect() {
+        NativeNina& nina = nativeNina();
+
+        nina.spiCalls++;
+        nina.lastDisconnectMs = millis();
+        nina.status = WL_DISCONNECTED;
+        nina.joining = false;
+        return 1;
+    }
+};
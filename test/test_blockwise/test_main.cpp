@@ -0,0 +1,244 @@
+#include <unity.h>
+
+#include "CoapBlockwise.h"
+#include "CoapOptions.h"
+
+
+// Block2 slicing of a generated representation, read back from the encoded messages the
+// way a client reassembles them (RFC 7959 §2.4)
+
+
+#define TEST_REPRESENTATION_SIZE 1000
+#define TEST_BLOCKS_MAX 128
+
+
+struct TestBlock {
+    unsigned long num;
+    bool more;
+    uint8_t szx;
+    bool hasBlock2;
+    unsigned long size2;
+    bool hasSize2;
+    const uint8_t* payload;
+    size_t payloadLength;
+};
+
+
+static char representation[TEST_REPRESENTATION_SIZE];
+static char reassembled[TEST_REPRESENTATION_SIZE];
+
+static uint8_t optionValue[4];
+static CoapPacket request;
+
+
+static void generateRepresentation(BufferWriter& writer, const void* context) {
+    writer.write((const uint8_t*) representation, sizeof(representation));
+}
+
+static unsigned long readUint(const uint8_t* value, size_t length) {
+    unsigned long result = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        result = (result << 8) | value[i];
+    }
+
+    return result;
+}
+
+// Walks the options of an encoded message, enough of RFC 7252 §3.1 for what CoapMessage writes
+static TestBlock parseBlock(const uint8_t* data, size_t length) {
+    TestBlock block = {};
+    size_t position = 4 + (data[0] & 0x0F);
+    unsigned int number = 0;
+
+    while (position < length && data[position] != 0xFF) {
+        unsigned int delta = data[position] >> 4;
+        size_t optionLength = data[position] & 0x0F;
+        position++;
+
+        if (delta == 13) {
+            delta = data[position++] + 13;
+        } else if (delta == 14) {
+            delta = ((data[position] << 8) | data[position + 1]) + 269;
+            position += 2;
+        }
+        if (optionLength == 13) {
+            optionLength = data[position++] + 13;
+        }
+
+        number += delta;
+        unsigned long value = readUint(data + position, optionLength);
+
+        if (number == COAP_OPTION_BLOCK2) {
+            block.num = value >> 4;
+            block.more = (value & 0x08) != 0;
+            block.szx = value & 0x07;
+            block.hasBlock2 = true;
+        } else if (number == COAP_OPTION_SIZE2) {
+            block.size2 = value;
+            block.hasSize2 = true;
+        }
+
+        position += optionLength;
+    }
+
+    if (position < length) {
+        block.payload = data + position + 1;
+        block.payloadLength = length - position - 1;
+    }
+
+    return block;
+}
+
+static TestBlock writeBlock(unsigned long num, uint8_t szx, bool requested) {
+    CoapMessage message(COAP_ACK, COAP_CONTENT, 1, NULL, 0);
+    CoapBlock block = { num, szx, requested };
+
+    TEST_ASSERT_TRUE(coapWriteBlock(message, block, generateRepresentation, NULL));
+    TEST_ASSERT_FALSE(message.overflow());
+
+    return parseBlock(message.data(), message.length());
+}
+
+static void setBlock2(const uint8_t* value, uint8_t length) {
+    memcpy(optionValue, value, length);
+
+    request.optionnum = 1;
+    request.options[0].number = COAP_OPTION_BLOCK2;
+    request.options[0].length = length;
+    request.options[0].buffer = optionValue;
+}
+
+static void reassembleAt(uint8_t szx) {
+    size_t received = 0;
+    bool more = true;
+
+    for (unsigned long num = 0; more && num < TEST_BLOCKS_MAX; num++) {
+        TestBlock block = writeBlock(num, szx, num > 0);
+
+        TEST_ASSERT_TRUE(block.hasBlock2);
+        TEST_ASSERT_EQUAL(num, block.num);
+        TEST_ASSERT_EQUAL(szx, block.szx);
+        TEST_ASSERT_EQUAL(num == 0, block.hasSize2);
+        if (block.hasSize2) {
+            TEST_ASSERT_EQUAL(TEST_REPRESENTATION_SIZE, block.size2);
+        }
+
+        more = block.more;
+        if (more) {
+            TEST_ASSERT_EQUAL(COAP_BLOCK_SIZE(szx), block.payloadLength);
+        }
+
+        TEST_ASSERT_TRUE(received + block.payloadLength <= TEST_REPRESENTATION_SIZE);
+        memcpy(reassembled + received, block.payload, block.payloadLength);
+        received += block.payloadLength;
+    }
+
+    TEST_ASSERT_FALSE(more);
+    TEST_ASSERT_EQUAL(TEST_REPRESENTATION_SIZE, received);
+    TEST_ASSERT_EQUAL_MEMORY(representation, reassembled, TEST_REPRESENTATION_SIZE);
+}
+
+
+void setUp(void) {
+    for (size_t i = 0; i < sizeof(representation); i++) {
+        representation[i] = (char) (i * 31 + 7);
+    }
+
+    memset(reassembled, 0, sizeof(reassembled));
+    request = CoapPacket();
+}
+
+void tearDown(void) {}
+
+
+void test_reassembles_at_server_block_size(void) {
+    reassembleAt(COAP_BLOCK_SZX_MAX);
+}
+
+void test_reassembles_at_smaller_client_block_size(void) {
+    reassembleAt(0);
+    reassembleAt(1);
+}
+
+void test_block_past_end_is_rejected(void) {
+    unsigned long last = (TEST_REPRESENTATION_SIZE - 1) / COAP_BLOCK_SIZE(COAP_BLOCK_SZX_MAX);
+    CoapMessage message(COAP_ACK, COAP_CONTENT, 1, NULL, 0);
+    CoapBlock block = { last + 1, COAP_BLOCK_SZX_MAX, true };
+
+    TEST_ASSERT_FALSE(coapWriteBlock(message, block, generateRepresentation, NULL));
+}
+
+void test_small_representation_has_no_block2(void) {
+    CoapMessage message(COAP_ACK, COAP_CONTENT, 1, NULL, 0);
+    CoapBytes bytes = { "short", 5 };
+    CoapBlock block = coapRequestedBlock(request);
+
+    TEST_ASSERT_TRUE(coapWriteBlock(message, block, coapWriteBytes, &bytes));
+
+    TestBlock written = parseBlock(message.data(), message.length());
+    TEST_ASSERT_FALSE(written.hasBlock2);
+    TEST_ASSERT_EQUAL(5, written.payloadLength);
+    TEST_ASSERT_EQUAL_MEMORY("short", written.payload, 5);
+}
+
+// A client asking for 512 byte blocks gets the same bytes in 128 byte blocks
+void test_larger_client_block_size_is_scaled(void) {
+    const uint8_t value[] = { (1 << 4) | 5 };
+    setBlock2(value, sizeof(value));
+
+    TEST_ASSERT_TRUE(coapBlockValid(request));
+
+    CoapBlock block = coapRequestedBlock(request);
+    TEST_ASSERT_TRUE(block.requested);
+    TEST_ASSERT_EQUAL(COAP_BLOCK_SZX_MAX, block.szx);
+    TEST_ASSERT_EQUAL(1 * 4, block.num);
+
+    TestBlock written = writeBlock(block.num, block.szx, block.requested);
+    TEST_ASSERT_EQUAL_MEMORY(representation + 512, written.payload, written.payloadLength);
+}
+
+void test_reserved_szx_is_invalid(void) {
+    const uint8_t value[] = { 0x07 };
+    setBlock2(value, sizeof(value));
+
+    TEST_ASSERT_FALSE(coapBlockValid(request));
+}
+
+void test_overflowing_num_is_invalid(void) {
+    const uint8_t largest[] = { 0x1F, 0xFF, 0xF6 };
+    const uint8_t overflowing[] = { 0x20, 0x00, 0x06 };
+    const uint8_t tooLong[] = { 0x00, 0x00, 0x00, 0x03 };
+
+    setBlock2(largest, sizeof(largest));
+    TEST_ASSERT_TRUE(coapBlockValid(request));
+
+    setBlock2(overflowing, sizeof(overflowing));
+    TEST_ASSERT_FALSE(coapBlockValid(request));
+
+    setBlock2(tooLong, sizeof(tooLong));
+    TEST_ASSERT_FALSE(coapBlockValid(request));
+}
+
+void test_missing_block2_is_valid(void) {
+    TEST_ASSERT_TRUE(coapBlockValid(request));
+
+    CoapBlock block = coapRequestedBlock(request);
+    TEST_ASSERT_FALSE(block.requested);
+    TEST_ASSERT_EQUAL(0, block.num);
+    TEST_ASSERT_EQUAL(COAP_BLOCK_SZX_MAX, block.szx);
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reassembles_at_server_block_size);
+    RUN_TEST(test_reassembles_at_smaller_client_block_size);
+    RUN_TEST(test_block_past_end_is_rejected);
+    RUN_TEST(test_small_representation_has_no_block2);
+    RUN_TEST(test_larger_client_block_size_is_scaled);
+    RUN_TEST(test_reserved_szx_is_invalid);
+    RUN_TEST(test_overflowing_num_is_invalid);
+    RUN_TEST(test_missing_block2_is_valid);
+    return UNITY_END();
+}
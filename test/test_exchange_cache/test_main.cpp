@@ -0,0 +1,217 @@
+#include <new>
+#include <unity.h>
+
+#include "CoapServer.h"
+
+
+// Retransmitted confirmables through CoapServer, with a UDP stand-in that hands out one
+// datagram per parsePacket() and keeps the last one sent
+
+
+#define TEST_DATAGRAM_MAX 64
+#define TEST_PORT 5683
+
+
+class TestUdp : public UDP {
+public:
+    uint8_t incoming[TEST_DATAGRAM_MAX];
+    size_t incomingLength;
+    IPAddress incomingIp;
+    uint16_t incomingPort;
+
+    uint8_t sent[COAP_MESSAGE_BUFFER_SIZE];
+    size_t sentLength;
+    unsigned long sentCount;
+
+
+    uint8_t begin(uint16_t port) override {
+        return 1;
+    }
+
+    int beginPacket(IPAddress ip, uint16_t port) override {
+        this->sentLength = 0;
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) override {
+        memcpy(this->sent + this->sentLength, data, length);
+        this->sentLength += length;
+        return length;
+    }
+
+    int endPacket() override {
+        this->sentCount++;
+        return 1;
+    }
+
+    int parsePacket() override {
+        int size = (int) this->incomingLength;
+        this->pending = this->incomingLength;
+        this->incomingLength = 0;
+        return size;
+    }
+
+    int read(unsigned char* buffer, size_t length) override {
+        size_t count = this->pending < length ? this->pending : length;
+        memcpy(buffer, this->incoming, count);
+        this->pending = 0;
+        return (int) count;
+    }
+
+    IPAddress remoteIP() override {
+        return this->incomingIp;
+    }
+
+    uint16_t remotePort() override {
+        return this->incomingPort;
+    }
+
+    int available() override {
+        return (int) this->pending;
+    }
+
+    void flush() override {}
+private:
+    size_t pending = 0;
+};
+
+
+static TestUdp udp;
+static CoapServer* server;
+static unsigned long dispatched;
+
+
+// Answers with the number of requests it has handled, so a replay is told apart from a new run
+static void dispatchCounter(CoapPacket& packet, const char* path, IPAddress ip, int port) {
+    dispatched++;
+
+    bool confirmable = packet.type == COAP_CON;
+    uint8_t payload = (uint8_t) dispatched;
+
+    CoapMessage message(confirmable ? COAP_ACK : COAP_NONCON, COAP_CONTENT,
+        confirmable ? packet.messageid : CoapMessage::nextMessageId(), packet.token, packet.tokenlen);
+    message.setPayload(&payload, 1);
+    message.send(udp, ip, port);
+}
+
+static void receive(uint8_t type, uint16_t messageId, IPAddress ip, uint16_t port) {
+    const uint8_t request[] = {
+        (uint8_t) (0x41 | (type << 4)), COAP_GET, (uint8_t) (messageId >> 8), (uint8_t) messageId, 0x5A,
+        0xB4, 't', 'e', 's', 't'
+    };
+
+    memcpy(udp.incoming, request, sizeof(request));
+    udp.incomingLength = sizeof(request);
+    udp.incomingIp = ip;
+    udp.incomingPort = port;
+
+    TEST_ASSERT_EQUAL(1, server->loop(1, 1000000));
+}
+
+static uint8_t lastPayload() {
+    TEST_ASSERT_TRUE(udp.sentLength >= 2);
+    TEST_ASSERT_EQUAL(0xFF, udp.sent[udp.sentLength - 2]);
+
+    return udp.sent[udp.sentLength - 1];
+}
+
+
+void setUp(void) {
+    static uint8_t storage[sizeof(CoapServer)];
+
+    udp = TestUdp();
+    server = new (storage) CoapServer(udp);
+    server->setDispatcher(dispatchCounter);
+
+    dispatched = 0;
+    nativeMillis() = 1000;
+}
+
+void tearDown(void) {
+    server->~CoapServer();
+}
+
+
+void test_retransmitted_con_gets_cached_reply(void) {
+    IPAddress client(192, 168, 1, 20);
+
+    receive(COAP_CON, 0x1234, client, TEST_PORT);
+    uint8_t first[COAP_MESSAGE_BUFFER_SIZE];
+    size_t firstLength = udp.sentLength;
+    memcpy(first, udp.sent, firstLength);
+
+    nativeMillis() += 2000;
+    receive(COAP_CON, 0x1234, client, TEST_PORT);
+
+    TEST_ASSERT_EQUAL(1, dispatched);
+    TEST_ASSERT_EQUAL(2, udp.sentCount);
+    TEST_ASSERT_EQUAL(firstLength, udp.sentLength);
+    TEST_ASSERT_EQUAL_MEMORY(first, udp.sent, firstLength);
+}
+
+// The key is endpoint and message ID: another port or another ID is a new exchange
+void test_other_endpoint_or_id_is_handled(void) {
+    IPAddress client(192, 168, 1, 20);
+
+    receive(COAP_CON, 0x1234, client, TEST_PORT);
+    receive(COAP_CON, 0x1234, client, TEST_PORT + 1);
+    receive(COAP_CON, 0x1234, IPAddress(192, 168, 1, 21), TEST_PORT);
+    receive(COAP_CON, 0x1235, client, TEST_PORT);
+
+    TEST_ASSERT_EQUAL(4, dispatched);
+    TEST_ASSERT_EQUAL(4, lastPayload());
+}
+
+void test_non_confirmable_is_not_cached(void) {
+    IPAddress client(192, 168, 1, 20);
+
+    receive(COAP_NONCON, 0x2000, client, TEST_PORT);
+    receive(COAP_NONCON, 0x2000, client, TEST_PORT);
+
+    TEST_ASSERT_EQUAL(2, dispatched);
+}
+
+void test_exchange_expires_after_lifetime(void) {
+    IPAddress client(192, 168, 1, 20);
+
+    receive(COAP_CON, 0x3000, client, TEST_PORT);
+
+    nativeMillis() += COAP_EXCHANGE_LIFETIME_MS - 1;
+    receive(COAP_CON, 0x3000, client, TEST_PORT);
+    TEST_ASSERT_EQUAL(1, dispatched);
+    TEST_ASSERT_EQUAL(1, lastPayload());
+
+    nativeMillis() += 1;
+    receive(COAP_CON, 0x3000, client, TEST_PORT);
+    TEST_ASSERT_EQUAL(2, dispatched);
+    TEST_ASSERT_EQUAL(2, lastPayload());
+}
+
+// A full cache gives up the oldest exchange, the newer ones are still replayed
+void test_full_cache_evicts_oldest(void) {
+    IPAddress client(192, 168, 1, 20);
+
+    for (uint16_t i = 0; i <= COAP_EXCHANGE_CACHE_SIZE; i++) {
+        receive(COAP_CON, 0x4000 + i, client, TEST_PORT);
+        nativeMillis() += 10;
+    }
+    TEST_ASSERT_EQUAL(COAP_EXCHANGE_CACHE_SIZE + 1, dispatched);
+
+    receive(COAP_CON, 0x4000 + COAP_EXCHANGE_CACHE_SIZE, client, TEST_PORT);
+    TEST_ASSERT_EQUAL(COAP_EXCHANGE_CACHE_SIZE + 1, dispatched);
+    TEST_ASSERT_EQUAL(COAP_EXCHANGE_CACHE_SIZE + 1, lastPayload());
+
+    receive(COAP_CON, 0x4000, client, TEST_PORT);
+    TEST_ASSERT_EQUAL(COAP_EXCHANGE_CACHE_SIZE + 2, dispatched);
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_retransmitted_con_gets_cached_reply);
+    RUN_TEST(test_other_endpoint_or_id_is_handled);
+    RUN_TEST(test_non_confirmable_is_not_cached);
+    RUN_TEST(test_exchange_expires_after_lifetime);
+    RUN_TEST(test_full_cache_evicts_oldest);
+    return UNITY_END();
+}
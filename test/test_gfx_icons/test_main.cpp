@@ -0,0 +1,175 @@
+#include <new>
+#include <unity.h>
+
+#include "CarrierGfxScreen.h"
+
+
+// The sprites written by tools/generate_icons.py against the icons as they were drawn before,
+// with Adafruit_GFX's fillCircle, fillTriangle and fillRect: on a cleared panel both must leave
+// the same pixels behind, drawn directly or band by band
+
+
+#define TEST_BUDGET_US 1000000UL
+#define TEST_FLUSH_CALLS_MAX 10000
+
+
+typedef void (*PrimitiveIcon)(Adafruit_ST7789& display, int color, int x, int y);
+
+
+// The primitive drawing the sprites replaced, as it was in CarrierGfxDrawFunctions.cpp
+
+static void drawThermometerPrimitives(Adafruit_ST7789& display, int color, int x, int y) {
+    display.fillCircle(x+15, y+10, 10, color);
+    display.fillRect(x+5, y+10, 21, 28, color);
+    display.fillCircle(x+15, y+45, 15, color);
+
+    display.fillCircle(x+15, y+10, 7, 0x0000);
+    display.fillRect(x+8, y+13, 15, 25, 0x0000);
+    display.fillCircle(x+15, y+45, 12, 0x0000);
+}
+
+static void drawDropletPrimitives(Adafruit_ST7789& display, int color, int x, int y) {
+    display.fillTriangle(x+2, y+30, x+20, y, x+38, y+30, color);
+    display.fillCircle(x+20, y+40, 20, color);
+    display.fillTriangle(x+6, y+30, x+20, y+5, x+34, y+30, 0x0000);
+    display.fillCircle(x+20, y+40, 17, 0x0000);
+}
+
+static void drawMovementPrimitives(Adafruit_ST7789& display, int color, int x, int y) {
+    display.fillTriangle(x+20, y+15, x+30, y, x+40, y+15, color);      // North
+    display.fillTriangle(x+25, y+12, x+30, y+5, x+35, y+12, 0x0000);
+    display.fillTriangle(x, y+30, x+15, y+20, x+15, y+40, color);      // West
+    display.fillTriangle(x+5, y+30, x+12, y+25, x+12, y+35, 0x0000);
+    display.fillTriangle(x+20, y+45, x+40, y+45, x+30, y+60, color);   // South
+    display.fillTriangle(x+25, y+48, x+35, y+48, x+30, y+55, 0x0000);
+    display.fillTriangle(x+45, y+40, x+45, y+20, x+60, y+30, color);   // East
+    display.fillTriangle(x+48, y+35, x+48, y+25, x+55, y+30, 0x0000);
+    display.fillRect(x+15, y+25, 30, 10, color);                         // Horizontal
+    display.fillRect(x+25, y+15, 10, 30, color);                         // Vertical
+    display.fillRect(x+12, y+28, 36, 4, 0x0000);
+    display.fillRect(x+28, y+12, 4, 36, 0x0000);
+}
+
+static void drawRotationPrimitives(Adafruit_ST7789& display, int color, int x, int y) {
+    display.fillCircle(x+30, y+30, 27, color);
+    display.fillCircle(x+30, y+30, 24, 0x0000);
+    display.fillCircle(x+30, y+30, 20, color);
+    display.fillCircle(x+30, y+30, 17, 0x0000);
+
+    display.fillTriangle(x, y, x+30, y, x+30, y+30, 0x0000);
+
+    display.fillTriangle(x+15, y+7, x+30, y, x+30, y+15, color);
+    display.fillTriangle(x+22, y+7, x+27, y+5, x+27, y+10, 0x0000);
+
+    display.fillRect(x+27, y+6, 4, 4, 0x0000);
+
+    display.fillTriangle(x+12, y+12, x+17, y+17, x+12, y+15, color);
+
+    display.fillCircle(x+30, y+30, 5, color);
+    display.fillCircle(x+30, y+30, 2, 0x0000);
+}
+
+static void drawPressurePrimitives(Adafruit_ST7789& display, int color, int x, int y) {
+    display.fillRect(x, y+50, 60, 10, color);
+
+    display.fillTriangle(x+5, y+35, x+25, y+35, x+15, y+50, color);
+    display.fillTriangle(x+35, y+35, x+55, y+35, x+45, y+50, color);
+
+    display.fillRect(x+10, y, 10, 35, color);
+    display.fillRect(x+40, y, 10, 35, color);
+
+    display.fillRect(x+3, y+53, 54, 4, 0x0000);
+
+    display.fillTriangle(x+10, y+38, x+20, y+38, x+15, y+45, 0x0000);
+    display.fillTriangle(x+40, y+38, x+50, y+38, x+45, y+45, 0x0000);
+
+    display.fillRect(x+13, y+3, 4, 35, 0x0000);
+    display.fillRect(x+43, y+3, 4, 35, 0x0000);
+}
+
+
+// Laid out apart from each other, a sprite's background would cover a neighbour's pixels
+static const struct {
+    const GfxSprite* sprite;
+    PrimitiveIcon draw;
+    int color;
+    int x, y;
+} ICONS[] = {
+    { &GFX_THERMOMETER_SPRITE, drawThermometerPrimitives, 0xF800, 10, 10 },
+    { &GFX_DROPLET_SPRITE, drawDropletPrimitives, 0x001F, 60, 13 },
+    { &GFX_MOVEMENT_SPRITE, drawMovementPrimitives, 0x07E0, 121, 7 },
+    { &GFX_ROTATION_SPRITE, drawRotationPrimitives, 0xFFE0, 17, 100 },
+    { &GFX_PRESSURE_SPRITE, drawPressurePrimitives, 0xF81F, 99, 103 }
+};
+
+#define TEST_ICON_COUNT (sizeof(ICONS) / sizeof(ICONS[0]))
+
+
+static Adafruit_ST7789 primitiveDisplay;
+static Adafruit_ST7789 spriteDisplay;
+static CarrierGfxScreen* screen;
+
+
+static void assertSamePixels() {
+    TEST_ASSERT_EQUAL_MEMORY(primitiveDisplay.framebuffer, spriteDisplay.framebuffer, sizeof(primitiveDisplay.framebuffer));
+}
+
+
+void setUp(void) {
+    static uint8_t storage[sizeof(CarrierGfxScreen)];
+
+    primitiveDisplay.fillScreen(0x0000);
+    spriteDisplay.fillScreen(0x0000);
+
+    screen = new (storage) CarrierGfxScreen(spriteDisplay);
+}
+
+void tearDown(void) {}
+
+
+// Each icon alone, at several offsets so no row or column of the sprite lines up by chance
+void test_sprites_match_primitives(void) {
+    const int offsets[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 7, 3 }, { 150, 171 } };
+
+    for (size_t i = 0; i < TEST_ICON_COUNT; i++) {
+        for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+            int x = offsets[o][0];
+            int y = offsets[o][1];
+
+            primitiveDisplay.fillScreen(0x0000);
+            spriteDisplay.fillScreen(0x0000);
+
+            ICONS[i].draw(primitiveDisplay, ICONS[i].color, x, y);
+            drawSprite(spriteDisplay, *ICONS[i].sprite, ICONS[i].color, x, y);
+
+            assertSamePixels();
+        }
+    }
+}
+
+// A page of every icon through the retained screen, rendered in bands
+void test_band_frame_matches_primitives(void) {
+    screen->beginFrame(0);
+    for (size_t i = 0; i < TEST_ICON_COUNT; i++) {
+        screen->icon(*ICONS[i].sprite, ICONS[i].color, ICONS[i].x, ICONS[i].y);
+        ICONS[i].draw(primitiveDisplay, ICONS[i].color, ICONS[i].x, ICONS[i].y);
+    }
+    screen->endFrame();
+
+    unsigned long calls = 0;
+    while (screen->isBusy() && calls < TEST_FLUSH_CALLS_MAX) {
+        screen->flushAsync(TEST_BUDGET_US);
+        calls++;
+    }
+
+    TEST_ASSERT_FALSE(screen->isBusy());
+    assertSamePixels();
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sprites_match_primitives);
+    RUN_TEST(test_band_frame_matches_primitives);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <new>
+#include <unity.h>
+
+#include "CarrierGfxScreen.h"
+
+
+// The same frames drawn on two fake panels, one with flush() and one band by band with
+// flushAsync(), must leave the same pixels behind
+
+
+#define TEST_BUDGET_US 1000000UL
+#define TEST_FLUSH_CALLS_MAX 10000
+
+
+// Digits 4 pixels wide and 6 tall, enough for the glyph cache to build its cells
+static const uint8_t TEST_FONT_BITMAP[] = {
+    0x69, 0x99, 0x96, 0x26, 0x22, 0x27, 0x69, 0x12, 0x4F, 0xE1, 0x61, 0x1E, 0x99, 0xF1, 0x11, 0xF8
+};
+
+static const GFXglyph TEST_FONT_GLYPHS[] = {
+    { 12, 4, 1, 5, 0, -3 },     // '-'
+    { 4, 1, 1, 2, 1, -1 },      // '.'
+    { 0, 0, 0, 5, 0, 0 },       // '/'
+    { 0, 4, 6, 5, 0, -6 },
+    { 3, 4, 6, 5, 0, -6 },
+    { 6, 4, 6, 5, 0, -6 },
+    { 9, 4, 6, 5, 0, -6 },
+    { 12, 4, 6, 5, 0, -6 },
+    { 1, 4, 6, 5, 0, -6 },
+    { 2, 4, 6, 5, 0, -6 },
+    { 5, 4, 6, 5, 0, -6 },
+    { 7, 4, 6, 5, 0, -6 },
+    { 10, 4, 6, 5, 0, -6 }
+};
+
+static const GFXfont TEST_FONT = {
+    (uint8_t*) TEST_FONT_BITMAP, (GFXglyph*) TEST_FONT_GLYPHS, '-', '9', 8
+};
+
+
+static Adafruit_ST7789 syncDisplay;
+static Adafruit_ST7789 bandDisplay;
+static CarrierGfxScreen* syncScreen;
+static CarrierGfxScreen* bandScreen;
+static CarrierGfxGlyphCache glyphs(&TEST_FONT);
+
+
+// A page of icons and fields laid out the way CarrierManager draws its pages
+static void declareFrame(CarrierGfxScreen& screen, int page, int offset, const char* value) {
+    screen.beginFrame(page);
+    screen.icon(GFX_THERMOMETER_SPRITE, 0xF800, 20 + offset, 30);
+    screen.icon(GFX_DROPLET_SPRITE, 0x001F, 100, 30 + offset);
+    screen.icon(GFX_PRESSURE_SPRITE, 0x07E0, 170, 170);
+    screen.field(glyphs, 40, 150, 0xFFFF, value, 8);
+    screen.field(glyphs, 40, 170, 0xFFE0, "-12.5", 6);
+    screen.endFrame();
+}
+
+static unsigned long flushInBands() {
+    unsigned long calls = 0;
+
+    while (bandScreen->isBusy() && calls < TEST_FLUSH_CALLS_MAX) {
+        bandScreen->flushAsync(TEST_BUDGET_US);
+        calls++;
+    }
+
+    TEST_ASSERT_FALSE(bandScreen->isBusy());
+    return calls;
+}
+
+static void drawBoth(int page, int offset, const char* value) {
+    declareFrame(*syncScreen, page, offset, value);
+    syncScreen->flush();
+
+    declareFrame(*bandScreen, page, offset, value);
+    flushInBands();
+
+    TEST_ASSERT_EQUAL_MEMORY(syncDisplay.framebuffer, bandDisplay.framebuffer, sizeof(syncDisplay.framebuffer));
+}
+
+
+void setUp(void) {
+    static uint8_t syncStorage[sizeof(CarrierGfxScreen)];
+    static uint8_t bandStorage[sizeof(CarrierGfxScreen)];
+
+    // Different garbage on each panel, the first frame has to clear all of it
+    for (size_t i = 0; i < NATIVE_DISPLAY_WIDTH * NATIVE_DISPLAY_HEIGHT; i++) {
+        syncDisplay.framebuffer[i] = (uint16_t) (i * 7);
+        bandDisplay.framebuffer[i] = (uint16_t) (i * 13 + 1);
+    }
+
+    syncScreen = new (syncStorage) CarrierGfxScreen(syncDisplay);
+    bandScreen = new (bandStorage) CarrierGfxScreen(bandDisplay);
+
+    TEST_ASSERT_TRUE(glyphs.begin());
+}
+
+void tearDown(void) {}
+
+
+void test_first_frame_matches_sync_flush(void) {
+    drawBoth(0, 0, "21.37");
+}
+
+// Only the changed cells of a field and the moved icons are repainted, by either path
+void test_partial_frames_match_sync_flush(void) {
+    drawBoth(0, 0, "21.37");
+    drawBoth(0, 0, "21.42");
+    drawBoth(0, 12, "21.42");
+    drawBoth(0, 5, "1021.4");
+    drawBoth(0, 5, "1021.4");
+}
+
+void test_page_change_matches_sync_flush(void) {
+    drawBoth(0, 0, "21.37");
+    drawBoth(1, 3, "-0.5");
+}
+
+// A field whose value changes in one digit repaints that digit's cell, not the frame
+void test_one_digit_change_pushes_one_cell(void) {
+    const unsigned long cellPixels = (unsigned long) glyphs.getCellWidth() * glyphs.getCellHeight();
+
+    syncDisplay.pixelsWritten = 0;
+    bandDisplay.pixelsWritten = 0;
+    drawBoth(0, 0, "21.37");
+
+    unsigned long fullFrame = syncDisplay.pixelsWritten;
+    TEST_ASSERT_TRUE(fullFrame >= (unsigned long) NATIVE_DISPLAY_WIDTH * NATIVE_DISPLAY_HEIGHT);
+
+    syncDisplay.pixelsWritten = 0;
+    bandDisplay.pixelsWritten = 0;
+    drawBoth(0, 0, "21.38");
+
+    TEST_ASSERT_EQUAL(cellPixels, syncDisplay.pixelsWritten);
+    TEST_ASSERT_EQUAL(cellPixels, bandDisplay.pixelsWritten);
+    TEST_ASSERT_TRUE(syncDisplay.pixelsWritten * 100 < fullFrame);
+}
+
+// With a transfer in flight and the next band rendered, flushAsync() hands back the rest of
+// its budget instead of polling the DMA until the budget runs out
+void test_flush_async_returns_while_dma_is_busy(void) {
+    declareFrame(*bandScreen, 0, 0, "21.37");
+
+    bandScreen->flushAsync(TEST_BUDGET_US);
+
+    TEST_ASSERT_TRUE(bandScreen->isBusy());
+    TEST_ASSERT_TRUE(bandDisplay.dmaPolls > 0);
+
+    TEST_ASSERT_TRUE(flushInBands() > 1);
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_matches_sync_flush);
+    RUN_TEST(test_partial_frames_match_sync_flush);
+    RUN_TEST(test_page_change_matches_sync_flush);
+    RUN_TEST(test_one_digit_change_pushes_one_cell);
+    RUN_TEST(test_flush_async_returns_while_dma_is_busy);
+    return UNITY_END();
+}
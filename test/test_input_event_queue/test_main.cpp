@@ -0,0 +1,115 @@
+#include <unity.h>
+
+#include "InputEventQueue.h"
+
+
+// Bursts of pushes the way the touch, PIR and gesture interrupts deliver them, interleaved
+// with the pops of inputsLoop(); every event carries a sequence number in its time
+
+
+static InputEventQueue queue;
+
+static unsigned long pushed;
+static unsigned long popped;
+
+
+static bool pushNext() {
+    InputEvent event = { pushed, (uint8_t) (pushed % (INPUT_EVENT_GESTURE_PENDING + 1)), (int8_t) (pushed & 0x7F) };
+
+    if (!queue.push(event)) {
+        return false;
+    }
+
+    pushed++;
+    return true;
+}
+
+// Pops what is queued and checks that it comes out whole and in order
+static void drain(size_t count) {
+    InputEvent event;
+
+    for (size_t i = 0; i < count && queue.pop(event); i++) {
+        TEST_ASSERT_EQUAL(popped, event.time);
+        TEST_ASSERT_EQUAL(popped % (INPUT_EVENT_GESTURE_PENDING + 1), event.type);
+        TEST_ASSERT_EQUAL((int8_t) (popped & 0x7F), event.value);
+        popped++;
+    }
+}
+
+
+void setUp(void) {
+    queue = InputEventQueue();
+    pushed = 0;
+    popped = 0;
+}
+
+void tearDown(void) {}
+
+
+// A burst that fills the ring between two passes of the loop is delivered whole
+void test_burst_up_to_capacity_loses_nothing(void) {
+    for (int i = 0; i < INPUT_EVENT_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(pushNext());
+    }
+
+    TEST_ASSERT_EQUAL(INPUT_EVENT_QUEUE_SIZE, queue.size());
+
+    drain(INPUT_EVENT_QUEUE_SIZE);
+    TEST_ASSERT_EQUAL(INPUT_EVENT_QUEUE_SIZE, popped);
+    TEST_ASSERT_EQUAL(0, queue.size());
+    TEST_ASSERT_EQUAL(0, queue.getDropped());
+}
+
+// Interrupts firing while the loop is part way through draining, for many laps of the ring
+void test_bursts_during_drain_lose_nothing(void) {
+    const size_t bursts[] = { 5, 1, 17, 32, 3, 9, 31, 2 };
+
+    for (int lap = 0; lap < 1000; lap++) {
+        size_t burst = bursts[lap % (sizeof(bursts) / sizeof(bursts[0]))];
+
+        for (size_t i = 0; i < burst && queue.size() < INPUT_EVENT_QUEUE_SIZE; i++) {
+            TEST_ASSERT_TRUE(pushNext());
+        }
+
+        drain(1 + lap % 7);
+    }
+
+    drain(INPUT_EVENT_QUEUE_SIZE);
+    TEST_ASSERT_EQUAL(pushed, popped);
+    TEST_ASSERT_EQUAL(0, queue.getDropped());
+}
+
+// Past capacity the new events are refused and counted, the queued ones are kept
+void test_overflow_drops_new_events_only(void) {
+    for (int i = 0; i < INPUT_EVENT_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(pushNext());
+    }
+
+    TEST_ASSERT_FALSE(pushNext());
+    TEST_ASSERT_FALSE(pushNext());
+    TEST_ASSERT_EQUAL(2, queue.getDropped());
+
+    drain(INPUT_EVENT_QUEUE_SIZE);
+    TEST_ASSERT_EQUAL(INPUT_EVENT_QUEUE_SIZE, popped);
+
+    TEST_ASSERT_TRUE(pushNext());
+    drain(1);
+    TEST_ASSERT_EQUAL(INPUT_EVENT_QUEUE_SIZE + 1, popped);
+}
+
+void test_empty_queue_pops_nothing(void) {
+    InputEvent event;
+
+    TEST_ASSERT_FALSE(queue.pop(event));
+    TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_burst_up_to_capacity_loses_nothing);
+    RUN_TEST(test_bursts_during_drain_lose_nothing);
+    RUN_TEST(test_overflow_drops_new_events_only);
+    RUN_TEST(test_empty_queue_pops_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <chrono>
+#include <cstdio>
+#include <unity.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "MahonyFilter.h"
+
+
+// The fixed-point filter against the textbook Mahony update in double precision, fed the
+// same readings with the same sub-steps
+
+
+#define TEST_DEG_TO_RAD (3.14159265358979 / 180.0)
+#define TEST_QUATERNION_TOLERANCE 1e-3
+#define TEST_ANGLE_TOLERANCE (0.25 * TEST_DEG_TO_RAD)
+#define TEST_BENCHMARK_UPDATES 200000
+#define TEST_BENCHMARK_DT_MS 20         // LOOP_ORIENTATION_UPDATE_MS, one step per update
+
+
+struct ReferenceFilter {
+    double w, x, y, z;
+    double integral[3];
+    double kp, ki;
+};
+
+
+static MahonyFilter filter;
+static ReferenceFilter reference;
+
+
+static void referenceReset(double kp, double ki) {
+    reference.w = 1;
+    reference.x = reference.y = reference.z = 0;
+    reference.integral[0] = reference.integral[1] = reference.integral[2] = 0;
+    reference.kp = kp;
+    reference.ki = ki;
+}
+
+static void referenceStep(const double gyro[3], const double accel[3], double dt) {
+    double rate[3] = { gyro[0], gyro[1], gyro[2] };
+    double norm = sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+
+    if (norm > 0) {
+        double ax = accel[0] / norm, ay = accel[1] / norm, az = accel[2] / norm;
+        double w = reference.w, x = reference.x, y = reference.y, z = reference.z;
+
+        double vx = 2 * (x * z - w * y);
+        double vy = 2 * (w * x + y * z);
+        double vz = w * w - x * x - y * y + z * z;
+
+        double e[3] = { ay * vz - az * vy, az * vx - ax * vz, ax * vy - ay * vx };
+
+        for (int i = 0; i < 3; i++) {
+            if (reference.ki != 0) {
+                reference.integral[i] += reference.ki * e[i] * dt;
+                rate[i] += reference.integral[i];
+            }
+            rate[i] += reference.kp * e[i];
+        }
+    }
+
+    double hx = rate[0] * dt / 2, hy = rate[1] * dt / 2, hz = rate[2] * dt / 2;
+    double w = reference.w, x = reference.x, y = reference.y, z = reference.z;
+
+    reference.w += -x * hx - y * hy - z * hz;
+    reference.x += w * hx + y * hz - z * hy;
+    reference.y += w * hy - x * hz + z * hx;
+    reference.z += w * hz + x * hy - y * hx;
+
+    double length = sqrt(reference.w * reference.w + reference.x * reference.x +
+                         reference.y * reference.y + reference.z * reference.z);
+    reference.w /= length;
+    reference.x /= length;
+    reference.y /= length;
+    reference.z /= length;
+}
+
+// Same clamp and sub-steps as MahonyFilter::updateFixed()
+static void update(float gx, float gy, float gz, float ax, float ay, float az, unsigned long dtMs) {
+    const double gyro[3] = { gx * TEST_DEG_TO_RAD, gy * TEST_DEG_TO_RAD, gz * TEST_DEG_TO_RAD };
+    const double accel[3] = { ax, ay, az };
+
+    filter.update(gx, gy, gz, ax, ay, az, dtMs);
+
+    unsigned long remaining = dtMs > MAHONY_DT_MAX_MS ? MAHONY_DT_MAX_MS : dtMs;
+    while (remaining > MAHONY_STEP_MAX_MS) {
+        referenceStep(gyro, accel, MAHONY_STEP_MAX_MS / 1000.0);
+        remaining -= MAHONY_STEP_MAX_MS;
+    }
+    referenceStep(gyro, accel, remaining / 1000.0);
+}
+
+static void assertMatchesReference() {
+    float w, x, y, z;
+    filter.getQuaternion(w, x, y, z);
+
+    TEST_ASSERT_FLOAT_WITHIN(TEST_QUATERNION_TOLERANCE, reference.w, w);
+    TEST_ASSERT_FLOAT_WITHIN(TEST_QUATERNION_TOLERANCE, reference.x, x);
+    TEST_ASSERT_FLOAT_WITHIN(TEST_QUATERNION_TOLERANCE, reference.y, y);
+    TEST_ASSERT_FLOAT_WITHIN(TEST_QUATERNION_TOLERANCE, reference.z, z);
+}
+
+
+void setUp(void) {
+    filter.setGains(MAHONY_DEFAULT_KP, MAHONY_DEFAULT_KI);
+    filter.reset();
+    referenceReset(MAHONY_DEFAULT_KP, MAHONY_DEFAULT_KI);
+}
+
+void tearDown(void) {}
+
+
+// A board held at 30° of roll: the accelerometer pulls the estimate to the tilt
+void test_static_tilt_converges_like_reference(void) {
+    const double roll = 30 * TEST_DEG_TO_RAD;
+
+    for (int i = 0; i < 500; i++) {
+        update(0, 0, 0, 0, sin(roll), cos(roll), 20);
+
+        if (i % 50 == 49) {
+            assertMatchesReference();
+        }
+    }
+
+    float estimatedRoll, pitch, yaw;
+    filter.getEuler(estimatedRoll, pitch, yaw);
+
+    TEST_ASSERT_FLOAT_WITHIN(TEST_ANGLE_TOLERANCE, roll, estimatedRoll);
+    TEST_ASSERT_FLOAT_WITHIN(TEST_ANGLE_TOLERANCE, 0, pitch);
+}
+
+// Yaw is the gyroscope alone: 90 dps for 2 s is half a turn
+void test_gyro_integration_matches_reference(void) {
+    for (int i = 0; i < 200; i++) {
+        update(0, 0, 90, 0, 0, 1, 10);
+    }
+
+    assertMatchesReference();
+
+    float roll, pitch, yaw;
+    filter.getEuler(roll, pitch, yaw);
+
+    TEST_ASSERT_FLOAT_WITHIN(TEST_ANGLE_TOLERANCE, 180 * TEST_DEG_TO_RAD, fabs(yaw));
+}
+
+// Rotation on all axes with an integral gain, readings that wobble, and gaps long enough
+// to be split into sub-steps or clamped
+void test_moving_board_with_integral_matches_reference(void) {
+    filter.setGains(2.0f, 0.1f);
+    referenceReset(2.0, 0.1);
+
+    for (int i = 0; i < 1000; i++) {
+        double t = i * 0.01;
+        float gx = (float) (40 * sin(t * 1.3));
+        float gy = (float) (25 * cos(t * 0.7));
+        float gz = (float) (10 + 5 * sin(t * 3.1));
+        float ax = (float) (0.2 * sin(t * 0.9));
+        float ay = (float) (0.3 * cos(t * 1.1));
+        float az = (float) (0.9 + 0.05 * sin(t * 5.0));
+        unsigned long dtMs = (i % 100 == 99) ? 120 : 10;
+
+        update(gx, gy, gz, ax, ay, az, dtMs);
+    }
+
+    assertMatchesReference();
+
+    update(0, 0, 0, 0, 0, 1, 5000);
+    assertMatchesReference();
+}
+
+// Free fall or no reading yet: no accelerometer correction, the gyroscope alone
+void test_zero_acceleration_integrates_gyro_only(void) {
+    for (int i = 0; i < 100; i++) {
+        update(30, -20, 10, 0, 0, 0, 10);
+    }
+
+    assertMatchesReference();
+}
+
+// Host time and cycles of updateFixed() on readings that keep changing. A relative figure
+// for comparing changes to the filter; it does not carry over to the Cortex-M0+.
+void test_benchmark_update_fixed(void) {
+    static int32_t gyro[256][3];
+    static int32_t accel[256][3];
+
+    for (int i = 0; i < 256; i++) {
+        double t = i * 0.05;
+        gyro[i][0] = (int32_t) (0.7 * sin(t * 1.3) * MAHONY_Q16_ONE);
+        gyro[i][1] = (int32_t) (0.4 * cos(t * 0.7) * MAHONY_Q16_ONE);
+        gyro[i][2] = (int32_t) (0.2 * sin(t * 3.1) * MAHONY_Q16_ONE);
+        accel[i][0] = (int32_t) (0.2 * sin(t * 0.9) * 16384);
+        accel[i][1] = (int32_t) (0.3 * cos(t * 1.1) * 16384);
+        accel[i][2] = (int32_t) (0.9 * 16384);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned long long cycles = __rdtsc();
+#endif
+
+    for (long i = 0; i < TEST_BENCHMARK_UPDATES; i++) {
+        filter.updateFixed(gyro[i & 0xFF], accel[i & 0xFF], TEST_BENCHMARK_DT_MS);
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    cycles = __rdtsc() - cycles;
+#endif
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    char message[128];
+#if defined(__x86_64__) || defined(__i386__)
+    snprintf(message, sizeof(message), "updateFixed: %.1f ns, %.0f TSC cycles per update",
+        elapsed / TEST_BENCHMARK_UPDATES, (double) cycles / TEST_BENCHMARK_UPDATES);
+#else
+    snprintf(message, sizeof(message), "updateFixed: %.1f ns per update", elapsed / TEST_BENCHMARK_UPDATES);
+#endif
+    TEST_MESSAGE(message);
+
+    // Still a unit quaternion after all those steps
+    float w, x, y, z;
+    filter.getQuaternion(w, x, y, z);
+    TEST_ASSERT_FLOAT_WITHIN(TEST_QUATERNION_TOLERANCE, 1.0, sqrt(w * w + x * x + y * y + z * z));
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_static_tilt_converges_like_reference);
+    RUN_TEST(test_gyro_integration_matches_reference);
+    RUN_TEST(test_moving_board_with_integral_matches_reference);
+    RUN_TEST(test_zero_acceleration_integrates_gyro_only);
+    RUN_TEST(test_benchmark_update_fixed);
+    return UNITY_END();
+}
@@ -0,0 +1,498 @@
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include "SenMLWriter.h"
+
+
+// ArduinoJson prints doubles with up to 9 decimals, the writer rounds to each record's
+// decimals: both agree byte for byte on readings that are exact in binary and within those
+// decimals, and to within half a unit of the record's last decimal on any other reading
+
+
+#define TEST_BN "mkriotcarrier:rack:env"
+#define TEST_BT 123456UL
+#define TEST_BVER 1.0
+#define TEST_BUFFER_SIZE 512
+#define TEST_TEXT_SIZE 64
+#define TEST_PARSE_SLACK 1e-9           // strtod() of the printed decimals, far below any record's half unit
+#define TEST_BENCHMARK_PACKS 200000
+
+// SenML-CBOR labels (RFC 8428 §6)
+#define SENML_CBOR_BVER -1
+#define SENML_CBOR_BN -2
+#define SENML_CBOR_BT -3
+#define SENML_CBOR_N 0
+#define SENML_CBOR_U 1
+#define SENML_CBOR_V 2
+#define SENML_CBOR_T 6
+
+#define CBOR_MAJOR_UNSIGNED 0
+#define CBOR_MAJOR_NEGATIVE 1
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_FLOAT32 0xFA
+
+
+static const SenMLRecord ENVIRONMENT[] = {
+    { "temperature", "Cel", 2 },
+    { "humidity", "%RH", 2 },
+    { "pressure", "Pa", 0 }
+};
+
+static const SenMLRecord ACCELEROMETER[] = {
+    { "accel:x", NULL, 3 },
+    { "accel:y", NULL, 3 },
+    { "accel:z", NULL, 3 }
+};
+
+
+// Readings with no short exact binary form, or with more decimals than their record keeps
+static const struct {
+    const SenMLRecord* record;
+    float value;
+} INEXACT[] = {
+    { &ENVIRONMENT[0], 21.37f },
+    { &ENVIRONMENT[0], 23.456f },
+    { &ENVIRONMENT[0], -0.1f },
+    { &ENVIRONMENT[1], 45.678f },
+    { &ENVIRONMENT[2], 101325.4f },
+    { &ENVIRONMENT[2], 99999.5f },
+    { &ACCELEROMETER[0], 0.1f },
+    { &ACCELEROMETER[1], -0.3337f },
+    { &ACCELEROMETER[2], 9.80665f }
+};
+
+static const struct {
+    const SenMLRecord* record;
+    int32_t value;
+} INEXACT_FIXED[] = {
+    { &ENVIRONMENT[0], 21375 },
+    { &ENVIRONMENT[0], -1005 },
+    { &ENVIRONMENT[1], 45678 },
+    { &ENVIRONMENT[2], 101325499 }
+};
+
+
+static char expected[TEST_BUFFER_SIZE];
+static char actual[TEST_BUFFER_SIZE];
+static uint8_t cbor[TEST_BUFFER_SIZE];
+
+
+// Just enough of a CBOR reader for what SenMLPackWriter writes: heads up to four bytes long,
+// text strings and single-precision floats
+struct CborReader {
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+};
+
+static uint8_t cborReadByte(CborReader& reader) {
+    TEST_ASSERT_TRUE(reader.position < reader.length);
+    return reader.data[reader.position++];
+}
+
+static uint8_t cborPeekMajor(const CborReader& reader) {
+    TEST_ASSERT_TRUE(reader.position < reader.length);
+    return reader.data[reader.position] >> 5;
+}
+
+static unsigned long cborReadHead(CborReader& reader, uint8_t major) {
+    uint8_t initial = cborReadByte(reader);
+    uint8_t info = initial & 0x1F;
+
+    TEST_ASSERT_EQUAL(major, initial >> 5);
+    if (info < 24) {
+        return info;
+    }
+
+    TEST_ASSERT_TRUE(info <= 26);
+    size_t bytes = (size_t) 1 << (info - 24);
+
+    unsigned long value = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        value = (value << 8) | cborReadByte(reader);
+    }
+
+    return value;
+}
+
+static long cborReadInt(CborReader& reader) {
+    if (cborPeekMajor(reader) == CBOR_MAJOR_NEGATIVE) {
+        return -1 - (long) cborReadHead(reader, CBOR_MAJOR_NEGATIVE);
+    }
+
+    return (long) cborReadHead(reader, CBOR_MAJOR_UNSIGNED);
+}
+
+static void cborReadText(CborReader& reader, char* text) {
+    size_t length = cborReadHead(reader, CBOR_MAJOR_TEXT);
+
+    TEST_ASSERT_TRUE(length < TEST_TEXT_SIZE);
+    TEST_ASSERT_TRUE(reader.position + length <= reader.length);
+
+    memcpy(text, reader.data + reader.position, length);
+    text[length] = '\0';
+    reader.position += length;
+}
+
+static float cborReadFloat(CborReader& reader) {
+    TEST_ASSERT_EQUAL(CBOR_FLOAT32, cborReadByte(reader));
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++) {
+        bits = (bits << 8) | cborReadByte(reader);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+static void serializeReference(JsonDocument& doc) {
+    size_t length = serializeJson(doc, expected, sizeof(expected));
+    expected[length] = '\0';
+}
+
+static JsonObject addReferenceBase(JsonDocument& doc) {
+    JsonObject base = doc.add<JsonObject>();
+    base["bn"] = TEST_BN;
+    base["bt"] = TEST_BT;
+    base["bver"] = TEST_BVER;
+
+    return base;
+}
+
+// The decoded pack back into a document, keys in the order the JSON writer puts them
+static void decodeCborPack(CborReader& reader, JsonDocument& doc) {
+    char name[TEST_TEXT_SIZE];
+    char unit[TEST_TEXT_SIZE];
+
+    unsigned long count = cborReadHead(reader, CBOR_MAJOR_ARRAY);
+    TEST_ASSERT_TRUE(count > 0);
+
+    TEST_ASSERT_EQUAL(3, cborReadHead(reader, CBOR_MAJOR_MAP));
+    JsonObject base = doc.add<JsonObject>();
+    TEST_ASSERT_EQUAL(SENML_CBOR_BN, cborReadInt(reader));
+    cborReadText(reader, name);
+    base["bn"] = name;
+    TEST_ASSERT_EQUAL(SENML_CBOR_BT, cborReadInt(reader));
+    base["bt"] = cborReadHead(reader, CBOR_MAJOR_UNSIGNED);
+    TEST_ASSERT_EQUAL(SENML_CBOR_BVER, cborReadInt(reader));
+    base["bver"] = (double) cborReadHead(reader, CBOR_MAJOR_UNSIGNED);
+
+    for (unsigned long i = 1; i < count; i++) {
+        unsigned long pairs = cborReadHead(reader, CBOR_MAJOR_MAP);
+        bool hasUnit = false;
+        bool timed = false;
+        float value = 0;
+        long time = 0;
+
+        for (unsigned long p = 0; p < pairs; p++) {
+            switch (cborReadInt(reader)) {
+            case SENML_CBOR_N:
+                cborReadText(reader, name);
+                break;
+            case SENML_CBOR_U:
+                cborReadText(reader, unit);
+                hasUnit = true;
+                break;
+            case SENML_CBOR_V:
+                value = cborReadFloat(reader);
+                break;
+            case SENML_CBOR_T:
+                time = cborReadInt(reader);
+                timed = true;
+                break;
+            default:
+                TEST_FAIL_MESSAGE("unexpected SenML label");
+            }
+        }
+
+        JsonObject object = doc.add<JsonObject>();
+        object["n"] = name;
+        object["v"] = (double) value;
+        if (hasUnit) {
+            object["u"] = unit;
+        }
+        if (timed) {
+            object["t"] = time;
+        }
+    }
+
+    TEST_ASSERT_EQUAL(reader.length, reader.position);
+}
+
+static void addReferenceRecord(JsonDocument& doc, const SenMLRecord& record, double value) {
+    JsonObject object = doc.add<JsonObject>();
+    object["n"] = record.name;
+    object["v"] = value;
+
+    if (record.unit != NULL) {
+        object["u"] = record.unit;
+    }
+}
+
+
+// The number after "v": in a pack of one record
+static double readValue(const char* json) {
+    const char* value = strstr(json, "\"v\":");
+
+    TEST_ASSERT_NOT_NULL(value);
+    return strtod(value + 4, NULL);
+}
+
+static double halfUnit(uint8_t decimals) {
+    double half = 0.5;
+    for (uint8_t i = 0; i < decimals; i++) {
+        half /= 10;
+    }
+
+    return half;
+}
+
+static void assertWithinHalfUnit(const SenMLRecord& record, double reading) {
+    JsonDocument doc;
+    addReferenceBase(doc);
+    addReferenceRecord(doc, record, reading);
+    serializeReference(doc);
+
+    TEST_ASSERT_FLOAT_WITHIN(halfUnit(record.decimals) + TEST_PARSE_SLACK, readValue(expected), readValue(actual));
+}
+
+
+void setUp(void) {
+    memset(expected, 0, sizeof(expected));
+    memset(actual, 0, sizeof(actual));
+}
+
+void tearDown(void) {}
+
+
+void test_fixed_records_match_arduinojson(void) {
+    const int32_t values[] = { 21500, 45250, 101325000 };
+    const double readings[] = { 21.5, 45.25, 101325 };
+
+    JsonDocument doc;
+    addReferenceBase(doc);
+    for (size_t i = 0; i < 3; i++) {
+        addReferenceRecord(doc, ENVIRONMENT[i], readings[i]);
+    }
+    serializeReference(doc);
+
+    BufferWriter writer(actual, sizeof(actual) - 1);
+    SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+    pack.begin(TEST_BN, TEST_BT, TEST_BVER, 3);
+    for (size_t i = 0; i < 3; i++) {
+        pack.recordFixed(ENVIRONMENT[i], values[i], 3);
+    }
+    pack.end();
+
+    TEST_ASSERT_FALSE(writer.overflow());
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+void test_float_records_match_arduinojson(void) {
+    const float values[] = { -0.5f, 0.25f, 1.0f };
+
+    JsonDocument doc;
+    addReferenceBase(doc);
+    for (size_t i = 0; i < 3; i++) {
+        addReferenceRecord(doc, ACCELEROMETER[i], values[i]);
+    }
+    serializeReference(doc);
+
+    BufferWriter writer(actual, sizeof(actual) - 1);
+    SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+    pack.begin(TEST_BN, TEST_BT, TEST_BVER, 3);
+    for (size_t i = 0; i < 3; i++) {
+        pack.record(ACCELEROMETER[i], values[i]);
+    }
+    pack.end();
+
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+void test_timed_records_match_arduinojson(void) {
+    JsonDocument doc;
+    addReferenceBase(doc);
+    for (long t = 0; t < 3; t++) {
+        JsonObject object = doc.add<JsonObject>();
+        object["n"] = ENVIRONMENT[0].name;
+        object["v"] = 20.75 + t;
+        object["u"] = ENVIRONMENT[0].unit;
+        object["t"] = -10 * t;
+    }
+    serializeReference(doc);
+
+    BufferWriter writer(actual, sizeof(actual) - 1);
+    SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+    pack.begin(TEST_BN, TEST_BT, TEST_BVER, 3);
+    for (long t = 0; t < 3; t++) {
+        pack.recordFixed(ENVIRONMENT[0], 20750 + 1000 * t, 3, -10 * t);
+    }
+    pack.end();
+
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+// Rounded half away from zero to the record's decimals, trailing zeros dropped
+void test_fixed_values_round_to_record_decimals(void) {
+    const int32_t values[] = { 21375, -1005, 100000 };
+    const char* written[] = { "21.38", "-1.01", "100" };
+
+    for (size_t i = 0; i < 3; i++) {
+        BufferWriter writer(actual, sizeof(actual) - 1);
+        writer.writeScaled(values[i], 3, 2);
+        actual[writer.length()] = '\0';
+
+        TEST_ASSERT_EQUAL_STRING(written[i], actual);
+    }
+}
+
+void test_inexact_values_within_half_a_decimal(void) {
+    for (size_t i = 0; i < sizeof(INEXACT) / sizeof(INEXACT[0]); i++) {
+        BufferWriter writer(actual, sizeof(actual) - 1);
+        SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+        pack.begin(TEST_BN, TEST_BT, TEST_BVER, 1);
+        pack.record(*INEXACT[i].record, INEXACT[i].value);
+        pack.end();
+        actual[writer.length()] = '\0';
+
+        assertWithinHalfUnit(*INEXACT[i].record, INEXACT[i].value);
+    }
+
+    for (size_t i = 0; i < sizeof(INEXACT_FIXED) / sizeof(INEXACT_FIXED[0]); i++) {
+        BufferWriter writer(actual, sizeof(actual) - 1);
+        SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+        pack.begin(TEST_BN, TEST_BT, TEST_BVER, 1);
+        pack.recordFixed(*INEXACT_FIXED[i].record, INEXACT_FIXED[i].value, 3);
+        pack.end();
+        actual[writer.length()] = '\0';
+
+        assertWithinHalfUnit(*INEXACT_FIXED[i].record, INEXACT_FIXED[i].value / 1000.0);
+    }
+}
+
+// Every digit of the widest unsigned long, 20 of them where it is 64 bits wide as on the host
+void test_unsigned_writes_all_digits(void) {
+    char digits[24];
+
+    snprintf(digits, sizeof(digits), "%lu", ULONG_MAX);
+
+    BufferWriter writer(actual, sizeof(actual) - 1);
+    writer.writeUnsigned(ULONG_MAX);
+    writer.writeSigned(LONG_MIN);
+    actual[writer.length()] = '\0';
+
+    snprintf(expected, sizeof(expected), "%s%ld", digits, LONG_MIN);
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+// Every kind of record in one pack, with times and a base time wide enough for the longer heads
+static void writeMixedPack(BufferWriter& writer, SenMLFormat format) {
+    const int32_t values[] = { 21500, 45250, 101325000 };
+
+    SenMLPackWriter pack(writer, format);
+    pack.begin(TEST_BN, TEST_BT, TEST_BVER, 6);
+    for (size_t i = 0; i < 3; i++) {
+        pack.recordFixed(ENVIRONMENT[i], values[i], 3);
+    }
+    pack.record(ACCELEROMETER[0], -0.5f);
+    pack.record(ACCELEROMETER[1], 0.25f, 300);
+    pack.recordFixed(ENVIRONMENT[0], 20750, 3, -1000);
+    pack.end();
+}
+
+// The CBOR pack carries the same names, units, values and times as the JSON one
+void test_cbor_pack_decodes_like_json(void) {
+    BufferWriter jsonWriter(expected, sizeof(expected) - 1);
+    writeMixedPack(jsonWriter, SENML_FORMAT_JSON);
+    TEST_ASSERT_FALSE(jsonWriter.overflow());
+    expected[jsonWriter.length()] = '\0';
+
+    BufferWriter cborWriter((char*) cbor, sizeof(cbor));
+    writeMixedPack(cborWriter, SENML_FORMAT_CBOR);
+    TEST_ASSERT_FALSE(cborWriter.overflow());
+
+    CborReader reader = { cbor, cborWriter.length(), 0 };
+    JsonDocument doc;
+    decodeCborPack(reader, doc);
+
+    size_t length = serializeJson(doc, actual, sizeof(actual));
+    actual[length] = '\0';
+
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+// Environment packs a second from the readings to the bytes, against a document built and
+// serialized by ArduinoJson. The readings change every pack, as they would between refreshes.
+void test_benchmark_pack_throughput(void) {
+    int32_t values[] = { 21375, 45250, 101325000 };
+    const char* labels[] = { "writer JSON", "writer CBOR", "ArduinoJson" };
+    double elapsed[3];
+    size_t bytes = 0;
+
+    for (int run = 0; run < 3; run++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (long i = 0; i < TEST_BENCHMARK_PACKS; i++) {
+            values[0] = 21375 + (int32_t) (i & 0xFF);
+
+            if (run < 2) {
+                bytes += senmlWrite(run == 0 ? SENML_FORMAT_JSON : SENML_FORMAT_CBOR, actual, sizeof(actual),
+                    TEST_BN, TEST_BT, TEST_BVER, ENVIRONMENT, values, 3);
+            } else {
+                JsonDocument doc;
+                addReferenceBase(doc);
+                for (size_t r = 0; r < 3; r++) {
+                    addReferenceRecord(doc, ENVIRONMENT[r], values[r] / 1000.0);
+                }
+                bytes += serializeJson(doc, expected, sizeof(expected));
+            }
+        }
+
+        elapsed[run] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    for (int run = 0; run < 3; run++) {
+        char message[96];
+        snprintf(message, sizeof(message), "%s: %.0f ns per pack, %.0f packs/s",
+            labels[run], elapsed[run] / TEST_BENCHMARK_PACKS, TEST_BENCHMARK_PACKS * 1e9 / elapsed[run]);
+        TEST_MESSAGE(message);
+    }
+
+    TEST_ASSERT_TRUE(bytes > 0);
+}
+
+void test_pack_reports_overflow(void) {
+    BufferWriter writer(actual, 16);
+    SenMLPackWriter pack(writer, SENML_FORMAT_JSON);
+
+    pack.begin(TEST_BN, TEST_BT, TEST_BVER, 1);
+    pack.recordFixed(ENVIRONMENT[0], 21500, 3);
+    pack.end();
+
+    TEST_ASSERT_TRUE(writer.overflow());
+    TEST_ASSERT_EQUAL(16, writer.length());
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_records_match_arduinojson);
+    RUN_TEST(test_float_records_match_arduinojson);
+    RUN_TEST(test_timed_records_match_arduinojson);
+    RUN_TEST(test_fixed_values_round_to_record_decimals);
+    RUN_TEST(test_inexact_values_within_half_a_decimal);
+    RUN_TEST(test_unsigned_writes_all_digits);
+    RUN_TEST(test_cbor_pack_decodes_like_json);
+    RUN_TEST(test_benchmark_pack_throughput);
+    RUN_TEST(test_pack_reports_overflow);
+    return UNITY_END();
+}
@@ -0,0 +1,272 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ArduinoJson.h>
+#include <unity.h>
+
+#include "SenMLCache.h"
+
+
+// A poller hitting one resource many times between two sensor refreshes, answered three ways:
+// a new ArduinoJson document per request as the callbacks used to, a new pack from
+// SenMLPackWriter per request, and the bytes SenMLCache keeps from the first request after each
+// refresh. Heap churn is what goes through operator new and ArduinoJson's allocator.
+
+
+#define TEST_BN "mkriotcarrier:rack:env"
+#define TEST_BVER 1.0
+#define TEST_SCALE 3
+#define TEST_REFRESH_MS 10000UL         // LOOP_CARRIER_UPDATE_MS
+#define TEST_REFRESHES 2000
+#define TEST_REQUESTS_PER_REFRESH 100   // a poller at 10 requests a second
+#define TEST_BUFFER_SIZE 256
+
+
+static const SenMLRecord ENVIRONMENT[] = {
+    { "temperature", "Cel", 2 },
+    { "humidity", "%RH", 2 },
+    { "pressure", "Pa", 0 }
+};
+
+
+// What the encoders read from the carrier: the readings of one sensor group and its generation
+class CarrierManager {
+public:
+    int32_t values[3];
+    unsigned long generation;
+    unsigned long updateMs;
+    unsigned long encodes;
+
+
+    void refresh() {
+        this->values[0] = 21375 + (int32_t) (this->generation % 100);
+        this->values[1] = 45250 - (int32_t) (this->generation % 50);
+        this->values[2] = 101325000 + (int32_t) this->generation;
+        this->generation++;
+        this->updateMs += TEST_REFRESH_MS;
+    }
+};
+
+
+static unsigned long allocations;
+static unsigned long allocatedBytes;
+
+void* operator new(size_t size) {
+    allocations++;
+    allocatedBytes += size;
+
+    void* pointer = malloc(size > 0 ? size : 1);
+    if (pointer == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept {
+    free(pointer);
+}
+
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        allocations++;
+        allocatedBytes += size;
+        return malloc(size);
+    }
+
+    void deallocate(void* pointer) override {
+        free(pointer);
+    }
+
+    void* reallocate(void* pointer, size_t size) override {
+        allocations++;
+        allocatedBytes += size;
+        return realloc(pointer, size);
+    }
+};
+
+
+static CarrierManager carrier;
+static CountingAllocator allocator;
+static char payload[TEST_BUFFER_SIZE];
+static char reference[TEST_BUFFER_SIZE];
+
+
+static size_t writeEnvironment(CarrierManager& carrier, SenMLFormat format, char* buffer, size_t size) {
+    return senmlWrite(format, buffer, size, TEST_BN, carrier.updateMs, TEST_BVER, ENVIRONMENT, carrier.values, TEST_SCALE);
+}
+
+static size_t encodeEnvironment(CarrierManager& carrier, SenMLFormat format, char* buffer, size_t size) {
+    carrier.encodes++;
+    return writeEnvironment(carrier, format, buffer, size);
+}
+
+// Nothing fits, as when a pack outgrows its buffer
+static size_t encodeTooLarge(CarrierManager& carrier, SenMLFormat format, char* buffer, size_t size) {
+    carrier.encodes++;
+    return 0;
+}
+
+static size_t encodeWithArduinoJson(CarrierManager& carrier, char* buffer, size_t size) {
+    JsonDocument doc(&allocator);
+
+    JsonObject base = doc.add<JsonObject>();
+    base["bn"] = TEST_BN;
+    base["bt"] = carrier.updateMs;
+    base["bver"] = TEST_BVER;
+
+    for (size_t i = 0; i < 3; i++) {
+        JsonObject object = doc.add<JsonObject>();
+        object["n"] = ENVIRONMENT[i].name;
+        object["v"] = carrier.values[i] / 1000.0;
+        object["u"] = ENVIRONMENT[i].unit;
+    }
+
+    return serializeJson(doc, buffer, size);
+}
+
+
+enum Path {
+    PATH_ARDUINOJSON,
+    PATH_WRITER,
+    PATH_CACHE,
+    PATH_COUNT
+};
+
+struct PathResult {
+    double nanoseconds;
+    unsigned long allocations;
+    unsigned long allocatedBytes;
+};
+
+// Mean cost of one request over every refresh, the refreshes themselves included
+static PathResult pollThrough(Path path, SenMLCache& cache) {
+    size_t bytes = 0;
+
+    allocations = 0;
+    allocatedBytes = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (long refresh = 0; refresh < TEST_REFRESHES; refresh++) {
+        carrier.refresh();
+
+        for (int request = 0; request < TEST_REQUESTS_PER_REFRESH; request++) {
+            size_t length;
+
+            if (path == PATH_ARDUINOJSON) {
+                length = encodeWithArduinoJson(carrier, payload, sizeof(payload));
+            } else if (path == PATH_WRITER) {
+                length = encodeEnvironment(carrier, SENML_FORMAT_JSON, payload, sizeof(payload));
+            } else {
+                TEST_ASSERT_NOT_NULL(cache.get(carrier, carrier.generation, SENML_FORMAT_JSON, length));
+            }
+
+            bytes += length;
+        }
+    }
+
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    PathResult result = { elapsed, allocations, allocatedBytes };
+
+    TEST_ASSERT_TRUE(bytes > 0);
+    return result;
+}
+
+
+void setUp(void) {
+    carrier = CarrierManager();
+    carrier.refresh();
+}
+
+void tearDown(void) {}
+
+
+// One encode per format and refresh, and the bytes served are those a new encode would give
+void test_cache_encodes_once_per_refresh(void) {
+    SenMLCache cache(encodeEnvironment);
+    const SenMLFormat formats[] = { SENML_FORMAT_JSON, SENML_FORMAT_CBOR };
+
+    for (int refresh = 0; refresh < 5; refresh++) {
+        unsigned long encodes = carrier.encodes;
+
+        for (int request = 0; request < 10; request++) {
+            for (size_t f = 0; f < 2; f++) {
+                size_t length;
+                const char* bytes = cache.get(carrier, carrier.generation, formats[f], length);
+
+                size_t expected = writeEnvironment(carrier, formats[f], reference, sizeof(reference));
+
+                TEST_ASSERT_NOT_NULL(bytes);
+                TEST_ASSERT_EQUAL(expected, length);
+                TEST_ASSERT_EQUAL_MEMORY(reference, bytes, length);
+            }
+        }
+
+        TEST_ASSERT_EQUAL(2, carrier.encodes - encodes);
+        carrier.refresh();
+    }
+}
+
+// A pack that does not fit is retried and counted once per refresh, not once per request
+void test_failure_counted_once_per_refresh(void) {
+    SenMLCache cache(encodeTooLarge);
+    unsigned long failures = SenMLCache::getFailures();
+
+    for (int refresh = 0; refresh < 3; refresh++) {
+        for (int request = 0; request < 10; request++) {
+            size_t length;
+            TEST_ASSERT_NULL(cache.get(carrier, carrier.generation, SENML_FORMAT_JSON, length));
+        }
+
+        carrier.refresh();
+    }
+
+    TEST_ASSERT_EQUAL(3, carrier.encodes);
+    TEST_ASSERT_EQUAL(3, SenMLCache::getFailures() - failures);
+}
+
+// Per-request latency and heap churn of each path. Only the cache encodes once per refresh,
+// and neither the writer nor the cache touches the heap.
+void test_benchmark_cached_requests(void) {
+    const char* labels[PATH_COUNT] = { "ArduinoJson", "writer", "cache" };
+    const long requests = (long) TEST_REFRESHES * TEST_REQUESTS_PER_REFRESH;
+    PathResult results[PATH_COUNT];
+
+    for (int path = 0; path < PATH_COUNT; path++) {
+        SenMLCache cache(encodeEnvironment);
+
+        carrier.encodes = 0;
+        results[path] = pollThrough((Path) path, cache);
+
+        if (path == PATH_CACHE) {
+            TEST_ASSERT_EQUAL(TEST_REFRESHES, carrier.encodes);
+        }
+    }
+
+    for (int path = 0; path < PATH_COUNT; path++) {
+        char message[128];
+        snprintf(message, sizeof(message), "%s: %.0f ns, %.2f allocations, %.0f heap bytes per request",
+            labels[path], results[path].nanoseconds / requests,
+            (double) results[path].allocations / requests, (double) results[path].allocatedBytes / requests);
+        TEST_MESSAGE(message);
+    }
+
+    TEST_ASSERT_EQUAL(0, results[PATH_WRITER].allocations);
+    TEST_ASSERT_EQUAL(0, results[PATH_CACHE].allocations);
+    TEST_ASSERT_TRUE(results[PATH_CACHE].nanoseconds < results[PATH_WRITER].nanoseconds);
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_cache_encodes_once_per_refresh);
+    RUN_TEST(test_failure_counted_once_per_refresh);
+    RUN_TEST(test_benchmark_cached_requests);
+    return UNITY_END();
+}
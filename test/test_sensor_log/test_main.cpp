@@ -0,0 +1,246 @@
+#include <new>
+#include <unity.h>
+
+#include "SensorLog.h"
+
+
+// The ring on a RAM block device that can tear a write short, as a reset in the middle of an
+// SD card write would. Every record carries its append number in its first channel.
+
+
+#define TEST_BLOCKS_MAX 256
+#define TEST_SMALL_RING_BLOCKS 8
+
+
+class RamBlockDevice : public BlockDevice {
+public:
+    uint8_t data[TEST_BLOCKS_MAX][BLOCK_DEVICE_BLOCK_SIZE];
+    uint32_t blockCount;
+    unsigned long reads;
+    size_t tearAt;                          // bytes of the next write that reach the device, 0 for all
+
+
+    bool begin() override {
+        return true;
+    }
+
+    uint32_t getBlockCount() override {
+        return this->blockCount;
+    }
+
+    bool read(uint32_t block, size_t offset, void* data, size_t length) override {
+        if (block >= this->blockCount || offset + length > BLOCK_DEVICE_BLOCK_SIZE) {
+            return false;
+        }
+
+        memcpy(data, this->data[block] + offset, length);
+        this->reads++;
+        return true;
+    }
+
+    bool write(uint32_t block, const void* data) override {
+        if (block >= this->blockCount) {
+            return false;
+        }
+
+        memcpy(this->data[block], data, this->tearAt > 0 ? this->tearAt : BLOCK_DEVICE_BLOCK_SIZE);
+        this->tearAt = 0;
+        return true;
+    }
+};
+
+
+static RamBlockDevice device;
+static SensorLog* sensorLog;
+static int32_t appended;
+
+
+// A new SensorLog on the same device, as after a reset
+static void mount() {
+    static uint8_t storage[sizeof(SensorLog)];
+
+    sensorLog = new (storage) SensorLog(device);
+    TEST_ASSERT_TRUE(sensorLog->begin(millis()));
+}
+
+// One record a second, written through as the firmware does once a block is full or due
+static void append(int32_t count, bool flush) {
+    SensorSnapshot snapshot = {};
+
+    for (int32_t i = 0; i < count; i++) {
+        nativeMillis() += 1000;
+        snapshot.channels[0] = appended;
+
+        TEST_ASSERT_TRUE(sensorLog->append(snapshot, millis()));
+        appended++;
+
+        if (flush || sensorLog->isFlushDue(millis(), 0xFFFFFFFFUL)) {
+            TEST_ASSERT_TRUE(sensorLog->flush());
+        }
+    }
+}
+
+// Reads from the cursor to the end and checks the records are consecutive from first
+static int32_t readFrom(SensorLog::Cursor& cursor, int32_t first) {
+    SensorLogRecord record;
+    int32_t expected = first;
+
+    while (sensorLog->next(cursor, record)) {
+        TEST_ASSERT_EQUAL(expected, record.channels[0]);
+        expected++;
+    }
+
+    return expected - first;
+}
+
+// First record of the oldest block kept: every block but the newest is full
+static int32_t oldestRecord() {
+    int32_t blocks = appended / SENSOR_LOG_BLOCK_RECORDS - (appended % SENSOR_LOG_BLOCK_RECORDS == 0 ? 1 : 0);
+    int32_t dropped = blocks - (int32_t) (device.blockCount - 1);
+
+    return dropped > 0 ? dropped * SENSOR_LOG_BLOCK_RECORDS : 0;
+}
+
+
+void setUp(void) {
+    memset(device.data, 0, sizeof(device.data));
+    device.blockCount = TEST_SMALL_RING_BLOCKS;
+    device.reads = 0;
+    device.tearAt = 0;
+
+    appended = 0;
+    nativeMillis() = 5000;
+    mount();
+}
+
+void tearDown(void) {}
+
+
+// A reset in the middle of the last write keeps the records before the tear, and the next
+// flush replaces the torn ones
+void test_torn_last_block_resumes_after_last_valid_record(void) {
+    append(5, true);
+    append(3, false);
+
+    // Header and six records reach the card, the seventh is cut short
+    device.tearAt = 16 + 6 * sizeof(SensorLogRecord) + sizeof(SensorLogRecord) / 2;
+    TEST_ASSERT_TRUE(sensorLog->flush());
+
+    mount();
+    TEST_ASSERT_EQUAL(6, sensorLog->size());
+
+    SensorLog::Cursor cursor;
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_EQUAL(6, readFrom(cursor, 0));
+
+    appended = 6;
+    append(1, true);
+
+    mount();
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_EQUAL(7, readFrom(cursor, 0));
+}
+
+// Past capacity the oldest block goes, reading starts from the oldest one kept, and a remount
+// finds the newest block again
+void test_ring_wrap_keeps_newest_blocks(void) {
+    append(3 * TEST_SMALL_RING_BLOCKS * SENSOR_LOG_BLOCK_RECORDS + 4, false);
+    TEST_ASSERT_TRUE(sensorLog->flush());
+
+    uint32_t size = (TEST_SMALL_RING_BLOCKS - 1) * SENSOR_LOG_BLOCK_RECORDS + 4;
+    TEST_ASSERT_EQUAL(size, sensorLog->size());
+    TEST_ASSERT_EQUAL(TEST_SMALL_RING_BLOCKS * SENSOR_LOG_BLOCK_RECORDS, sensorLog->capacity());
+
+    SensorLog::Cursor cursor;
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_EQUAL(size, readFrom(cursor, oldestRecord()));
+
+    mount();
+    TEST_ASSERT_EQUAL(size, sensorLog->size());
+
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_EQUAL(size, readFrom(cursor, oldestRecord()));
+
+    append(SENSOR_LOG_BLOCK_RECORDS, false);
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_EQUAL(size, readFrom(cursor, oldestRecord()));
+}
+
+// On a device larger than the index, a seek reads at most one stride of headers past the
+// sampled block and lands on the block holding the time asked for
+void test_seek_reads_at_most_a_stride_past_the_index(void) {
+    device.blockCount = TEST_BLOCKS_MAX;
+    mount();
+
+    const uint32_t stride = TEST_BLOCKS_MAX / SENSOR_LOG_INDEX_SIZE;
+    append(100 * SENSOR_LOG_BLOCK_RECORDS + 5, false);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t time = 1; time <= (uint32_t) appended; time += 37) {
+            SensorLog::Cursor cursor;
+            SensorLogRecord record;
+
+            unsigned long reads = device.reads;
+            sensorLog->seek(cursor, time);
+            TEST_ASSERT_LESS_OR_EQUAL(stride, device.reads - reads);
+
+            // The block starts at or before the time, and the record for it is within the block
+            uint32_t skipped = 0;
+            while (sensorLog->next(cursor, record) && record.time < time) {
+                skipped++;
+            }
+
+            TEST_ASSERT_LESS_THAN(SENSOR_LOG_BLOCK_RECORDS, skipped);
+            TEST_ASSERT_EQUAL(time, record.time);
+            TEST_ASSERT_EQUAL(time - 1, record.channels[0]);
+        }
+
+        // Again with the index rebuilt from the device
+        TEST_ASSERT_TRUE(sensorLog->flush());
+        mount();
+    }
+}
+
+// A reader left behind by a whole lap of the ring carries on from the oldest block still there,
+// without first reading through the blocks it lost
+void test_next_after_writer_overtakes_cursor(void) {
+    append(2 * SENSOR_LOG_BLOCK_RECORDS, false);
+
+    SensorLog::Cursor cursor;
+    SensorLogRecord record;
+    sensorLog->seek(cursor, 0);
+
+    for (int32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(sensorLog->next(cursor, record));
+        TEST_ASSERT_EQUAL(i, record.channels[0]);
+    }
+
+    append(TEST_SMALL_RING_BLOCKS * SENSOR_LOG_BLOCK_RECORDS, false);
+
+    unsigned long reads = device.reads;
+    TEST_ASSERT_TRUE(sensorLog->next(cursor, record));
+    TEST_ASSERT_EQUAL(1, device.reads - reads);
+    TEST_ASSERT_EQUAL(oldestRecord(), record.channels[0]);
+
+    TEST_ASSERT_EQUAL(sensorLog->size() - 1, readFrom(cursor, oldestRecord() + 1));
+}
+
+void test_empty_log_reads_nothing(void) {
+    SensorLog::Cursor cursor;
+    SensorLogRecord record;
+
+    sensorLog->seek(cursor, 0);
+    TEST_ASSERT_FALSE(sensorLog->next(cursor, record));
+    TEST_ASSERT_EQUAL(0, sensorLog->size());
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_torn_last_block_resumes_after_last_valid_record);
+    RUN_TEST(test_ring_wrap_keeps_newest_blocks);
+    RUN_TEST(test_seek_reads_at_most_a_stride_past_the_index);
+    RUN_TEST(test_next_after_writer_overtakes_cursor);
+    RUN_TEST(test_empty_log_reads_nothing);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+#include <limits.h>
+#include <unity.h>
+
+#include "SensorScheduler.h"
+
+
+// sensorsLoop() against a fake clock: next() once per pass, the read times compared with
+// the grid of each group's period
+
+
+#define TEST_DURATION_MS 10000
+
+
+static SensorScheduler scheduler;
+
+static unsigned long reads[SENSOR_GROUP_COUNT];
+static unsigned long maxJitter[SENSOR_GROUP_COUNT];
+
+
+// Calls next() every pollMs from start for durationMs, the way task_sensors does
+static void runFor(unsigned long start, unsigned long durationMs, unsigned long pollMs) {
+    nativeMillis() = start;
+    scheduler.start(millis());
+
+    for (unsigned long elapsed = 0; elapsed < durationMs; elapsed += pollMs) {
+        nativeMillis() = start + elapsed;
+
+        int group = scheduler.next(millis());
+        if (group < 0) {
+            continue;
+        }
+
+        unsigned long period = scheduler.getPeriod(group);
+        unsigned long jitter = elapsed % period;
+
+        reads[group]++;
+        if (jitter > maxJitter[group]) {
+            maxJitter[group] = jitter;
+        }
+    }
+}
+
+
+void setUp(void) {
+    scheduler = SensorScheduler();
+
+    memset(reads, 0, sizeof(reads));
+    memset(maxJitter, 0, sizeof(maxJitter));
+}
+
+void tearDown(void) {}
+
+
+// One group per pass: a read waits at most one pass for every other group due with it
+void test_jitter_is_bounded_by_groups_due_together(void) {
+    const unsigned long periods[] = { 1000, 100, 250, 50, 500 };
+    const int groups = sizeof(periods) / sizeof(periods[0]);
+
+    for (int group = 0; group < groups; group++) {
+        scheduler.setPeriod(group, periods[group]);
+    }
+
+    runFor(1000, TEST_DURATION_MS, 1);
+
+    for (int group = 0; group < groups; group++) {
+        TEST_ASSERT_LESS_OR_EQUAL(groups - 1, maxJitter[group]);
+        TEST_ASSERT_EQUAL(TEST_DURATION_MS / periods[group] - 1, reads[group]);
+    }
+}
+
+// Reads are late by less than one pass, or two when both groups fall due in the same one,
+// and no group drifts off its grid
+void test_jitter_is_bounded_by_poll_interval(void) {
+    const unsigned long pollMs = 7;
+
+    scheduler.setPeriod(SENSOR_GROUP_ENVIRONMENT, 1000);
+    scheduler.setPeriod(SENSOR_GROUP_ACCELEROMETER, 100);
+
+    runFor(1000, TEST_DURATION_MS, pollMs);
+
+    TEST_ASSERT_LESS_THAN(pollMs, maxJitter[SENSOR_GROUP_ENVIRONMENT]);
+    TEST_ASSERT_LESS_THAN(pollMs * 2, maxJitter[SENSOR_GROUP_ACCELEROMETER]);
+    TEST_ASSERT_INT_WITHIN(1, TEST_DURATION_MS / 1000 - 1, reads[SENSOR_GROUP_ENVIRONMENT]);
+    TEST_ASSERT_INT_WITHIN(1, TEST_DURATION_MS / 100 - 1, reads[SENSOR_GROUP_ACCELEROMETER]);
+}
+
+// The same bound across the millis() wrap after ~49 days
+void test_jitter_holds_across_millis_wrap(void) {
+    scheduler.setPeriod(SENSOR_GROUP_PRESSURE, 250);
+    scheduler.setPeriod(SENSOR_GROUP_GYROSCOPE, 100);
+
+    runFor(ULONG_MAX - TEST_DURATION_MS / 2, TEST_DURATION_MS, 1);
+
+    TEST_ASSERT_LESS_OR_EQUAL(1, maxJitter[SENSOR_GROUP_PRESSURE]);
+    TEST_ASSERT_LESS_OR_EQUAL(1, maxJitter[SENSOR_GROUP_GYROSCOPE]);
+    TEST_ASSERT_EQUAL(TEST_DURATION_MS / 250 - 1, reads[SENSOR_GROUP_PRESSURE]);
+    TEST_ASSERT_EQUAL(TEST_DURATION_MS / 100 - 1, reads[SENSOR_GROUP_GYROSCOPE]);
+}
+
+// A whole missed period restarts the group from now instead of a burst of catch-up reads
+void test_missed_period_restarts_from_now(void) {
+    scheduler.setPeriod(SENSOR_GROUP_RGB, 100);
+    scheduler.start(0);
+
+    TEST_ASSERT_EQUAL(SENSOR_GROUP_RGB, scheduler.next(350));
+    TEST_ASSERT_EQUAL(-1, scheduler.next(351));
+    TEST_ASSERT_EQUAL(99, scheduler.timeUntil(SENSOR_GROUP_RGB, 351));
+    TEST_ASSERT_EQUAL(SENSOR_GROUP_RGB, scheduler.next(450));
+}
+
+void test_disabled_group_is_never_due(void) {
+    scheduler.setPeriod(SENSOR_GROUP_ENVIRONMENT, 100);
+
+    runFor(0, TEST_DURATION_MS, 1);
+
+    for (int group = 0; group < SENSOR_GROUP_COUNT; group++) {
+        if (group != SENSOR_GROUP_ENVIRONMENT) {
+            TEST_ASSERT_EQUAL(0, reads[group]);
+        }
+    }
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_jitter_is_bounded_by_groups_due_together);
+    RUN_TEST(test_jitter_is_bounded_by_poll_interval);
+    RUN_TEST(test_jitter_holds_across_millis_wrap);
+    RUN_TEST(test_missed_period_restarts_from_now);
+    RUN_TEST(test_disabled_group_is_never_due);
+    return UNITY_END();
+}
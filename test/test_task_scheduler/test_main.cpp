@@ -0,0 +1,237 @@
+#include <unity.h>
+
+#include "TaskScheduler.h"
+
+
+// The loop of main.cpp against the clock of test/native/Arduino.h: run() on every pass,
+// the clock moved by the test or by the tasks themselves to stand for their run time
+
+
+#define TEST_TASKS 3
+#define TEST_DURATION_MS 2000
+
+
+static TaskScheduler scheduler;
+
+static unsigned long periods[TEST_TASKS];
+static unsigned long durations[TEST_TASKS];
+static unsigned long deadlines[TEST_TASKS];
+static unsigned long runs[TEST_TASKS];
+static unsigned long maxLateness[TEST_TASKS];
+
+static int order[TEST_TASKS * 4];
+static size_t orderLength;
+
+
+static void runTask(int task) {
+    unsigned long lateness = millis() - deadlines[task];
+
+    if (lateness > maxLateness[task]) {
+        maxLateness[task] = lateness;
+    }
+
+    deadlines[task] += periods[task];
+    runs[task]++;
+
+    if (orderLength < sizeof(order) / sizeof(order[0])) {
+        order[orderLength++] = task;
+    }
+
+    nativeMillis() += durations[task];
+}
+
+static void runTask0() {
+    runTask(0);
+}
+
+static void runTask1() {
+    runTask(1);
+}
+
+static void runTask2() {
+    runTask(2);
+}
+
+static const TaskScheduler::TaskFunction FUNCTIONS[TEST_TASKS] = { runTask0, runTask1, runTask2 };
+
+static void addTask(int task, unsigned long period, unsigned long duration, uint8_t priority) {
+    periods[task] = period;
+    durations[task] = duration;
+    deadlines[task] = millis();
+
+    TEST_ASSERT_EQUAL(task, scheduler.add("test", FUNCTIONS[task], period, priority));
+}
+
+// Calls run() every pollMs until the clock reaches end, the way loop() does between idle() wake-ups
+static void runUntil(unsigned long end, unsigned long pollMs) {
+    scheduler.start(millis());
+
+    while ((long) (millis() - end) < 0) {
+        if (!scheduler.run(millis())) {
+            nativeMillis() += pollMs;
+        }
+    }
+}
+
+
+void setUp(void) {
+    scheduler = TaskScheduler();
+    nativeMillis() = 1000;
+
+    memset(runs, 0, sizeof(runs));
+    memset(maxLateness, 0, sizeof(maxLateness));
+    orderLength = 0;
+}
+
+void tearDown(void) {}
+
+
+// Periods below, at and past one wheel revolution all run on their deadline
+void test_tasks_run_on_their_deadline(void) {
+    addTask(0, 10, 0, 0);
+    addTask(1, 25, 0, 1);
+    addTask(2, 3 * TASK_WHEEL_SLOTS * TASK_WHEEL_TICK_MS + 7, 0, 2);
+
+    runUntil(millis() + TEST_DURATION_MS, 1);
+
+    for (int task = 0; task < TEST_TASKS; task++) {
+        TEST_ASSERT_EQUAL(0, maxLateness[task]);
+        TEST_ASSERT_EQUAL((TEST_DURATION_MS - 1) / periods[task] + 1, runs[task]);
+        TEST_ASSERT_EQUAL(0, scheduler.get(task).overruns);
+    }
+}
+
+// A task waits at most for the run time of the tasks due in the same pass ahead of it
+void test_lateness_is_bounded_by_higher_priority_run_time(void) {
+    addTask(0, 20, 4, 0);
+    addTask(1, 10, 1, 1);
+    addTask(2, 50, 0, 2);
+
+    runUntil(millis() + TEST_DURATION_MS, 1);
+
+    TEST_ASSERT_EQUAL(0, maxLateness[0]);
+    TEST_ASSERT_LESS_OR_EQUAL(durations[0], maxLateness[1]);
+    TEST_ASSERT_LESS_OR_EQUAL(durations[0] + durations[1], maxLateness[2]);
+    TEST_ASSERT_EQUAL(durations[0] * 1000, scheduler.get(0).maxRunUs);
+
+    for (int task = 0; task < TEST_TASKS; task++) {
+        TEST_ASSERT_EQUAL(0, scheduler.get(task).overruns);
+    }
+}
+
+// Passes further apart than a wheel tick delay a task by less than one gap, and the
+// deadlines stay on their grid instead of drifting by the delay
+void test_sparse_passes_keep_the_deadline_grid(void) {
+    const unsigned long pollMs = TASK_WHEEL_TICK_MS + 2;
+
+    addTask(0, 10, 0, 0);
+    addTask(1, 100, 0, 1);
+
+    runUntil(millis() + TEST_DURATION_MS, pollMs);
+
+    for (int task = 0; task < 2; task++) {
+        TEST_ASSERT_LESS_THAN(pollMs, maxLateness[task]);
+        TEST_ASSERT_INT_WITHIN(1, TEST_DURATION_MS / periods[task], runs[task]);
+        TEST_ASSERT_EQUAL(0, scheduler.get(task).overruns);
+    }
+}
+
+// A run longer than the period skips the missed activations instead of running them back to back
+void test_overrun_restarts_from_now(void) {
+    addTask(0, 10, 25, 0);
+
+    scheduler.start(millis());
+    TEST_ASSERT_TRUE(scheduler.run(millis()));
+
+    TEST_ASSERT_EQUAL(1, scheduler.get(0).overruns);
+    TEST_ASSERT_FALSE(scheduler.run(millis()));
+    TEST_ASSERT_FALSE(scheduler.run(millis() + 9));
+    TEST_ASSERT_TRUE(scheduler.run(millis() + 10));
+}
+
+// Due tasks run by priority, whatever their order in the table or in the wheel
+void test_due_tasks_run_by_priority(void) {
+    addTask(0, 30, 0, 2);
+    addTask(1, 20, 0, 0);
+    addTask(2, 60, 0, 1);
+
+    scheduler.start(millis());
+    TEST_ASSERT_TRUE(scheduler.run(millis()));
+
+    TEST_ASSERT_EQUAL(3, orderLength);
+    TEST_ASSERT_EQUAL(1, order[0]);
+    TEST_ASSERT_EQUAL(2, order[1]);
+    TEST_ASSERT_EQUAL(0, order[2]);
+
+    // 60 ms later all three are due again and the order holds
+    orderLength = 0;
+    nativeMillis() += 60;
+    TEST_ASSERT_TRUE(scheduler.run(millis()));
+
+    TEST_ASSERT_EQUAL(3, orderLength);
+    TEST_ASSERT_EQUAL(1, order[0]);
+    TEST_ASSERT_EQUAL(2, order[1]);
+    TEST_ASSERT_EQUAL(0, order[2]);
+}
+
+// A deadline one revolution away shares its slot with an earlier one, and waits for its lap
+void test_later_lap_waits_in_shared_slot(void) {
+    const unsigned long revolution = TASK_WHEEL_SLOTS * TASK_WHEEL_TICK_MS;
+
+    addTask(0, TASK_WHEEL_TICK_MS, 0, 0);
+    addTask(1, revolution + TASK_WHEEL_TICK_MS, 0, 1);
+
+    scheduler.start(millis());
+    unsigned long start = millis();
+
+    for (unsigned long now = start; now - start < 2 * revolution; now++) {
+        nativeMillis() = now;
+        scheduler.run(now);
+
+        TEST_ASSERT_EQUAL(now - start < revolution + TASK_WHEEL_TICK_MS ? 1 : 2, runs[1]);
+    }
+
+    TEST_ASSERT_EQUAL(0, maxLateness[0]);
+    TEST_ASSERT_EQUAL(0, maxLateness[1]);
+}
+
+// After a stall longer than a revolution every slot is walked once, each task runs
+// once and restarts its period from then
+void test_stall_past_a_revolution_runs_each_task_once(void) {
+    const unsigned long revolution = TASK_WHEEL_SLOTS * TASK_WHEEL_TICK_MS;
+
+    addTask(0, 10, 0, 0);
+    addTask(1, 35, 0, 1);
+    addTask(2, revolution + 15, 0, 2);
+
+    scheduler.start(millis());
+    TEST_ASSERT_TRUE(scheduler.run(millis()));
+
+    orderLength = 0;
+    nativeMillis() += revolution * 3;
+    TEST_ASSERT_TRUE(scheduler.run(millis()));
+
+    TEST_ASSERT_EQUAL(3, orderLength);
+    TEST_ASSERT_EQUAL(0, order[0]);
+    TEST_ASSERT_EQUAL(1, order[1]);
+    TEST_ASSERT_EQUAL(2, order[2]);
+    for (int task = 0; task < TEST_TASKS; task++) {
+        TEST_ASSERT_EQUAL(1, scheduler.get(task).overruns);
+    }
+
+    TEST_ASSERT_FALSE(scheduler.run(millis() + 9));
+    TEST_ASSERT_TRUE(scheduler.run(millis() + 10));
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tasks_run_on_their_deadline);
+    RUN_TEST(test_lateness_is_bounded_by_higher_priority_run_time);
+    RUN_TEST(test_sparse_passes_keep_the_deadline_grid);
+    RUN_TEST(test_overrun_restarts_from_now);
+    RUN_TEST(test_due_tasks_run_by_priority);
+    RUN_TEST(test_later_lap_waits_in_shared_slot);
+    RUN_TEST(test_stall_past_a_revolution_runs_each_task_once);
+    return UNITY_END();
+}
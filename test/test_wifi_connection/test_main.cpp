@@ -0,0 +1,161 @@
+#include <cstdio>
+#include <new>
+#include <unity.h>
+
+#include "WiFiConnection.h"
+
+
+// A reconnect storm against the fake NINA in test/native, with loop() called every few
+// milliseconds as the sketch does. WiFiConnection never waits: what it adds to an iteration of
+// the loop is the SPI round trips it makes there.
+
+
+#define TEST_LOOP_MS 5
+#define TEST_JOIN_MS 3000
+#define TEST_FLAP_MS 20000UL            // the access point drops and comes back this often
+#define TEST_STORM_MS 600000UL
+#define TEST_OUTAGE_MS 600000UL         // long enough for the backoff to reach its cap
+#define TEST_SPI_CALLS_PER_LOOP_MAX 2   // a status poll, and the local IP read or the disconnect it leads to
+
+
+static WiFiConnection* connection;
+static unsigned long worstCalls;
+static unsigned long connects;
+
+
+// One iteration of the sketch's loop
+static void step() {
+    nativeMillis() += TEST_LOOP_MS;
+
+    unsigned long calls = nativeNina().spiCalls;
+    bool wasConnected = connection->connected();
+
+    connection->loop(millis());
+
+    calls = nativeNina().spiCalls - calls;
+    worstCalls = calls > worstCalls ? calls : worstCalls;
+
+    if (connection->connected() && !wasConnected) {
+        connects++;
+    }
+}
+
+static void run(unsigned long ms) {
+    unsigned long start = millis();
+
+    while (millis() - start < ms) {
+        step();
+    }
+}
+
+// Loops until the link is up, returns how long that took
+static unsigned long runUntilConnected(unsigned long limitMs) {
+    unsigned long start = millis();
+
+    while (!connection->connected() && millis() - start < limitMs) {
+        step();
+    }
+
+    TEST_ASSERT_TRUE(connection->connected());
+    return millis() - start;
+}
+
+
+void setUp(void) {
+    static uint8_t storage[sizeof(WiFiConnection)];
+
+    NativeNina& nina = nativeNina();
+    nina = NativeNina();
+    nina.accessPoint = true;
+    nina.joinMs = TEST_JOIN_MS;
+
+    nativeMillis() = 1000;
+    worstCalls = 0;
+    connects = 0;
+    srand(1);
+
+    connection = new (storage) WiFiConnection("rack", "secret");
+    connection->begin(millis());
+}
+
+void tearDown(void) {}
+
+
+// Ten minutes of the access point dropping every 20 s: every iteration stays within two SPI
+// round trips, the status is polled at most once per WIFI_STATUS_POLL_MS, and the link comes
+// back in every period the access point is up
+void test_reconnect_storm_loop_latency(void) {
+    unsigned long flaps = TEST_STORM_MS / TEST_FLAP_MS;
+    unsigned long start = nativeNina().spiCalls;
+
+    for (unsigned long flap = 0; flap < flaps; flap++) {
+        nativeNina().accessPoint = (flap % 2 == 0);
+        run(TEST_FLAP_MS);
+    }
+
+    unsigned long calls = nativeNina().spiCalls - start;
+    unsigned long joins = nativeNina().joins;
+
+    char message[128];
+    snprintf(message, sizeof(message),
+        "worst loop: %lu SPI calls, %lu us; %.2f SPI calls/s; %lu joins, %lu connects",
+        worstCalls, worstCalls * NATIVE_NINA_SPI_US, calls * 1000.0 / TEST_STORM_MS, joins, connects);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_SPI_CALLS_PER_LOOP_MAX, worstCalls);
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_STORM_MS / WIFI_STATUS_POLL_MS + 2 * joins, calls);
+    TEST_ASSERT_EQUAL(flaps / 2, connects);
+}
+
+// With the access point gone, each attempt is followed by a wait of the current backoff plus
+// up to a quarter of it, doubling until WIFI_BACKOFF_MAX_MS
+void test_backoff_doubles_up_to_max(void) {
+    nativeNina().accessPoint = false;
+    unsigned long backoff = WIFI_BACKOFF_MIN_MS;
+
+    for (int attempt = 0; attempt < 10; attempt++) {
+        unsigned long joins = nativeNina().joins;
+
+        while (nativeNina().joins == joins) {
+            step();
+        }
+
+        unsigned long wait = nativeNina().lastJoinMs - nativeNina().lastDisconnectMs;
+        TEST_ASSERT_GREATER_OR_EQUAL(backoff, wait);
+        TEST_ASSERT_LESS_OR_EQUAL(backoff + backoff / 4 + TEST_LOOP_MS, wait);
+
+        backoff = (backoff * 2 < WIFI_BACKOFF_MAX_MS ? backoff * 2 : WIFI_BACKOFF_MAX_MS);
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_SPI_CALLS_PER_LOOP_MAX, worstCalls);
+}
+
+// After a long outage the link is back within one capped backoff, and the next drop is retried
+// from WIFI_BACKOFF_MIN_MS again
+void test_recovers_after_outage(void) {
+    const unsigned long attemptMs = TEST_JOIN_MS + WIFI_STATUS_POLL_MS + 2 * TEST_LOOP_MS;
+
+    nativeNina().accessPoint = false;
+    run(TEST_OUTAGE_MS);
+
+    nativeNina().accessPoint = true;
+    TEST_ASSERT_LESS_OR_EQUAL(WIFI_BACKOFF_MAX_MS + WIFI_BACKOFF_MAX_MS / 4 + attemptMs,
+        runUntilConnected(2 * WIFI_BACKOFF_MAX_MS));
+
+    nativeNina().accessPoint = false;
+    run(WIFI_STATUS_POLL_MS + TEST_LOOP_MS);
+    nativeNina().accessPoint = true;
+
+    TEST_ASSERT_LESS_OR_EQUAL(WIFI_BACKOFF_MIN_MS + WIFI_BACKOFF_MIN_MS / 4 + attemptMs,
+        runUntilConnected(WIFI_BACKOFF_MAX_MS));
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_SPI_CALLS_PER_LOOP_MAX, worstCalls);
+}
+
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reconnect_storm_loop_latency);
+    RUN_TEST(test_backoff_doubles_up_to_max);
+    RUN_TEST(test_recovers_after_outage);
+    return UNITY_END();
+}
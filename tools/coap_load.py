@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Offers CoAP GET load to the board at increasing request rates.
+
+Each collector is its own UDP socket, so the requests arrive from several
+endpoints as they do from a fleet of pollers. Requests are confirmable, are
+never retransmitted, and carry a fresh message ID. A request counts as
+dropped when no response arrives within the timeout. Run against the board
+address shown on the display:
+
+    python3 tools/coap_load.py 192.168.1.42 --rates 10 20 50 100 200
+
+For each rate it prints the achieved throughput, the drop rate and the
+response latency percentiles.
+"""
+
+import argparse
+import os
+import select
+import socket
+import struct
+import time
+
+COAP_PORT = 5683
+COAP_VERSION = 1
+COAP_CON = 0
+COAP_GET = 1
+COAP_OPTION_URI_PATH = 11
+
+
+def encode_get(message_id, token, path):
+    header = struct.pack("!BBH", (COAP_VERSION << 6) | (COAP_CON << 4) | len(token), COAP_GET, message_id)
+    options = b""
+    last = 0
+    for segment in path.strip("/").split("/"):
+        value = segment.encode()
+        delta = COAP_OPTION_URI_PATH - last
+        last = COAP_OPTION_URI_PATH
+        if len(value) < 13:
+            options += bytes([(delta << 4) | len(value)]) + value
+        else:
+            options += bytes([(delta << 4) | 13, len(value) - 13]) + value
+    return header + token + options
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def run_rate(sockets, address, path, rate, duration, timeout):
+    interval = 1.0 / rate
+    pending = {}
+    latencies = []
+    sent = 0
+
+    start = time.monotonic()
+    next_send = start
+    end = start + duration
+
+    while True:
+        now = time.monotonic()
+        if now >= end and (not pending or now >= end + timeout):
+            break
+
+        if now >= next_send and now < end:
+            sock = sockets[sent % len(sockets)]
+            message_id = (os.getpid() + sent) & 0xFFFF
+            token = struct.pack("!I", sent)
+            sock.sendto(encode_get(message_id, token, path), address)
+            pending[(sock.fileno(), token)] = now
+            sent += 1
+            next_send += interval
+
+        wait = max(0.0, min(next_send, end + timeout) - time.monotonic())
+        readable, _, _ = select.select(sockets, [], [], wait)
+        for sock in readable:
+            data = sock.recv(2048)
+            token = data[4:4 + (data[0] & 0x0F)]
+            sent_at = pending.pop((sock.fileno(), token), None)
+            if sent_at is not None:
+                latencies.append(time.monotonic() - sent_at)
+
+        now = time.monotonic()
+        for key in [k for k, t in pending.items() if now - t > timeout]:
+            del pending[key]
+
+    answered = len(latencies)
+    return {
+        "rate": rate,
+        "sent": sent,
+        "answered": answered,
+        "throughput": answered / duration,
+        "drop": 100.0 * (sent - answered) / sent if sent else 0.0,
+        "p50": percentile(latencies, 50) * 1000,
+        "p99": percentile(latencies, 99) * 1000,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("--port", type=int, default=COAP_PORT)
+    parser.add_argument("--path", default="temperature")
+    parser.add_argument("--rates", type=float, nargs="+", default=[5, 10, 20, 50, 100, 200])
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per rate")
+    parser.add_argument("--timeout", type=float, default=2.0, help="seconds before a request counts as dropped")
+    args = parser.parse_args()
+
+    sockets = []
+    for _ in range(args.clients):
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.setblocking(False)
+        sockets.append(sock)
+
+    address = (args.host, args.port)
+    print("%8s %8s %8s %10s %7s %8s %8s" % ("req/s", "sent", "answered", "answers/s", "drop%", "p50 ms", "p99 ms"))
+    for rate in args.rates:
+        r = run_rate(sockets, address, args.path, rate, args.duration, args.timeout)
+        print("%8.1f %8d %8d %10.1f %7.1f %8.1f %8.1f" % (
+            r["rate"], r["sent"], r["answered"], r["throughput"], r["drop"], r["p50"], r["p99"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""Rasterizes the display icons into 1-bit sprites stored in flash.
+
+The shapes are drawn with the same integer algorithms Adafruit_GFX uses for
+fillRect, fillCircle and fillTriangle, so the sprites match the primitive
+drawing pixel for pixel. Run after changing an icon:
+
+    python3 tools/generate_icons.py
+
+It rewrites include/CarrierGfxIcons.h and src/CarrierGfxIcons.cpp and prints
+the SPI traffic of both drawing methods.
+"""
+
+import os
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+HEADER = os.path.join(ROOT, "include", "CarrierGfxIcons.h")
+SOURCE = os.path.join(ROOT, "src", "CarrierGfxIcons.cpp")
+
+# Window setup per SPI transfer on the ST7789: CASET + 4, RASET + 4, RAMWR
+ST7789_WINDOW_BYTES = 11
+
+
+def cdiv(a, b):
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+class Canvas:
+    def __init__(self, width, height):
+        self.width = width
+        self.height = height
+        self.pixels = [[0] * width for _ in range(height)]
+        self.windows = 0
+        self.pushed = 0
+
+    def hline(self, x, y, w, on):
+        self.rect(x, y, w, 1, on)
+
+    def vline(self, x, y, h, on):
+        self.rect(x, y, 1, h, on)
+
+    def rect(self, x, y, w, h, on):
+        if w <= 0 or h <= 0:
+            return
+        self.windows += 1
+        self.pushed += w * h
+        for j in range(y, y + h):
+            for i in range(x, x + w):
+                if 0 <= i < self.width and 0 <= j < self.height:
+                    self.pixels[j][i] = on
+
+    def circle_helper(self, x0, y0, r, corners, delta, on):
+        f = 1 - r
+        ddf_x = 1
+        ddf_y = -2 * r
+        x = 0
+        y = r
+        px = x
+        py = y
+        delta += 1
+        while x < y:
+            if f >= 0:
+                y -= 1
+                ddf_y += 2
+                f += ddf_y
+            x += 1
+            ddf_x += 2
+            f += ddf_x
+            if x < y + 1:
+                if corners & 1:
+                    self.vline(x0 + x, y0 - y, 2 * y + delta, on)
+                if corners & 2:
+                    self.vline(x0 - x, y0 - y, 2 * y + delta, on)
+            if y != py:
+                if corners & 1:
+                    self.vline(x0 + py, y0 - px, 2 * px + delta, on)
+                if corners & 2:
+                    self.vline(x0 - py, y0 - px, 2 * px + delta, on)
+                py = y
+            px = x
+
+    def circle(self, x0, y0, r, on):
+        self.vline(x0, y0 - r, 2 * r + 1, on)
+        self.circle_helper(x0, y0, r, 3, 0, on)
+
+    def triangle(self, x0, y0, x1, y1, x2, y2, on):
+        if y0 > y1:
+            x0, y0, x1, y1 = x1, y1, x0, y0
+        if y1 > y2:
+            x1, y1, x2, y2 = x2, y2, x1, y1
+        if y0 > y1:
+            x0, y0, x1, y1 = x1, y1, x0, y0
+
+        if y0 == y2:
+            a = b = x0
+            if x1 < a:
+                a = x1
+            elif x1 > b:
+                b = x1
+            if x2 < a:
+                a = x2
+            elif x2 > b:
+                b = x2
+            self.hline(a, y0, b - a + 1, on)
+            return
+
+        dx01, dy01 = x1 - x0, y1 - y0
+        dx02, dy02 = x2 - x0, y2 - y0
+        dx12, dy12 = x2 - x1, y2 - y1
+        sa = sb = 0
+        last = y1 if y1 == y2 else y1 - 1
+
+        y = y0
+        while y <= last:
+            a = x0 + cdiv(sa, dy01)
+            b = x0 + cdiv(sb, dy02)
+            sa += dx01
+            sb += dx02
+            if a > b:
+                a, b = b, a
+            self.hline(a, y, b - a + 1, on)
+            y += 1
+
+        sa = dx12 * (y - y1)
+        sb = dx02 * (y - y0)
+        while y <= y2:
+            a = x1 + cdiv(sa, dy12)
+            b = x0 + cdiv(sb, dy02)
+            sa += dx12
+            sb += dx02
+            if a > b:
+                a, b = b, a
+            self.hline(a, y, b - a + 1, on)
+            y += 1
+
+
+# Same shapes as the original primitive drawing, with the icon origin at 0, 0.
+# 1 is the icon color, 0 the black cut-outs.
+
+def thermometer(c):
+    c.circle(15, 10, 10, 1)
+    c.rect(5, 10, 21, 28, 1)
+    c.circle(15, 45, 15, 1)
+    c.circle(15, 10, 7, 0)
+    c.rect(8, 13, 15, 25, 0)
+    c.circle(15, 45, 12, 0)
+
+
+def droplet(c):
+    c.triangle(2, 30, 20, 0, 38, 30, 1)
+    c.circle(20, 40, 20, 1)
+    c.triangle(6, 30, 20, 5, 34, 30, 0)
+    c.circle(20, 40, 17, 0)
+
+
+def movement(c):
+    c.triangle(20, 15, 30, 0, 40, 15, 1)
+    c.triangle(25, 12, 30, 5, 35, 12, 0)
+    c.triangle(0, 30, 15, 20, 15, 40, 1)
+    c.triangle(5, 30, 12, 25, 12, 35, 0)
+    c.triangle(20, 45, 40, 45, 30, 60, 1)
+    c.triangle(25, 48, 35, 48, 30, 55, 0)
+    c.triangle(45, 40, 45, 20, 60, 30, 1)
+    c.triangle(48, 35, 48, 25, 55, 30, 0)
+    c.rect(15, 25, 30, 10, 1)
+    c.rect(25, 15, 10, 30, 1)
+    c.rect(12, 28, 36, 4, 0)
+    c.rect(28, 12, 4, 36, 0)
+
+
+def rotation(c):
+    c.circle(30, 30, 27, 1)
+    c.circle(30, 30, 24, 0)
+    c.circle(30, 30, 20, 1)
+    c.circle(30, 30, 17, 0)
+    c.triangle(0, 0, 30, 0, 30, 30, 0)
+    c.triangle(15, 7, 30, 0, 30, 15, 1)
+    c.triangle(22, 7, 27, 5, 27, 10, 0)
+    c.rect(27, 6, 4, 4, 0)
+    c.triangle(12, 12, 17, 17, 12, 15, 1)
+    c.circle(30, 30, 5, 1)
+    c.circle(30, 30, 2, 0)
+
+
+def pressure(c):
+    c.rect(0, 50, 60, 10, 1)
+    c.triangle(5, 35, 25, 35, 15, 50, 1)
+    c.triangle(35, 35, 55, 35, 45, 50, 1)
+    c.rect(10, 0, 10, 35, 1)
+    c.rect(40, 0, 10, 35, 1)
+    c.rect(3, 53, 54, 4, 0)
+    c.triangle(10, 38, 20, 38, 15, 45, 0)
+    c.triangle(40, 38, 50, 38, 45, 45, 0)
+    c.rect(13, 3, 4, 35, 0)
+    c.rect(43, 3, 4, 35, 0)
+
+
+ICONS = [
+    ("THERMOMETER", thermometer, 31, 61),
+    ("DROPLET", droplet, 41, 61),
+    ("MOVEMENT", movement, 61, 61),
+    ("ROTATION", rotation, 58, 58),
+    ("PRESSURE", pressure, 60, 60),
+]
+
+
+def pack(canvas):
+    data = []
+    for row in canvas.pixels:
+        for start in range(0, canvas.width, 8):
+            byte = 0
+            for bit, on in enumerate(row[start:start + 8]):
+                byte |= on << (7 - bit)
+            data.append(byte)
+    return data
+
+
+def main():
+    header = ["#pragma once\n\n", "// Generated by tools/generate_icons.py, do not edit\n\n\n",
+              "#include <Arduino.h>\n\n\n"]
+    source = ["// Generated by tools/generate_icons.py, do not edit\n\n",
+              "#include \"CarrierGfxIcons.h\"\n\n\n"]
+
+    for name, draw, width, height in ICONS:
+        header.append("#define GFX_%s_WIDTH %d\n" % (name, width))
+        header.append("#define GFX_%s_HEIGHT %d\n" % (name, height))
+    header.append("\n\n")
+
+    total_primitive = total_sprite = 0
+    for name, draw, width, height in ICONS:
+        canvas = Canvas(width, height)
+        draw(canvas)
+        data = pack(canvas)
+
+        header.append("extern const uint8_t GFX_%s_BITMAP[];\n" % name)
+
+        source.append("const uint8_t GFX_%s_BITMAP[] PROGMEM = {\n" % name)
+        stride = (width + 7) // 8
+        for row in range(height):
+            line = data[row * stride:(row + 1) * stride]
+            source.append("    " + ", ".join("0x%02X" % b for b in line) + ",\n")
+        source.append("};\n\n")
+
+        primitive = canvas.windows * ST7789_WINDOW_BYTES + canvas.pushed * 2
+        sprite = ST7789_WINDOW_BYTES + width * height * 2
+        total_primitive += primitive
+        total_sprite += sprite
+        print("%-12s primitives: %4d windows, %6d SPI bytes | sprite: 1 window, %6d SPI bytes"
+              % (name.lower(), canvas.windows, primitive, sprite))
+
+    print("%-12s primitives: %6d SPI bytes | sprites: %6d SPI bytes" % ("total", total_primitive, total_sprite))
+
+    with open(HEADER, "w") as out:
+        out.write("".join(header))
+    with open(SOURCE, "w") as out:
+        out.write("".join(source).rstrip("\n") + "\n")
+
+
+if __name__ == "__main__":
+    main()